@@ -1,17 +1,18 @@
 #version 450
+#extension GL_EXT_nonuniform_qualifier : require
 // Depends on attachment address
 layout(location = 0) out vec4 outColor;
 
 layout (location = 0) in vec3 fragCol;
 layout (location = 1) in vec2 fragTexCoord;
+layout (location = 2) flat in uint fragTextureID;
 
-layout(set = 1, binding = 0) uniform sampler2D TextureSampler;
-//layout(set = 1, binding = 1) uniform sampler2D NormalSampler;
+// Texture table, every loaded texture by ID
+layout(set = 1, binding = 0) uniform sampler2D Textures[];
 
 void main()
 {
-    vec3 albedo = texture(TextureSampler, fragTexCoord).rgb;
-    //vec3 normal = texture(NormalSampler, fragTexCoord).rgb;
+    vec3 albedo = texture(Textures[nonuniformEXT(fragTextureID)], fragTexCoord).rgb;
 
     outColor = vec4(albedo, 1.0);
 }
\ No newline at end of file
@@ -1,12 +1,15 @@
 #version 450
+#extension GL_EXT_nonuniform_qualifier : require
 layout(location = 0) out vec4 outColor;
 
 layout (location = 0) in float elapsedTime;
 layout (location = 1) in float lifeTime;
 layout (location = 2) in vec2 fragTexCoord;
 layout (location = 3) in vec4 fragParticleColor;
+layout (location = 4) flat in uint fragTextureID;
 
-layout(set = 1, binding = 0) uniform sampler2D TextureSampler;
+// Texture table, every loaded texture by ID
+layout(set = 1, binding = 0) uniform sampler2D Textures[];
 
 const float FadeInPercent = 0.1;
 const float FadeOutPercent = 0.1;
@@ -22,6 +25,6 @@ void main(){
 
     float lifePercentage = elapsedTime / lifeTime;
 
-    vec4 textureColor = texture(TextureSampler, fragTexCoord);
+    vec4 textureColor = texture(Textures[nonuniformEXT(fragTextureID)], fragTexCoord);
     outColor = textureColor * fragParticleColor;
 }
\ No newline at end of file
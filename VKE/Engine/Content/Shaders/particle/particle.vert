@@ -19,10 +19,26 @@ layout(set = 0, binding = 0) uniform sFrameData
 	mat4 ViewMatrix;
 	mat4 InvView;
 };
-// Model matrix for all particles
-layout(set = 0, binding = 1) uniform sDrawcallData
+// Model matrix for all particles comes from the emitter's entry
+// Object table, one entry per object
+struct sObject
 {
-    mat4 ModelMatrix;
+    vec4 Rows[3];       // First three rows of the model matrix
+    uint MaterialID;
+    uint Padding0;
+    uint Padding1;
+    uint Padding2;
+};
+layout(std430, set = 2, binding = 0) readonly buffer sObjectTable
+{
+    sObject Objects[];
+};
+
+// Per-draw indices, FDrawConstants on the CPU side
+layout(push_constant) uniform sPushDraw
+{
+    uint ObjectIndex;
+    uint TextureID;     // Slot in the texture table
 };
 
 // VS to FS
@@ -30,6 +46,7 @@ layout (location = 0) out float elapsedTime;
 layout (location = 1) out float lifeTime;
 layout (location = 2) out vec2 fragTexCoord;
 layout (location = 3) out vec4 fragParticleColor;
+layout (location = 4) flat out uint fragTextureID;
 
 void main()
 {
@@ -53,6 +70,9 @@ void main()
 
     fragTexCoord = TexCoord;
     fragParticleColor = particleColor;
+    fragTextureID = TextureID;
+    sObject Object = Objects[ObjectIndex];
+    mat4 ModelMatrix = transpose(mat4(Object.Rows[0], Object.Rows[1], Object.Rows[2], vec4(0.0, 0.0, 0.0, 1.0)));
     // Model matrix for individual quad
     mat4 Model = mat4(1.0);
     Model[3] = vec4(pos.xyz, 1.0);
@@ -3,6 +3,9 @@
 layout (location = 0) in vec3 pos;
 layout (location = 1) in vec3 col;
 layout (location = 2) in vec2 texCoord;
+// Instanced attributes
+layout (location = 3) in uint objectIndex;  // Entry in the object table, visible instances only
+layout (location = 4) in uint textureID;    // Slot in the texture table
 
 // Uniforms buffer
 layout(set = 0, binding = 0) uniform sFrameData
@@ -13,23 +16,30 @@ layout(set = 0, binding = 0) uniform sFrameData
 	mat4 ViewMatrix;
 	mat4 InvView;
 };
-// Dynamic binding
-layout(set = 0, binding = 1) uniform sDrawcallData
+// Object table, one entry per object
+struct sObject
 {
-    mat4 ModelMatrix;
+    vec4 Rows[3];       // First three rows of the model matrix
+    uint MaterialID;
+    uint Padding0;
+    uint Padding1;
+    uint Padding2;
 };
-
-layout(push_constant) uniform sPushModel
+layout(std430, set = 2, binding = 0) readonly buffer sObjectTable
 {
-    mat4 MVP;
+    sObject Objects[];
 };
 
 layout (location = 0) out vec3 fragCol;
 layout (location = 1) out vec2 fragTexCoord;
+layout (location = 2) flat out uint fragTextureID;
 
 void main()
 {
+    sObject Object = Objects[objectIndex];
+    mat4 ModelMatrix = transpose(mat4(Object.Rows[0], Object.Rows[1], Object.Rows[2], vec4(0.0, 0.0, 0.0, 1.0)));
     gl_Position = PVMatrix * ModelMatrix * vec4(pos, 1.0);
     fragCol = col;
     fragTexCoord = texCoord;
+    fragTextureID = textureID;
 }
\ No newline at end of file
@@ -0,0 +1,56 @@
+#version 450
+
+// vert.vert reading its vertices from the geometry arena by gl_VertexIndex instead of through vertex input
+// Instanced attributes
+layout (location = 3) in uint objectIndex;  // Entry in the object table, visible instances only
+layout (location = 4) in uint textureID;    // Slot in the texture table
+
+// Uniforms buffer
+layout(set = 0, binding = 0) uniform sFrameData
+{
+    mat4 PVMatrix;
+	mat4 ProjectionMatrix;
+	mat4 InvProj;
+	mat4 ViewMatrix;
+	mat4 InvView;
+};
+// Object table, one entry per object
+struct sObject
+{
+    vec4 Rows[3];       // First three rows of the model matrix
+    uint MaterialID;
+    uint Padding0;
+    uint Padding1;
+    uint Padding2;
+};
+layout(std430, set = 2, binding = 0) readonly buffer sObjectTable
+{
+    sObject Objects[];
+};
+
+// Vertex buffer of the geometry arena block, FVertex is 8 tightly packed floats (position, color, texture coordinate)
+layout(std430, set = 3, binding = 0) readonly buffer sVertices
+{
+    float Vertices[];
+};
+const uint VERTEX_FLOAT_COUNT = 8;
+
+layout (location = 0) out vec3 fragCol;
+layout (location = 1) out vec2 fragTexCoord;
+layout (location = 2) flat out uint fragTextureID;
+
+void main()
+{
+    // gl_VertexIndex already includes the draw's vertexOffset
+    uint Base = uint(gl_VertexIndex) * VERTEX_FLOAT_COUNT;
+    vec3 pos = vec3(Vertices[Base + 0], Vertices[Base + 1], Vertices[Base + 2]);
+    vec3 col = vec3(Vertices[Base + 3], Vertices[Base + 4], Vertices[Base + 5]);
+    vec2 texCoord = vec2(Vertices[Base + 6], Vertices[Base + 7]);
+
+    sObject Object = Objects[objectIndex];
+    mat4 ModelMatrix = transpose(mat4(Object.Rows[0], Object.Rows[1], Object.Rows[2], vec4(0.0, 0.0, 0.0, 1.0)));
+    gl_Position = PVMatrix * ModelMatrix * vec4(pos, 1.0);
+    fragCol = col;
+    fragTexCoord = texCoord;
+    fragTextureID = textureID;
+}
\ No newline at end of file
@@ -3,7 +3,8 @@
 #include "Utilities.h"
 #include "ComputePass.h"
 #include "ParticleSystem/Emitter.h"
-#include "Descriptors/Descriptor_Buffer.h"
+#include "Material/Material.h"
+#include "Time.h"
 // System
 #include "stdio.h"
 #include "assert.h"
@@ -57,6 +58,43 @@ namespace VKE
 				ImGui::Text("counter = %d", counter);
 
 				ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
+				const Time::FFrameTimeCounter& Counter = Time::FrameTimeCounter;
+				ImGui::Text("Frame %.3f ms (avg %.3f ms), %d frames in flight", Counter.FrameTime, Counter.AverageFrameTime, MAX_FRAME_DRAWS);
+				ImGui::Text("Draw CPU %.3f ms, fence wait %.3f ms", Counter.DrawCPUTime, Counter.FenceWaitTime);
+				const Time::FFixedStepClock& Clock = Time::SimulationClock;
+				ImGui::Text("Simulation %.1f Hz, %d steps this frame, alpha %.2f", 1.0 / Clock.StepTime, Clock.StepsThisFrame, Clock.Alpha);
+
+				Time::FFramePacer& Pacer = Time::FramePacer;
+				const char* PresentModeName = "FIFO";
+				switch (Renderer->GetPresentMode())
+				{
+				case VK_PRESENT_MODE_MAILBOX_KHR: PresentModeName = "Mailbox"; break;
+				case VK_PRESENT_MODE_FIFO_RELAXED_KHR: PresentModeName = "FIFO relaxed"; break;
+				case VK_PRESENT_MODE_IMMEDIATE_KHR: PresentModeName = "Immediate"; break;
+				default: break;
+				}
+				ImGui::Text("Present mode %s, limiter slept %.3f ms", PresentModeName, Pacer.LimiterSleep);
+				ImGui::Text("Input to submit %.3f ms, input to present %.3f ms", Pacer.InputToSubmit, Pacer.InputToPresent);
+				ImGui::Text("Cached command buffer entries recorded: %llu", static_cast<unsigned long long>(Renderer->GetCommandRecordCount()));
+				ImGui::Text("Objects: %d / %d, uploaded this frame: %d", Renderer->GetObjectTable().GetCount(), Renderer->GetObjectTable().GetCapacity(), Renderer->GetObjectTable().GetUploadedCount());
+				ImGui::Text("Model draws: %d instanced draws for %d mesh instances", Renderer->GetInstanceBatcher().GetBatchCount(), Renderer->GetInstanceBatcher().GetInstanceCount());
+				ImGui::Text("Model binds: %d issued, %d skipped, draw sort radix passes: %d", Renderer->GetModelBindCount(), Renderer->GetSkippedModelBindCount(), Renderer->GetInstanceBatcher().GetSortPassCount());
+				ImGui::Text("CPU culling: %d / %d meshes visible", Renderer->GetFrustumCuller().GetVisibleCount(), Renderer->GetFrustumCuller().GetTestedCount());
+				ImGui::Text("GPU culling: %d / %d mesh instances visible", Renderer->GetGpuCulling().GetVisibleCount(), Renderer->GetGpuCulling().GetTestedCount());
+				const FGeometryArenaStats GeometryStats = Renderer->GetGeometryArena().GetStats();
+				ImGui::Text("Geometry arena: %d meshes in %d blocks, vertices %llu / %llu, indices %llu / %llu", GeometryStats.MeshCount, GeometryStats.BlockCount,
+					static_cast<unsigned long long>(GeometryStats.UsedVertices), static_cast<unsigned long long>(GeometryStats.VertexCapacity),
+					static_cast<unsigned long long>(GeometryStats.UsedIndices), static_cast<unsigned long long>(GeometryStats.IndexCapacity));
+				const cFrameArena& Arena = Renderer->GetFrameArena();
+				ImGui::Text("Frame arena: %.1f / %.1f KB, overflows %llu", Arena.GetUsedBytes() / 1024.0f, Arena.GetSlotSize() / 1024.0f, static_cast<unsigned long long>(Arena.GetOverflowCount()));
+				const FDescriptorAllocatorStats DescriptorStats = Renderer->GetDescriptorAllocator().GetStats();
+				ImGui::Text("Descriptor pools: %d, sets: %d / %d, transient: %d / %d", DescriptorStats.PoolCount, DescriptorStats.PersistentSetCount, DescriptorStats.PersistentSetCapacity, DescriptorStats.TransientSetCount, DescriptorStats.TransientSetCapacity);
+				ImGui::Text("Texture table: %d / %d, materials: %d, samplers: %d", Renderer->GetTextureTable().GetRegisteredCount(), Renderer->GetTextureTable().GetCapacity(), cMaterial::GetCount(), Renderer->GetSamplerCache().GetCount());
+				float TargetFPS = static_cast<float>(Pacer.TargetFPS);
+				if (ImGui::SliderFloat("Target FPS (0 = unlimited)", &TargetFPS, 0.0f, 240.0f, "%.0f"))
+				{
+					Pacer.TargetFPS = TargetFPS;
+				}
 				ImGui::End();
 			}
 
@@ -66,7 +104,6 @@ namespace VKE
 
 				ImGui::InputInt("Current Index", &currentParticle);
 				currentParticle = glm::clamp(currentParticle, 0, static_cast<int>(CP->Emitters.size()- 1));
-				bool NeedToUpdateParticle = false;
 				for (size_t i = 0; i < CP->Emitters.size(); ++i)
 				{
 					if (currentParticle != i)
@@ -74,26 +111,55 @@ namespace VKE
 						continue;
 					}
 
-					if (ImGui::SliderFloat("Cone Angle", &CP->Emitters[i].EmitterData.Angle, 0.01f, glm::radians(90.f)))
-					{
-						NeedToUpdateParticle = true;
-					}
-
-					if (ImGui::SliderFloat("Cone Radius", &CP->Emitters[i].EmitterData.Radius, 0.01f, 5.f))
-					{
-						NeedToUpdateParticle = true;
-					}
-
-					if (NeedToUpdateParticle)
-					{
-						CP->Emitters[i].bNeedUpdate = true;
-						CP->Emitters[i].UpdateEmitterData(CP->Emitters[i].ComputeDescriptorSet.GetDescriptorAt<cDescriptor_Buffer>(2));
-					}
+					// Emitter data reaches each frame slot's uniform buffer when the renderer prepares that slot
+					ImGui::SliderFloat("Cone Angle", &CP->Emitters[i].EmitterData.Angle, 0.01f, glm::radians(90.f));
+					ImGui::SliderFloat("Cone Radius", &CP->Emitters[i].EmitterData.Radius, 0.01f, 5.f);
 				}
 				ImGui::End();
 			}
-			
 
+			{
+				ImGui::Begin("Memory");
+				const cMemoryAllocator* Allocator = Renderer->GetMainDevice().MemoryAllocator;
+				const FMemoryStats Stats = Allocator->GetStats();
+				const float MB = 1.0f / (1024.0f * 1024.0f);
+
+				// Device heaps against their budget, red when over
+				FHeapBudget Budgets[VK_MAX_MEMORY_HEAPS];
+				const uint32_t HeapCount = Allocator->GetHeapBudgets(Budgets);
+				ImGui::Text("Heap budgets (%s)", Allocator->HasMemoryBudget() ? "VK_EXT_memory_budget" : "estimated");
+				for (uint32_t i = 0; i < HeapCount; ++i)
+				{
+					const FHeapBudget& Heap = Budgets[i];
+					const ImVec4 Color = Heap.Usage > Heap.Budget ? ImVec4(1.0f, 0.3f, 0.3f, 1.0f) : ImGui::GetStyleColorVec4(ImGuiCol_Text);
+					ImGui::TextColored(Color, "Heap %d%s: %.1f / %.1f MB budget (%.1f MB heap), allocator %.1f MB", static_cast<int>(i), Heap.bDeviceLocal ? " (device local)" : "",
+						Heap.Usage * MB, Heap.Budget * MB, Heap.Size * MB, Heap.AllocatorBytes * MB);
+				}
+				ImGui::Separator();
+
+				ImGui::Text("Device allocations %d, resources %d", Stats.DeviceAllocationCount, Stats.ResourceCount);
+				ImGui::Text("Blocks %.1f MB (%.1f MB used), dedicated %.1f MB, peak %.1f MB", Stats.BlockBytes * MB, Stats.UsedBytes * MB, Stats.DedicatedBytes * MB, Stats.PeakBytes * MB);
+				ImGui::Text("Fragmentation %.1f%% (%.1f MB free, %.1f MB in the largest ranges)", Stats.GetFragmentation() * 100.0f, Stats.FreeBytes * MB, Stats.LargestFreeBytes * MB);
+				ImGui::Separator();
+
+				// Per category
+				ImGui::Columns(4, "MemoryCategories");
+				ImGui::Text("Category"); ImGui::NextColumn();
+				ImGui::Text("Count"); ImGui::NextColumn();
+				ImGui::Text("MB"); ImGui::NextColumn();
+				ImGui::Text("Peak MB"); ImGui::NextColumn();
+				ImGui::Separator();
+				for (size_t i = 0; i < static_cast<size_t>(EMemoryCategory::Count); ++i)
+				{
+					const FMemoryStats::FCategory& Category = Stats.Categories[i];
+					ImGui::Text("%s", GetMemoryCategoryName(static_cast<EMemoryCategory>(i))); ImGui::NextColumn();
+					ImGui::Text("%d", Category.ResourceCount); ImGui::NextColumn();
+					ImGui::Text("%.2f", Category.Bytes * MB); ImGui::NextColumn();
+					ImGui::Text("%.2f", Category.PeakBytes * MB); ImGui::NextColumn();
+				}
+				ImGui::Columns(1);
+				ImGui::End();
+			}
 		}
 
 		void Init(GLFWwindow* Window, VKRenderer* Renderer)
@@ -223,11 +289,12 @@ namespace VKE
 			}
 			for (size_t i = 0; i < wd->ImageCount; ++i)
 			{
+				// Imgui records into the renderer's per-frame command buffer, it owns no command pool / buffer / fence here
 				wd->Frames[i] =
 				{
-					MainDevice.GraphicsCommandPool,
-					Renderer->GetCommandBuffers()[i],
-					Renderer->GetDrawFences()[i],
+					VK_NULL_HANDLE,
+					VK_NULL_HANDLE,
+					VK_NULL_HANDLE,
 					imguiImages[i],
 					imguiImageViews[i],
 					imguiFrameBuffers[i]
@@ -257,31 +324,12 @@ namespace VKE
 
 			// Upload Fonts
 			{
-				// Use any command queue
-				VkCommandPool command_pool = wd->Frames[wd->FrameIndex].CommandPool;
-				VkCommandBuffer command_buffer = wd->Frames[wd->FrameIndex].CommandBuffer;
-
-				VkResult Result = vkResetCommandPool(MainDevice.LD, command_pool, 0);
-				RESULT_CHECK(Result, "Fail to reset Imgui Command pool.\n");
-				VkCommandBufferBeginInfo begin_info = {};
-				begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-				begin_info.flags |= VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-				Result = vkBeginCommandBuffer(command_buffer, &begin_info);
-				RESULT_CHECK(Result, "Fail to begin Imgui Command buffer when uploading fonts.\n");
+				// One-off upload through the upload command pool, waits until the upload finishes
+				VkCommandBuffer command_buffer = BeginCommandBuffer(MainDevice.LD, MainDevice.UploadCommandPool);
 
 				ImGui_ImplVulkan_CreateFontsTexture(command_buffer);
 
-				VkSubmitInfo end_info = {};
-				end_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-				end_info.commandBufferCount = 1;
-				end_info.pCommandBuffers = &command_buffer;
-				Result = vkEndCommandBuffer(command_buffer);
-				RESULT_CHECK(Result, "Fail to end Imgui Command buffer when uploading fonts.\n");
-				Result = vkQueueSubmit(MainDevice.graphicQueue, 1, &end_info, VK_NULL_HANDLE);
-				RESULT_CHECK(Result, "Fail to submit Imgui queue when uploading fonts.\n");
-
-				Result = vkDeviceWaitIdle(MainDevice.LD);
-				RESULT_CHECK(Result, "Fail to wait for queue to idle when uploading fonts.\n");
+				EndCommandBuffer(command_buffer, MainDevice.LD, MainDevice.graphicQueue, MainDevice.UploadCommandPool);
 				ImGui_ImplVulkan_DestroyFontUploadObjects();
 			}
 		}
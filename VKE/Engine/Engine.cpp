@@ -6,12 +6,14 @@
 #include "Camera.h"
 #include "Editor/Editor.h"
 #include "Time.h"
+#include "Job/JobSystem.h"
 // glm
 #include "glm/glm.hpp"
 #include "glm/mat4x4.hpp"
 // Systems
 #include "stdio.h"
 #include <string>
+#include <cstring>
 #include "Model/Model.h"
 
 namespace VKE {
@@ -25,6 +27,9 @@ namespace VKE {
 	VKRenderer* g_Renderer;
 	UserInput::FUserInput* g_Input;
 	cCamera* g_Camera;
+	FLaunchOptions g_LaunchOptions;
+	// Frames rendered in headless mode when neither a frame count nor a time budget is given
+	const uint64_t DEFAULT_HEADLESS_FRAMES = 1000;
 
 	//=================== Function declarations =================== 
 
@@ -42,36 +47,117 @@ namespace VKE {
 	void initCamera();
 	void cleanupCamera();
 
-	int init()
+	// Headless
+	void runHeadless();
+	// Simulation
+	void simulate(double iFrameTime);
+
+	bool ParseLaunchOptions(int argc, char* argv[], FLaunchOptions& oOptions)
+	{
+		for (int i = 1; i < argc; ++i)
+		{
+			if (strcmp(argv[i], "--headless") == 0)
+			{
+				oOptions.bHeadless = true;
+			}
+			else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+			{
+				oOptions.FrameCount = strtoull(argv[++i], nullptr, 10);
+			}
+			else if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc)
+			{
+				oOptions.TimeBudget = atof(argv[++i]);
+			}
+			else if (strcmp(argv[i], "--sim-rate") == 0 && i + 1 < argc)
+			{
+				oOptions.SimulationRate = atof(argv[++i]);
+			}
+			else if (strcmp(argv[i], "--max-sim-steps") == 0 && i + 1 < argc)
+			{
+				oOptions.MaxSimulationSteps = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+			}
+			else if (strcmp(argv[i], "--job-threads") == 0 && i + 1 < argc)
+			{
+				oOptions.JobThreads = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+			}
+			else if (strcmp(argv[i], "--fps") == 0 && i + 1 < argc)
+			{
+				oOptions.TargetFPS = atof(argv[++i]);
+			}
+			else if (strcmp(argv[i], "--present-mode") == 0 && i + 1 < argc)
+			{
+				const char* Mode = argv[++i];
+				if (strcmp(Mode, "mailbox") == 0) { oOptions.PresentMode = EPresentMode::Mailbox; }
+				else if (strcmp(Mode, "fifo") == 0) { oOptions.PresentMode = EPresentMode::Fifo; }
+				else if (strcmp(Mode, "relaxed") == 0) { oOptions.PresentMode = EPresentMode::FifoRelaxed; }
+				else if (strcmp(Mode, "immediate") == 0) { oOptions.PresentMode = EPresentMode::Immediate; }
+				else
+				{
+					printf("Unknown present mode: %s, expected mailbox / fifo / relaxed / immediate\n", Mode);
+					return false;
+				}
+			}
+			else
+			{
+				printf("Unknown argument: %s\nUsage: [--headless] [--frames N] [--seconds S] [--sim-rate Hz] [--max-sim-steps N] [--fps N] [--job-threads N] [--present-mode mailbox|fifo|relaxed|immediate]\n", argv[i]);
+				return false;
+			}
+		}
+		return true;
+	}
+
+	int init(const FLaunchOptions& iOptions)
 	{
 		int result = EXIT_SUCCESS;
-		initGLFW();
+		g_LaunchOptions = iOptions;
+		Time::SimulationClock.SetStepRate(g_LaunchOptions.SimulationRate);
+		Time::SimulationClock.MaxStepsPerFrame = g_LaunchOptions.MaxSimulationSteps;
+		Time::FramePacer.TargetFPS = g_LaunchOptions.TargetFPS;
+		// Before the renderer, it sizes per-thread command pools by the job system's thread count
+		JobSystem::Init(g_LaunchOptions.JobThreads);
+		if (!g_LaunchOptions.bHeadless)
+		{
+			initGLFW();
+		}
 		initInput();
 		initCamera();
 		
 		g_Renderer = DBG_NEW VKRenderer();
+		g_Renderer->SetPreferredPresentMode(g_LaunchOptions.PresentMode);
+		// Null window makes the renderer draw into offscreen targets
 		if (g_Renderer->init(g_Window) == EXIT_FAILURE)
 		{
 			return EXIT_FAILURE;
 		}
-		Editor::Init(g_Window, g_Renderer);
+		if (!g_LaunchOptions.bHeadless)
+		{
+			Editor::Init(g_Window, g_Renderer);
+		}
 
 		return result;
 	}
 
 	void run()
 	{
+		if (g_LaunchOptions.bHeadless)
+		{
+			runHeadless();
+			return;
+		}
 		if (!g_Window)
 		{
 			return;
 		}
 
-		double LastTime = glfwGetTime();
+		double LastTime = Time::Now();
 		while (!glfwWindowShouldClose(g_Window))
 		{
+			// Sleep off the frame limiter before sampling input, not after present, so input is as recent as possible
+			Time::FramePacer.WaitForNextFrame();
+			Time::FramePacer.MarkInput();
 			glfwPollEvents();
 
-			double now = glfwGetTime();
+			double now = Time::Now();
 			Time::DT = now - LastTime;
 			
 			LastTime = now;
@@ -85,22 +171,81 @@ namespace VKE {
 
 				g_Camera->Update();
 
-				g_Renderer->tick((float)Time::DT);
+				simulate(Time::DT);
 				g_Renderer->draw();
 			}
 		}
 	}
 
+	void simulate(double iFrameTime)
+	{
+		// Run as many fixed steps as the elapsed time covers, rendering blends the remainder with SimulationClock.Alpha
+		const uint32_t Steps = Time::SimulationClock.Advance(iFrameTime);
+		for (uint32_t i = 0; i < Steps; ++i)
+		{
+			g_Renderer->fixedTick(static_cast<float>(Time::SimulationClock.StepTime));
+		}
+		g_Renderer->tick(static_cast<float>(iFrameTime));
+	}
+
+	void runHeadless()
+	{
+		uint64_t FrameLimit = g_LaunchOptions.FrameCount;
+		const double TimeBudget = g_LaunchOptions.TimeBudget;
+		if (FrameLimit == 0 && TimeBudget <= 0.0)
+		{
+			FrameLimit = DEFAULT_HEADLESS_FRAMES;
+		}
+		printf("Headless run: frame limit %llu, time budget %.2f s\n", static_cast<unsigned long long>(FrameLimit), TimeBudget);
+
+		const double StartTime = Time::Now();
+		double LastTime = StartTime;
+		uint64_t Frames = 0;
+		while ((FrameLimit == 0 || Frames < FrameLimit) && (TimeBudget <= 0.0 || LastTime - StartTime < TimeBudget))
+		{
+			Time::FramePacer.WaitForNextFrame();
+			Time::FramePacer.MarkInput();
+			double now = Time::Now();
+			Time::DT = now - LastTime;
+			LastTime = now;
+
+			// No input to poll, the camera stays where it is
+			g_Camera->Update();
+
+			simulate(Time::DT);
+			g_Renderer->draw();
+			++Frames;
+		}
+		// Include the GPU work of the last frames in the measurement
+		vkDeviceWaitIdle(g_Renderer->GetMainDevice().LD);
+
+		const double Elapsed = Time::Now() - StartTime;
+		printf("Headless run finished: %llu frames in %.3f s, avg %.3f ms/frame (%.1f FPS)\n",
+			static_cast<unsigned long long>(Frames), Elapsed,
+			Frames > 0 ? Elapsed * 1000.0 / Frames : 0.0,
+			Elapsed > 0.0 ? Frames / Elapsed : 0.0);
+		printf("Simulation: %llu fixed steps at %.1f Hz, %.3f s dropped by the catch-up limit\n",
+			static_cast<unsigned long long>(Time::SimulationClock.TotalSteps), 1.0 / Time::SimulationClock.StepTime, Time::SimulationClock.DroppedTime);
+		printf("Latency: frame start to submit %.3f ms\n", Time::FramePacer.InputToSubmit);
+	}
+
 	void cleanup()
 	{
-		Editor::CleanUp(g_Renderer);
+		if (!g_LaunchOptions.bHeadless)
+		{
+			Editor::CleanUp(g_Renderer);
+		}
 
 		g_Renderer->cleanUp();
 		safe_delete(g_Renderer);
 
 		cleanupCamera();
 		cleanupInput();
-		cleanupGLFW();
+		JobSystem::CleanUp();
+		if (!g_LaunchOptions.bHeadless)
+		{
+			cleanupGLFW();
+		}
 	}
 
 
@@ -114,6 +259,11 @@ namespace VKE {
 		return g_Camera;
 	}
 
+	bool IsHeadless()
+	{
+		return g_LaunchOptions.bHeadless;
+	}
+
 	glm::ivec2 GetWindowExtent()
 	{
 		return glm::ivec2(WIDTH, HEIGHT);
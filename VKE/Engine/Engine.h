@@ -11,7 +11,30 @@ namespace VKE
 {
 	class cCamera;
 
-	int init();
+	// How swap chain images are presented, trades latency against throughput / tearing
+	enum class EPresentMode : uint8_t
+	{
+		Mailbox,		// Low latency without tearing, newest image replaces the queued one (default)
+		Fifo,			// V-Sync, always supported
+		FifoRelaxed,	// V-Sync, tears instead of waiting when a frame is late
+		Immediate,		// No V-Sync, lowest latency, tears
+	};
+
+	// Command line options, e.g. "--headless --frames 600" or "--headless --seconds 10"
+	struct FLaunchOptions
+	{
+		bool bHeadless = false;			// Render offscreen without window / swap chain / editor
+		uint64_t FrameCount = 0;		// Headless: stop after this many frames, 0 means no limit
+		double TimeBudget = 0.0;		// Headless: stop after this many seconds, 0 means no limit
+		double SimulationRate = 60.0;	// Fixed simulation steps per second
+		uint32_t MaxSimulationSteps = 5;	// Max fixed steps to catch up in one rendered frame
+		EPresentMode PresentMode = EPresentMode::Mailbox;
+		double TargetFPS = 0.0;			// Frame limiter, 0 means unlimited
+		uint32_t JobThreads = 0;		// Job system workers, 0 means one per hardware thread except the main thread
+	};
+	bool ParseLaunchOptions(int argc, char* argv[], FLaunchOptions& oOptions);
+
+	int init(const FLaunchOptions& iOptions = FLaunchOptions());
 
 	void run();
 
@@ -22,6 +45,7 @@ namespace VKE
 	glm::ivec2 GetWindowExtent();
 
 	glm::vec2 GetMouseDelta();
+	bool IsHeadless();
 	extern uint64_t ElapsedFrame;
 	extern bool bWindowIconified;
 }
\ No newline at end of file
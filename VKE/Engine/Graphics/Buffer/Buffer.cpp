@@ -3,57 +3,74 @@
 namespace VKE
 {
 
-	bool cBuffer::CreateBufferAndAllocateMemory(VkPhysicalDevice PD, VkDevice LD, VkDeviceSize BufferSize, VkBufferUsageFlags Flags, VkMemoryPropertyFlags Properties)
+	bool cBuffer::CreateBufferAndAllocateMemory(FMainDevice* iMainDevice, VkDeviceSize BufferSize, VkBufferUsageFlags Flags, VkMemoryPropertyFlags Properties, EMemoryCategory Category, const std::vector<uint32_t>& SharingQueueFamilies, EMemoryStrategy Strategy)
 	{
 		MemorySize = BufferSize;
-		LogicalDevice = LD;
+		LogicalDevice = iMainDevice->LD;
+		pAllocator = iMainDevice->MemoryAllocator;
 		// info to create vertex buffer, not assigning memory
 		VkBufferCreateInfo BufferCreateInfo = {};
 		BufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
 		BufferCreateInfo.size = BufferSize;
 		BufferCreateInfo.usage = Flags;											// Multiple types of buffer possible, vertex buffer here
 		BufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;					// only one using in a time, similar to swap chain images
+		if (SharingQueueFamilies.size() > 1)
+		{
+			// Accessed by multiple queue families at the same time
+			BufferCreateInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+			BufferCreateInfo.queueFamilyIndexCount = static_cast<uint32_t>(SharingQueueFamilies.size());
+			BufferCreateInfo.pQueueFamilyIndices = SharingQueueFamilies.data();
+		}
 
-		VkResult Result = vkCreateBuffer(LD, &BufferCreateInfo, nullptr, &Buffer);
+		VkResult Result = vkCreateBuffer(LogicalDevice, &BufferCreateInfo, nullptr, &Buffer);
 		RESULT_CHECK(Result, "Fail to create buffer.");
 		if (Result != VK_SUCCESS)
 		{
 			return false;
 		}
 
-		// Get buffer memory requirements
-		VkMemoryRequirements MemRequirements;
-		vkGetBufferMemoryRequirements(LD, Buffer, &MemRequirements);
-
-		// Allocate memory to buffer
-		VkMemoryAllocateInfo MemAllocInfo = {};
-		MemAllocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		MemAllocInfo.allocationSize = MemRequirements.size;
-		MemAllocInfo.memoryTypeIndex = FindMemoryTypeIndex(
-			PD,
-			MemRequirements.memoryTypeBits,				// Index of memory type on Physical Device that has required bit flags
-			Properties									// Memory property, is this local_bit or host_bit or others
-		);
-
-		// Allocate memory to VKDevieMemory
-		Result = vkAllocateMemory(LD, &MemAllocInfo, nullptr, &Memory);
-		RESULT_CHECK(Result, "Fail to allocate memory for buffer.");
-		if (Result != VK_SUCCESS)
+		// Sub-allocate memory from the allocator and bind it with the buffer, need to free memory
+		if (!pAllocator->AllocateForBuffer(Buffer, Properties, Strategy, Category, Memory))
 		{
+			vkDestroyBuffer(LogicalDevice, Buffer, nullptr);
+			Buffer = VK_NULL_HANDLE;
 			return false;
 		}
 
-		// Bind memory with given vertex buffer, need to free memory
-		vkBindBufferMemory(LD, Buffer, Memory, 0);
-
 		return true;
 	}
 
 	void cBuffer::cleanUp()
 	{
-		vkDestroyBuffer(LogicalDevice, Buffer, nullptr);
-		vkFreeMemory(LogicalDevice, Memory, nullptr);
+		if (Buffer != VK_NULL_HANDLE)
+		{
+			vkDestroyBuffer(LogicalDevice, Buffer, nullptr);
+			Buffer = VK_NULL_HANDLE;
+		}
+		if (pAllocator)
+		{
+			pAllocator->Free(Memory);
+		}
 	}
 
-}
+	void* cBuffer::Map()
+	{
+		return pAllocator->Map(Memory);
+	}
 
+	void cBuffer::Unmap()
+	{
+		pAllocator->Unmap(Memory);
+	}
+
+	void cBuffer::Flush(VkDeviceSize Offset, VkDeviceSize Size)
+	{
+		pAllocator->Flush(Memory, Offset, Size);
+	}
+
+	void cBuffer::Invalidate(VkDeviceSize Offset, VkDeviceSize Size)
+	{
+		pAllocator->Invalidate(Memory, Offset, Size);
+	}
+
+}
@@ -5,9 +5,12 @@
 #pragma once
 #define GLFW_INCLUDE_VULKAN
 #include "GLFW/glfw3.h"
+#include <vector>
+#include "Memory/MemoryAllocator.h"
 
 namespace VKE
 {
+	struct FMainDevice;
 	class cBuffer
 	{
 	public:
@@ -15,19 +18,32 @@ namespace VKE
 		~cBuffer() {};
 
 		// Create buffer and allocate memory for any specific usage type of buffer
-		bool CreateBufferAndAllocateMemory(VkPhysicalDevice PD, VkDevice LD, VkDeviceSize BufferSize, VkBufferUsageFlags Flags, VkMemoryPropertyFlags Properties);
+		// When more than one queue family is given, the buffer is shared concurrently by those families and needs no ownership transfer
+		// Strategy: EMemoryStrategy::Linear for staging buffers that are freed right after the copy
+		// Category: what the memory is accounted to in the allocator's statistics
+		bool CreateBufferAndAllocateMemory(FMainDevice* iMainDevice, VkDeviceSize BufferSize, VkBufferUsageFlags Flags, VkMemoryPropertyFlags Properties, EMemoryCategory Category, const std::vector<uint32_t>& SharingQueueFamilies = {}, EMemoryStrategy Strategy = EMemoryStrategy::Buddy);
 		void cleanUp();
 
+		// Host visible buffers only, the memory may be shared with other buffers so never map it directly
+		void* Map();
+		void Unmap();
+		// Needed after CPU writes unless the memory is host coherent, Offset is relative to the buffer
+		void Flush(VkDeviceSize Offset, VkDeviceSize Size);
+		// Needed before CPU reads of GPU writes unless the memory is host coherent
+		void Invalidate(VkDeviceSize Offset, VkDeviceSize Size);
+
 		const VkBuffer& GetvkBuffer() const { return Buffer; }
-		const VkBuffer& GetMemory() const { return Memory; }
+		const VkDeviceMemory& GetMemory() const { return Memory.Memory; }
+		const FMemoryAllocation& GetAllocation() const { return Memory; }
 		const VkDevice& GetDevice() const { return LogicalDevice; }
 		VkDeviceSize BufferSize() const { return MemorySize; }
 
 	protected:
-		VkDevice LogicalDevice;
-		VkBuffer Buffer;
-		VkDeviceMemory Memory;
-		VkDeviceSize MemorySize;
+		VkDevice LogicalDevice = VK_NULL_HANDLE;
+		cMemoryAllocator* pAllocator = nullptr;
+		VkBuffer Buffer = VK_NULL_HANDLE;
+		FMemoryAllocation Memory;
+		VkDeviceSize MemorySize = 0;
 	};
 
 
@@ -4,7 +4,7 @@
 namespace VKE
 {
 
-	bool cImageBuffer::init(FMainDevice* iMainDevice, uint32_t Width, uint32_t Height, VkFormat Format, VkImageTiling Tiling,  VkImageUsageFlags UseFlags, VkMemoryPropertyFlags PropFlags, VkImageAspectFlags AspectFlags)
+	bool cImageBuffer::init(FMainDevice* iMainDevice, uint32_t Width, uint32_t Height, VkFormat Format, VkImageTiling Tiling,  VkImageUsageFlags UseFlags, VkMemoryPropertyFlags PropFlags, VkImageAspectFlags AspectFlags, EMemoryCategory Category)
 	{
 		pMainDevice = iMainDevice;
 		if (pMainDevice == nullptr)
@@ -14,7 +14,7 @@ namespace VKE
 		}
 		
 		ImageFormat = Format;
-		if (!CreateImage(pMainDevice, Width, Height, ImageFormat, Tiling, UseFlags, PropFlags, Image, Memory))
+		if (!CreateImage(pMainDevice, Width, Height, ImageFormat, Tiling, UseFlags, PropFlags, Category, Image, Memory))
 		{
 			return false;
 		}
@@ -29,7 +29,7 @@ namespace VKE
 		{
 			vkDestroyImageView(pMainDevice->LD, ImageView, nullptr);
 			vkDestroyImage(pMainDevice->LD, Image, nullptr);
-			vkFreeMemory(pMainDevice->LD, Memory, nullptr);
+			pMainDevice->MemoryAllocator->Free(Memory);
 		}
 
 	}
@@ -7,6 +7,7 @@
 #pragma once
 #define GLFW_INCLUDE_VULKAN
 #include "GLFW/glfw3.h"
+#include "Memory/MemoryAllocator.h"
 
 namespace VKE
 {
@@ -22,13 +23,13 @@ namespace VKE
 		cImageBuffer& operator = (const cImageBuffer& i_other) = delete;
 		cImageBuffer& operator = (cImageBuffer&& i_other) = delete;
 
-		bool init(FMainDevice* iMainDevice, uint32_t Width, uint32_t Height, VkFormat Format, VkImageTiling Tiling, VkImageUsageFlags UseFlags, VkMemoryPropertyFlags PropFlags, VkImageAspectFlags AspectFlags);
+		bool init(FMainDevice* iMainDevice, uint32_t Width, uint32_t Height, VkFormat Format, VkImageTiling Tiling, VkImageUsageFlags UseFlags, VkMemoryPropertyFlags PropFlags, VkImageAspectFlags AspectFlags, EMemoryCategory Category);
 		void cleanUp();
 
 		// Getters
 		const VkImageView& GetImageView() const { return ImageView; }
 		const VkImage&  GetImage() const { return Image; }
-		const VkDeviceMemory&  GetImageMemory() const { return Memory; }
+		const FMemoryAllocation&  GetImageMemory() const { return Memory; }
 		const VkFormat& GetFormat() const { return ImageFormat; }
 	private:
 		FMainDevice* pMainDevice;
@@ -37,7 +38,7 @@ namespace VKE
 		VkFormat ImageFormat;
 		// Components of an image buffer
 		VkImage Image;
-		VkDeviceMemory Memory;
+		FMemoryAllocation Memory;
 		VkImageView ImageView;
 	};
 }
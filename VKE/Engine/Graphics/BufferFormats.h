@@ -1,5 +1,6 @@
 #pragma once
 #include "glm/glm.hpp"
+#include <stdint.h>
 namespace VKE
 {
 	namespace BufferFormats
@@ -35,16 +36,70 @@ namespace VKE
 			}
 		};
 
-		/** Data update per drawcall */
-		struct FDrawCall
+		/** Per-object data in the object table, std430 layout matching sObject in the shaders */
+		struct FObjectData
 		{
-			glm::mat4 ModelMatrix = glm::mat4(1.0f);
+			glm::vec4 Rows[3];							// First three rows of the model matrix, the last one is always (0, 0, 0, 1)
+			uint32_t MaterialID = 0;
+			uint32_t Padding[3] = { 0, 0, 0 };			// Keep 16 byte stride, zeroed so objects can be compared with memcmp
 
-			FDrawCall() = default;
-			FDrawCall(const glm::mat4& i_model)
+			FObjectData()
 			{
-				ModelMatrix = i_model;
+				Rows[0] = glm::vec4(1, 0, 0, 0);
+				Rows[1] = glm::vec4(0, 1, 0, 0);
+				Rows[2] = glm::vec4(0, 0, 1, 0);
 			}
+			FObjectData(const glm::mat4& i_model, uint32_t i_materialID)
+			{
+				// glm is column major
+				for (int r = 0; r < 3; ++r)
+				{
+					Rows[r] = glm::vec4(i_model[0][r], i_model[1][r], i_model[2][r], i_model[3][r]);
+				}
+				MaterialID = i_materialID;
+			}
+		};
+
+		/** Per-draw push constant of emitters, matching sPushDraw in the shaders, models read theirs per instance */
+		struct FDrawConstants
+		{
+			uint32_t ObjectIndex = 0;					// Entry in the object table
+			uint32_t TextureID = 0;						// Slot in the texture table
+		};
+
+		/** Per-instance vertex data of instanced model draws, written by the culling shader for visible instances */
+		struct FInstanceData
+		{
+			uint32_t ObjectIndex = 0;					// Entry in the object table
+			uint32_t TextureID = 0;						// Slot in the texture table, from the batch's material
+		};
+
+		/** Mesh instance to cull, matching sCullInstance in cull.comp */
+		struct FCullInstance
+		{
+			uint32_t ObjectIndex = 0;					// Entry in the object table
+			uint32_t BatchIndex = 0;					// Draw batch the instance belongs to
+		};
+
+		/** Per-batch culling data, std430 layout matching sCullBatch in cull.comp */
+		struct FCullBatch
+		{
+			glm::vec4 BoundsCenter = glm::vec4(0.0f);	// Local space bounding box of the mesh, w unused
+			glm::vec4 BoundsExtent = glm::vec4(0.0f);
+			uint32_t IndexCount = 0;					// Index range of the mesh in its geometry arena block
+			uint32_t FirstIndex = 0;
+			int32_t VertexOffset = 0;
+			uint32_t FirstInstance = 0;					// Visible instances of the batch are packed from here
+			uint32_t TextureID = 0;
+			uint32_t Padding[3] = { 0, 0, 0 };
+		};
+
+		/** Culling push constant, matching sPushCull in cull.comp */
+		struct FCullConstants
+		{
+			glm::vec4 FrustumPlanes[6];					// xyz: normal pointing inside, w: distance, world space
+			uint32_t InstanceCount = 0;
+			uint32_t Padding[3] = { 0, 0, 0 };
 		};
 
 		/** Particle Data */
@@ -0,0 +1,85 @@
+#include "CommandAllocator.h"
+#include "Utilities.h"
+
+#include <stdexcept>
+#include "assert.h"
+
+namespace VKE
+{
+	bool cCommandAllocator::init(FMainDevice* iMainDevice, uint32_t iQueueFamilyIndex, uint32_t iFrameCount, uint32_t iThreadCount)
+	{
+		assert(iMainDevice && iFrameCount > 0 && iThreadCount > 0);
+		pMainDevice = iMainDevice;
+		FrameCount = iFrameCount;
+		ThreadCount = iThreadCount;
+
+		VkCommandPoolCreateInfo PoolCreateInfo = {};
+		PoolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		PoolCreateInfo.queueFamilyIndex = iQueueFamilyIndex;
+		PoolCreateInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;		// Short-lived buffers, no individual reset, the whole pool is reset in one go
+
+		Pools.resize(FrameCount * ThreadCount);
+		for (size_t i = 0; i < Pools.size(); ++i)
+		{
+			VkResult Result = vkCreateCommandPool(pMainDevice->LD, &PoolCreateInfo, nullptr, &Pools[i].Pool);
+			RESULT_CHECK_ARGS(Result, "Fail to create transient command pool[%d]", static_cast<int>(i));
+			if (Result != VK_SUCCESS)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void cCommandAllocator::cleanUp()
+	{
+		for (auto& Pool : Pools)
+		{
+			// Destroying the pool frees all command buffers allocated from it
+			vkDestroyCommandPool(pMainDevice->LD, Pool.Pool, nullptr);
+		}
+		Pools.clear();
+	}
+
+	void cCommandAllocator::ResetFrame(uint32_t FrameIndex)
+	{
+		assert(FrameIndex < FrameCount);
+		for (uint32_t i = 0; i < ThreadCount; ++i)
+		{
+			FCommandPool& Pool = Pools[FrameIndex * ThreadCount + i];
+			if (Pool.UsedCount[0] == 0 && Pool.UsedCount[1] == 0)
+			{
+				continue;
+			}
+			// All command buffers of the pool go back to initial state, memory is kept for the next recording
+			VkResult Result = vkResetCommandPool(pMainDevice->LD, Pool.Pool, 0);
+			RESULT_CHECK(Result, "Fail to reset transient command pool");
+			Pool.UsedCount[0] = 0;
+			Pool.UsedCount[1] = 0;
+		}
+	}
+
+	VkCommandBuffer cCommandAllocator::Allocate(uint32_t FrameIndex, uint32_t ThreadIndex, VkCommandBufferLevel Level)
+	{
+		assert(FrameIndex < FrameCount && ThreadIndex < ThreadCount);
+		FCommandPool& Pool = Pools[FrameIndex * ThreadCount + ThreadIndex];
+		std::vector<VkCommandBuffer>& CommandBuffers = Pool.CommandBuffers[Level];
+		uint32_t& UsedCount = Pool.UsedCount[Level];
+
+		// Allocate a new one only when all previously allocated command buffers are in use
+		if (UsedCount == CommandBuffers.size())
+		{
+			VkCommandBufferAllocateInfo cbAllocInfo = {};
+			cbAllocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			cbAllocInfo.commandPool = Pool.Pool;
+			cbAllocInfo.level = Level;
+			cbAllocInfo.commandBufferCount = 1;
+
+			VkCommandBuffer CommandBuffer = VK_NULL_HANDLE;
+			VkResult Result = vkAllocateCommandBuffers(pMainDevice->LD, &cbAllocInfo, &CommandBuffer);
+			RESULT_CHECK(Result, "Fail to allocate transient command buffer.");
+			CommandBuffers.push_back(CommandBuffer);
+		}
+		return CommandBuffers[UsedCount++];
+	}
+}
@@ -0,0 +1,50 @@
+/*
+	CommandAllocator hands out command buffers for per-frame recording
+	One transient command pool per frame slot and per recording thread,
+	all pools of a frame slot are reset together once the slot's GPU work is finished
+	Asset uploads should use cUploadContext instead
+*/
+#pragma once
+#define GLFW_INCLUDE_VULKAN
+#include "GLFW/glfw3.h"
+
+#include <vector>
+namespace VKE
+{
+	struct FMainDevice;
+	class cCommandAllocator
+	{
+	public:
+		/* Constructors and destructor*/
+		cCommandAllocator() {}
+		~cCommandAllocator() {}
+		cCommandAllocator(const cCommandAllocator& i_other) = delete;
+		cCommandAllocator& operator = (const cCommandAllocator& i_other) = delete;
+
+		bool init(FMainDevice* iMainDevice, uint32_t iQueueFamilyIndex, uint32_t iFrameCount, uint32_t iThreadCount = 1);
+		void cleanUp();
+
+		// Reset every pool of a frame slot, only valid when the GPU has finished all work recorded from this slot
+		void ResetFrame(uint32_t FrameIndex);
+		// Get a command buffer in initial state, it is valid until the next ResetFrame of the same frame slot
+		// Only the thread of ThreadIndex is allowed to call this function with this ThreadIndex
+		VkCommandBuffer Allocate(uint32_t FrameIndex, uint32_t ThreadIndex = 0, VkCommandBufferLevel Level = VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+
+		uint32_t GetThreadCount() const { return ThreadCount; }
+		uint32_t GetFrameCount() const { return FrameCount; }
+	private:
+		struct FCommandPool
+		{
+			VkCommandPool Pool = VK_NULL_HANDLE;
+			// Command buffers are kept after reset and handed out again in the next frame
+			std::vector<VkCommandBuffer> CommandBuffers[2];		// Indexed by VkCommandBufferLevel
+			uint32_t UsedCount[2] = { 0, 0 };
+		};
+
+		FMainDevice* pMainDevice = nullptr;
+		uint32_t FrameCount = 0;
+		uint32_t ThreadCount = 0;
+		// FrameIndex * ThreadCount + ThreadIndex
+		std::vector<FCommandPool> Pools;
+	};
+}
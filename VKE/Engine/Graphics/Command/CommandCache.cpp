@@ -0,0 +1,44 @@
+#include "CommandCache.h"
+#include "Utilities.h"
+
+#include "assert.h"
+
+namespace VKE
+{
+	bool cCommandCache::init(FMainDevice* iMainDevice, uint32_t iQueueFamilyIndex, uint32_t iEntryCount, uint32_t iThreadCount)
+	{
+		assert(iEntryCount > 0);
+		Entries.clear();
+		Entries.resize(iEntryCount);
+		Version = 1;
+		return Allocator.init(iMainDevice, iQueueFamilyIndex, iEntryCount, iThreadCount);
+	}
+
+	void cCommandCache::cleanUp()
+	{
+		Allocator.cleanUp();
+		Entries.clear();
+	}
+
+	void cCommandCache::BeginRecord(uint32_t Entry)
+	{
+		assert(Entry < Entries.size());
+		Allocator.ResetFrame(Entry);
+		Entries[Entry].CommandBuffers.clear();
+		Entries[Entry].Version = 0;
+	}
+
+	VkCommandBuffer cCommandCache::Allocate(uint32_t Entry, uint32_t ThreadIndex, VkCommandBufferLevel Level)
+	{
+		return Allocator.Allocate(Entry, ThreadIndex, Level);
+	}
+
+	void cCommandCache::EndRecord(uint32_t Entry, const VkCommandBuffer* pCommandBuffers, uint32_t Count)
+	{
+		assert(Entry < Entries.size());
+		// Keeps the entry's capacity, recording the same entry again does not allocate
+		Entries[Entry].CommandBuffers.assign(pCommandBuffers, pCommandBuffers + Count);
+		Entries[Entry].Version = Version;
+		++RecordCount;
+	}
+}
@@ -0,0 +1,58 @@
+/*
+	CommandCache keeps recorded command buffers across frames and re-records an entry only when it is out of date
+	Entries are indexed by whatever a recording depends on (frame slot, particle buffer, swap chain image),
+	each entry owns its command pools inside a cCommandAllocator so re-recording one entry resets only that entry
+	Invalidate() marks every entry out of date, call it when structural state changes (render list, pipelines, emitter set);
+	per-frame data has to go through buffers, a cached command buffer never sees it
+*/
+#pragma once
+#define GLFW_INCLUDE_VULKAN
+#include "GLFW/glfw3.h"
+
+#include "CommandAllocator.h"
+
+#include <vector>
+#include <stdint.h>
+namespace VKE
+{
+	struct FMainDevice;
+	class cCommandCache
+	{
+	public:
+		/* Constructors and destructor*/
+		cCommandCache() {}
+		~cCommandCache() {}
+		cCommandCache(const cCommandCache& i_other) = delete;
+		cCommandCache& operator = (const cCommandCache& i_other) = delete;
+
+		bool init(FMainDevice* iMainDevice, uint32_t iQueueFamilyIndex, uint32_t iEntryCount, uint32_t iThreadCount = 1);
+		void cleanUp();
+
+		// Every entry has to be recorded again before its next use
+		void Invalidate() { ++Version; }
+		bool IsValid(uint32_t Entry) const { return Entries[Entry].Version == Version; }
+
+		// Recycle the command buffers of an entry, the GPU must be done with all of them
+		void BeginRecord(uint32_t Entry);
+		// Command buffer in initial state from the entry's pool of ThreadIndex
+		VkCommandBuffer Allocate(uint32_t Entry, uint32_t ThreadIndex = 0, VkCommandBufferLevel Level = VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+		// Store the recorded command buffers, the entry is valid until the next Invalidate()
+		void EndRecord(uint32_t Entry, const VkCommandBuffer* pCommandBuffers, uint32_t Count);
+
+		const std::vector<VkCommandBuffer>& Get(uint32_t Entry) const { return Entries[Entry].CommandBuffers; }
+		uint32_t GetEntryCount() const { return static_cast<uint32_t>(Entries.size()); }
+		// Number of entries recorded since init, a static scene stops increasing it
+		uint64_t GetRecordCount() const { return RecordCount; }
+	private:
+		struct FEntry
+		{
+			std::vector<VkCommandBuffer> CommandBuffers;
+			uint64_t Version = 0;								// Cache version this entry was recorded at, 0 means never recorded
+		};
+
+		cCommandAllocator Allocator;							// One "frame" of the allocator per entry
+		std::vector<FEntry> Entries;
+		uint64_t Version = 1;
+		uint64_t RecordCount = 0;
+	};
+}
@@ -0,0 +1,201 @@
+#include "FrameScheduler.h"
+#include "Utilities.h"
+
+#include <stdexcept>
+#include <limits>
+#include "assert.h"
+
+namespace VKE
+{
+	void FSubmitDesc::WaitTimeline(ETimeline Timeline, uint64_t Value, VkPipelineStageFlags Stage)
+	{
+		if (Value == 0)
+		{
+			// Nothing has been submitted on that timeline, no need to wait
+			return;
+		}
+		Waits.push_back({ Timeline, Value, VK_NULL_HANDLE, Stage });
+	}
+
+	void FSubmitDesc::WaitBinary(VkSemaphore Semaphore, VkPipelineStageFlags Stage)
+	{
+		Waits.push_back({ ETimeline::Count, 0, Semaphore, Stage });
+	}
+
+	void FSubmitDesc::WaitExternalTimeline(VkSemaphore Semaphore, uint64_t Value, VkPipelineStageFlags Stage)
+	{
+		if (Value == 0)
+		{
+			return;
+		}
+		// Not one of the scheduler's timelines, so it goes through the semaphore slot with its value
+		Waits.push_back({ ETimeline::Count, Value, Semaphore, Stage });
+	}
+
+	void FSubmitDesc::SignalBinary(VkSemaphore Semaphore)
+	{
+		BinarySignals.push_back(Semaphore);
+	}
+
+	bool cFrameScheduler::init(FMainDevice* iMainDevice, uint32_t iFrameCount)
+	{
+		assert(iMainDevice && iFrameCount > 0);
+		pMainDevice = iMainDevice;
+		FrameSlotValues.assign(iFrameCount * TimelineCount, 0);
+
+		VkSemaphoreTypeCreateInfo TypeCreateInfo = {};
+		TypeCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+		TypeCreateInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+		TypeCreateInfo.initialValue = 0;												// Value 0 means "nothing submitted", it is signaled from the start
+
+		VkSemaphoreCreateInfo SemaphoreCreateInfo = {};
+		SemaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+		SemaphoreCreateInfo.pNext = &TypeCreateInfo;
+
+		for (size_t i = 0; i < TimelineCount; ++i)
+		{
+			VkResult Result = vkCreateSemaphore(pMainDevice->LD, &SemaphoreCreateInfo, nullptr, &Timelines[i]);
+			RESULT_CHECK_ARGS(Result, "Fail to create timeline semaphore[%d]", static_cast<int>(i));
+			if (Result != VK_SUCCESS)
+			{
+				return false;
+			}
+			SubmittedValues[i] = 0;
+		}
+		return true;
+	}
+
+	void cFrameScheduler::cleanUp()
+	{
+		for (size_t i = 0; i < TimelineCount; ++i)
+		{
+			vkDestroySemaphore(pMainDevice->LD, Timelines[i], nullptr);
+			Timelines[i] = VK_NULL_HANDLE;
+		}
+		FrameSlotValues.clear();
+	}
+
+	uint64_t cFrameScheduler::Submit(ETimeline Timeline, VkQueue Queue, const FSubmitDesc& Desc, uint32_t FrameIndex)
+	{
+		const size_t TimelineIdx = static_cast<size_t>(Timeline);
+		assert(TimelineIdx < TimelineCount && FrameIndex * TimelineCount < FrameSlotValues.size());
+		const uint64_t SignalValue = SubmittedValues[TimelineIdx] + 1;
+
+		// 1. Gather waits, binary semaphores need a value slot as well but it is ignored
+		const size_t WaitCount = Desc.Waits.size();
+		VkSemaphore* WaitSemaphores = Desc.Arena.AllocateArray<VkSemaphore>(WaitCount);
+		uint64_t* WaitValues = Desc.Arena.AllocateArray<uint64_t>(WaitCount);
+		VkPipelineStageFlags* WaitStages = Desc.Arena.AllocateArray<VkPipelineStageFlags>(WaitCount);
+		for (size_t i = 0; i < WaitCount; ++i)
+		{
+			const FSubmitDesc::FWait& Wait = Desc.Waits[i];
+			WaitSemaphores[i] = Wait.Binary != VK_NULL_HANDLE ? Wait.Binary : Timelines[static_cast<size_t>(Wait.Timeline)];
+			WaitValues[i] = Wait.Value;
+			WaitStages[i] = Wait.Stage;
+		}
+
+		// 2. Gather signals, this timeline's next value is always the last one
+		const size_t SignalCount = Desc.BinarySignals.size() + 1;
+		VkSemaphore* SignalSemaphores = Desc.Arena.AllocateArray<VkSemaphore>(SignalCount);
+		uint64_t* SignalValues = Desc.Arena.AllocateArray<uint64_t>(SignalCount);
+		for (size_t i = 0; i < Desc.BinarySignals.size(); ++i)
+		{
+			SignalSemaphores[i] = Desc.BinarySignals[i];
+			SignalValues[i] = 0;
+		}
+		SignalSemaphores[SignalCount - 1] = Timelines[TimelineIdx];
+		SignalValues[SignalCount - 1] = SignalValue;
+
+		VkTimelineSemaphoreSubmitInfo TimelineSubmitInfo = {};
+		TimelineSubmitInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+		TimelineSubmitInfo.waitSemaphoreValueCount = static_cast<uint32_t>(WaitCount);
+		TimelineSubmitInfo.pWaitSemaphoreValues = WaitValues;
+		TimelineSubmitInfo.signalSemaphoreValueCount = static_cast<uint32_t>(SignalCount);
+		TimelineSubmitInfo.pSignalSemaphoreValues = SignalValues;
+
+		VkSubmitInfo SubmitInfo = {};
+		SubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		SubmitInfo.pNext = &TimelineSubmitInfo;
+		SubmitInfo.waitSemaphoreCount = static_cast<uint32_t>(WaitCount);
+		SubmitInfo.pWaitSemaphores = WaitSemaphores;
+		SubmitInfo.pWaitDstStageMask = WaitStages;
+		SubmitInfo.commandBufferCount = static_cast<uint32_t>(Desc.CommandBuffers.size());
+		SubmitInfo.pCommandBuffers = Desc.CommandBuffers.data();
+		SubmitInfo.signalSemaphoreCount = static_cast<uint32_t>(SignalCount);
+		SubmitInfo.pSignalSemaphores = SignalSemaphores;
+
+		// 3. No fence, the CPU waits on the timeline value instead
+		VkResult Result = vkQueueSubmit(Queue, 1, &SubmitInfo, VK_NULL_HANDLE);
+		RESULT_CHECK(Result, "Fail to submit command buffers to a timeline");
+		if (Result != VK_SUCCESS)
+		{
+			return 0;
+		}
+
+		SubmittedValues[TimelineIdx] = SignalValue;
+		FrameSlotValues[FrameIndex * TimelineCount + TimelineIdx] = SignalValue;
+		return SignalValue;
+	}
+
+	void cFrameScheduler::Wait(ETimeline Timeline, uint64_t Value) const
+	{
+		if (Value == 0)
+		{
+			return;
+		}
+		VkSemaphoreWaitInfo WaitInfo = {};
+		WaitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+		WaitInfo.semaphoreCount = 1;
+		WaitInfo.pSemaphores = &Timelines[static_cast<size_t>(Timeline)];
+		WaitInfo.pValues = &Value;
+
+		VkResult Result = vkWaitSemaphores(pMainDevice->LD, &WaitInfo, std::numeric_limits<uint64_t>::max());
+		RESULT_CHECK(Result, "Fail to wait for a timeline semaphore");
+	}
+
+	void cFrameScheduler::WaitFrameSlot(uint32_t FrameIndex) const
+	{
+		assert(FrameIndex * TimelineCount < FrameSlotValues.size());
+		VkSemaphore Semaphores[TimelineCount];
+		uint64_t Values[TimelineCount];
+		uint32_t Count = 0;
+		for (size_t i = 0; i < TimelineCount; ++i)
+		{
+			const uint64_t Value = FrameSlotValues[FrameIndex * TimelineCount + i];
+			// Skip timelines that this slot has never submitted to, e.g. compute pass disabled
+			if (Value > 0)
+			{
+				Semaphores[Count] = Timelines[i];
+				Values[Count] = Value;
+				++Count;
+			}
+		}
+		if (Count == 0)
+		{
+			return;
+		}
+
+		VkSemaphoreWaitInfo WaitInfo = {};
+		WaitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+		WaitInfo.semaphoreCount = Count;
+		WaitInfo.pSemaphores = Semaphores;
+		WaitInfo.pValues = Values;													// No VK_SEMAPHORE_WAIT_ANY_BIT, wait for all of them
+
+		VkResult Result = vkWaitSemaphores(pMainDevice->LD, &WaitInfo, std::numeric_limits<uint64_t>::max());
+		RESULT_CHECK(Result, "Fail to wait for the timeline semaphores of a frame slot");
+	}
+
+	uint64_t cFrameScheduler::GetCompletedValue(ETimeline Timeline) const
+	{
+		uint64_t Value = 0;
+		VkResult Result = vkGetSemaphoreCounterValue(pMainDevice->LD, Timelines[static_cast<size_t>(Timeline)], &Value);
+		RESULT_CHECK(Result, "Fail to get timeline semaphore value");
+		return Value;
+	}
+
+	uint64_t cFrameScheduler::GetFrameSlotValue(uint32_t FrameIndex, ETimeline Timeline) const
+	{
+		assert(FrameIndex * TimelineCount < FrameSlotValues.size());
+		return FrameSlotValues[FrameIndex * TimelineCount + static_cast<size_t>(Timeline)];
+	}
+}
@@ -0,0 +1,95 @@
+/*
+	FrameScheduler orders GPU work across queues with timeline semaphores
+	Every queue timeline owns one timeline semaphore whose value only goes up, each submit on a timeline signals the next value
+	Work on other timelines waits on values instead of binary semaphores, and the CPU waits on the values submitted by a frame slot instead of fences
+	Binary semaphores are only left for swap chain acquire / present, which can not use timeline semaphores
+	Submit descriptions and the arrays handed to vkQueueSubmit live in the frame arena, submitting does not allocate from the heap
+*/
+#pragma once
+#define GLFW_INCLUDE_VULKAN
+#include "GLFW/glfw3.h"
+
+#include "Memory/FrameArena.h"
+
+#include <vector>
+#include <stdint.h>
+namespace VKE
+{
+	struct FMainDevice;
+
+	enum class ETimeline : uint8_t
+	{
+		Graphics = 0,
+		Compute = 1,
+		Transfer = 2,
+		Count = 3,
+	};
+
+	// Everything a single submit waits on and signals besides its own timeline value
+	// Built and submitted within one frame, its lists are allocated from Arena
+	struct FSubmitDesc
+	{
+		explicit FSubmitDesc(cFrameArena& iArena) : Arena(iArena), CommandBuffers(iArena), Waits(iArena), BinarySignals(iArena) {}
+
+		cFrameArena& Arena;
+		FrameVector<VkCommandBuffer> CommandBuffers;
+
+		// Wait until Timeline reaches Value before Stage runs, value 0 is ignored
+		void WaitTimeline(ETimeline Timeline, uint64_t Value, VkPipelineStageFlags Stage);
+		// Wait for a binary semaphore, e.g. swap chain image acquired
+		void WaitBinary(VkSemaphore Semaphore, VkPipelineStageFlags Stage);
+		// Wait until a timeline semaphore not owned by the scheduler reaches Value, e.g. an upload token, value 0 is ignored
+		void WaitExternalTimeline(VkSemaphore Semaphore, uint64_t Value, VkPipelineStageFlags Stage);
+		// Signal a binary semaphore, e.g. rendering finished for present
+		void SignalBinary(VkSemaphore Semaphore);
+
+		struct FWait
+		{
+			ETimeline Timeline;
+			uint64_t Value;
+			VkSemaphore Binary;						// VK_NULL_HANDLE when waiting for a scheduler timeline, otherwise a binary or external timeline semaphore
+			VkPipelineStageFlags Stage;
+		};
+		FrameVector<FWait> Waits;
+		FrameVector<VkSemaphore> BinarySignals;
+	};
+
+	class cFrameScheduler
+	{
+	public:
+		/* Constructors and destructor*/
+		cFrameScheduler() {}
+		~cFrameScheduler() {}
+		cFrameScheduler(const cFrameScheduler& i_other) = delete;
+		cFrameScheduler& operator = (const cFrameScheduler& i_other) = delete;
+
+		bool init(FMainDevice* iMainDevice, uint32_t iFrameCount);
+		void cleanUp();
+
+		// Submit to Queue and signal the next value of Timeline, the value is remembered as work of FrameIndex
+		// Returns the signaled value, 0 if the submit failed
+		uint64_t Submit(ETimeline Timeline, VkQueue Queue, const FSubmitDesc& Desc, uint32_t FrameIndex);
+
+		// Block the CPU until Timeline reaches Value
+		void Wait(ETimeline Timeline, uint64_t Value) const;
+		// Block the CPU until every timeline value submitted from this frame slot is reached, after this the slot's resources can be reused
+		void WaitFrameSlot(uint32_t FrameIndex) const;
+
+		// Last value submitted on a timeline, 0 means nothing has been submitted yet
+		uint64_t GetSubmittedValue(ETimeline Timeline) const { return SubmittedValues[static_cast<size_t>(Timeline)]; }
+		// Value the GPU has finished on a timeline
+		uint64_t GetCompletedValue(ETimeline Timeline) const;
+		// Value a frame slot has submitted on a timeline
+		uint64_t GetFrameSlotValue(uint32_t FrameIndex, ETimeline Timeline) const;
+
+		VkSemaphore GetSemaphore(ETimeline Timeline) const { return Timelines[static_cast<size_t>(Timeline)]; }
+	private:
+		static const size_t TimelineCount = static_cast<size_t>(ETimeline::Count);
+
+		FMainDevice* pMainDevice = nullptr;
+		VkSemaphore Timelines[TimelineCount] = {};
+		uint64_t SubmittedValues[TimelineCount] = {};
+		// FrameIndex * TimelineCount + Timeline, the last value each frame slot has signaled on each timeline
+		std::vector<uint64_t> FrameSlotValues;
+	};
+}
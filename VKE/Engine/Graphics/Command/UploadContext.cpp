@@ -0,0 +1,497 @@
+#include "UploadContext.h"
+#include "Utilities.h"
+
+#include <stdexcept>
+#include <limits>
+#include <string.h>
+#include "assert.h"
+
+namespace VKE
+{
+	namespace
+	{
+		VkResult createTimeline(VkDevice LD, VkSemaphore& oSemaphore)
+		{
+			VkSemaphoreTypeCreateInfo TypeCreateInfo = {};
+			TypeCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+			TypeCreateInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+			TypeCreateInfo.initialValue = 0;
+
+			VkSemaphoreCreateInfo SemaphoreCreateInfo = {};
+			SemaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+			SemaphoreCreateInfo.pNext = &TypeCreateInfo;
+			return vkCreateSemaphore(LD, &SemaphoreCreateInfo, nullptr, &oSemaphore);
+		}
+
+		VkResult createPool(VkDevice LD, uint32_t QueueFamily, VkCommandPool& oPool)
+		{
+			// Batch command buffers are reused once their batch completes
+			VkCommandPoolCreateInfo PoolCreateInfo = {};
+			PoolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+			PoolCreateInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+			PoolCreateInfo.queueFamilyIndex = QueueFamily;
+			return vkCreateCommandPool(LD, &PoolCreateInfo, nullptr, &oPool);
+		}
+	}
+
+	bool cUploadContext::init(FMainDevice* iMainDevice, uint32_t iTransferFamily, VkQueue iTransferQueue, uint32_t iOwnerFamily, VkQueue iOwnerQueue, VkDeviceSize iRingSize)
+	{
+		assert(iMainDevice && iTransferQueue != VK_NULL_HANDLE && iOwnerQueue != VK_NULL_HANDLE && iRingSize > 0);
+		pMainDevice = iMainDevice;
+		TransferFamily = iTransferFamily;
+		OwnerFamily = iOwnerFamily;
+		TransferQueue = iTransferQueue;
+		OwnerQueue = iOwnerQueue;
+
+		// Ring offsets have to suit buffer copies and texel sizes, the ring size is a multiple of the alignment so a wrapped offset stays aligned
+		VkPhysicalDeviceProperties Properties;
+		vkGetPhysicalDeviceProperties(pMainDevice->PD, &Properties);
+		Alignment = Properties.limits.optimalBufferCopyOffsetAlignment > 16 ? Properties.limits.optimalBufferCopyOffsetAlignment : 16;
+		RingSize = (iRingSize + Alignment - 1) / Alignment * Alignment;
+		RingHead = 0;
+		RingTail = 0;
+		SubmittedToken = 0;
+
+		// 1. Command pool of the copies, and of the ownership acquires when the copies run on their own family
+		VkResult Result = createPool(pMainDevice->LD, TransferFamily, CommandPool);
+		RESULT_CHECK(Result, "Fail to create upload command pool.");
+		if (Result != VK_SUCCESS)
+		{
+			return false;
+		}
+		if (IsAsync())
+		{
+			Result = createPool(pMainDevice->LD, OwnerFamily, AcquireCommandPool);
+			RESULT_CHECK(Result, "Fail to create upload acquire command pool.");
+			if (Result != VK_SUCCESS)
+			{
+				return false;
+			}
+		}
+
+		// 2. Timeline semaphores, every batch signals the next value; the transfer timeline uses the same values as the tokens
+		Result = createTimeline(pMainDevice->LD, Timeline);
+		RESULT_CHECK(Result, "Fail to create upload timeline semaphore.");
+		if (Result != VK_SUCCESS)
+		{
+			return false;
+		}
+		if (IsAsync())
+		{
+			Result = createTimeline(pMainDevice->LD, TransferTimeline);
+			RESULT_CHECK(Result, "Fail to create upload transfer timeline semaphore.");
+			if (Result != VK_SUCCESS)
+			{
+				return false;
+			}
+		}
+
+		// 3. Staging ring, mapped for the whole lifetime and flushed explicitly in case the memory is not coherent
+		if (!RingBuffer.CreateBufferAndAllocateMemory(pMainDevice, RingSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, EMemoryCategory::Staging, {}, EMemoryStrategy::Dedicated))
+		{
+			return false;
+		}
+		pRingMapped = static_cast<char*>(RingBuffer.Map());
+		return pRingMapped != nullptr;
+	}
+
+	void cUploadContext::cleanUp()
+	{
+		std::lock_guard<std::mutex> Lock(Mutex);
+		// Staged but never submitted uploads are dropped
+		for (cBuffer& TempBuffer : PendingTempBuffers)
+		{
+			TempBuffer.cleanUp();
+		}
+		PendingTempBuffers.clear();
+		PendingBufferCopies.clear();
+		PendingImageCopies.clear();
+
+		waitLocked(SubmittedToken);
+		retireLocked();
+		assert(InFlight.empty());
+
+		if (pRingMapped)
+		{
+			RingBuffer.Unmap();
+			pRingMapped = nullptr;
+		}
+		RingBuffer.cleanUp();
+
+		// Destroying the pools frees their command buffers
+		vkDestroyCommandPool(pMainDevice->LD, CommandPool, nullptr);
+		vkDestroyCommandPool(pMainDevice->LD, AcquireCommandPool, nullptr);
+		vkDestroySemaphore(pMainDevice->LD, Timeline, nullptr);
+		vkDestroySemaphore(pMainDevice->LD, TransferTimeline, nullptr);
+		CommandPool = VK_NULL_HANDLE;
+		AcquireCommandPool = VK_NULL_HANDLE;
+		Timeline = VK_NULL_HANDLE;
+		TransferTimeline = VK_NULL_HANDLE;
+		FreeCommandBuffers.clear();
+		FreeAcquireCommandBuffers.clear();
+	}
+
+	bool cUploadContext::UploadBuffer(VkBuffer Dst, const void* pData, VkDeviceSize Size, VkDeviceSize DstOffset, bool bConcurrent)
+	{
+		if (Size == 0)
+		{
+			return true;
+		}
+		std::lock_guard<std::mutex> Lock(Mutex);
+		FBufferCopy Copy = {};
+		if (!stage(pData, Size, Copy.Src, Copy.Region.srcOffset))
+		{
+			return false;
+		}
+		Copy.Dst = Dst;
+		Copy.Region.dstOffset = DstOffset;
+		Copy.Region.size = Size;
+		Copy.bConcurrent = bConcurrent;
+		PendingBufferCopies.push_back(Copy);
+		return true;
+	}
+
+	bool cUploadContext::UploadImage(VkImage Dst, const void* pData, VkDeviceSize Size, uint32_t Width, uint32_t Height)
+	{
+		std::lock_guard<std::mutex> Lock(Mutex);
+		FImageCopy Copy = {};
+		if (!stage(pData, Size, Copy.Src, Copy.Region.bufferOffset))
+		{
+			return false;
+		}
+		Copy.Dst = Dst;
+		Copy.Region.bufferRowLength = 0;											// Tightly packed, no spacing between rows
+		Copy.Region.bufferImageHeight = 0;
+		Copy.Region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		Copy.Region.imageSubresource.mipLevel = 0;
+		Copy.Region.imageSubresource.baseArrayLayer = 0;
+		Copy.Region.imageSubresource.layerCount = 1;
+		Copy.Region.imageOffset = { 0, 0, 0 };
+		Copy.Region.imageExtent = { Width, Height, 1 };
+		PendingImageCopies.push_back(Copy);
+		return true;
+	}
+
+	uint64_t cUploadContext::Submit()
+	{
+		std::lock_guard<std::mutex> Lock(Mutex);
+		retireLocked();
+		return submitLocked();
+	}
+
+	void cUploadContext::Wait(uint64_t Token)
+	{
+		std::lock_guard<std::mutex> Lock(Mutex);
+		waitLocked(Token);
+		retireLocked();
+	}
+
+	bool cUploadContext::IsComplete(uint64_t Token) const
+	{
+		return GetCompletedToken() >= Token;
+	}
+
+	uint64_t cUploadContext::GetCompletedToken() const
+	{
+		uint64_t Value = 0;
+		VkResult Result = vkGetSemaphoreCounterValue(pMainDevice->LD, Timeline, &Value);
+		RESULT_CHECK(Result, "Fail to get upload timeline semaphore value");
+		return Value;
+	}
+
+	bool cUploadContext::stage(const void* pData, VkDeviceSize Size, VkBuffer& oBuffer, VkDeviceSize& oOffset)
+	{
+		retireLocked();
+
+		// 1. Larger than the whole ring, give it a staging buffer of its own that lives as long as its batch
+		if (Size > RingSize)
+		{
+			cBuffer TempBuffer;
+			if (!TempBuffer.CreateBufferAndAllocateMemory(pMainDevice, Size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, EMemoryCategory::Staging, {}, EMemoryStrategy::Linear))
+			{
+				return false;
+			}
+			memcpy(TempBuffer.Map(), pData, static_cast<size_t>(Size));
+			TempBuffer.Unmap();
+			oBuffer = TempBuffer.GetvkBuffer();
+			oOffset = 0;
+			PendingTempBuffers.push_back(TempBuffer);
+			return true;
+		}
+
+		// 2. Reserve from the ring, a reservation never wraps around the end of the buffer
+		for (;;)
+		{
+			uint64_t Begin = (RingHead + Alignment - 1) / Alignment * Alignment;
+			VkDeviceSize Offset = Begin % RingSize;
+			if (Offset + Size > RingSize)
+			{
+				Begin += RingSize - Offset;
+				Offset = 0;
+			}
+			if (Begin + Size - RingTail <= RingSize)
+			{
+				RingHead = Begin + Size;
+				memcpy(pRingMapped + Offset, pData, static_cast<size_t>(Size));
+				RingBuffer.Flush(Offset, Size);
+				oBuffer = RingBuffer.GetvkBuffer();
+				oOffset = Offset;
+				return true;
+			}
+
+			// 3. Ring is full, submit what is staged so its memory can be reclaimed, then wait for the oldest batch
+			submitLocked();
+			if (InFlight.empty())
+			{
+				// Nothing uses the ring anymore, restart at its beginning
+				RingHead = (RingHead + RingSize - 1) / RingSize * RingSize;
+				RingTail = RingHead;
+				continue;
+			}
+			waitLocked(InFlight.front().Token);
+			retireLocked();
+		}
+	}
+
+	uint64_t cUploadContext::submitLocked()
+	{
+		if (PendingBufferCopies.empty() && PendingImageCopies.empty())
+		{
+			return SubmittedToken;
+		}
+		const bool bAsync = IsAsync();
+		const uint32_t SrcFamily = bAsync ? TransferFamily : VK_QUEUE_FAMILY_IGNORED;
+		const uint32_t DstFamily = bAsync ? OwnerFamily : VK_QUEUE_FAMILY_IGNORED;
+		VkCommandBuffer CommandBuffer = acquireCommandBuffer(CommandPool, FreeCommandBuffers);
+
+		VkCommandBufferBeginInfo BeginInfo = {};
+		BeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		BeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		vkBeginCommandBuffer(CommandBuffer, &BeginInfo);
+
+		// 1. Every image of the batch becomes a transfer destination in one barrier, new images are not owned by any family yet
+		std::vector<VkImageMemoryBarrier> ImageBarriers(PendingImageCopies.size());
+		for (size_t i = 0; i < PendingImageCopies.size(); ++i)
+		{
+			VkImageMemoryBarrier& Barrier = ImageBarriers[i];
+			Barrier = {};
+			Barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			Barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			Barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			Barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			Barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			Barrier.image = PendingImageCopies[i].Dst;
+			Barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+			Barrier.srcAccessMask = 0;
+			Barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		}
+		if (!ImageBarriers.empty())
+		{
+			vkCmdPipelineBarrier(CommandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+				0, nullptr, 0, nullptr, static_cast<uint32_t>(ImageBarriers.size()), ImageBarriers.data());
+		}
+
+		// 2. Copies
+		for (const FBufferCopy& Copy : PendingBufferCopies)
+		{
+			vkCmdCopyBuffer(CommandBuffer, Copy.Src, Copy.Dst, 1, &Copy.Region);
+		}
+		for (const FImageCopy& Copy : PendingImageCopies)
+		{
+			vkCmdCopyBufferToImage(CommandBuffer, Copy.Src, Copy.Dst, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &Copy.Region);
+		}
+
+		// 3. Images become shader readable, waiting on the token makes the writes visible to the consumer
+		// When async this is also the release half of the ownership transfer, exclusive buffers are released as well
+		for (VkImageMemoryBarrier& Barrier : ImageBarriers)
+		{
+			Barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			Barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			Barrier.srcQueueFamilyIndex = SrcFamily;
+			Barrier.dstQueueFamilyIndex = DstFamily;
+			Barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			Barrier.dstAccessMask = 0;
+		}
+		std::vector<VkBufferMemoryBarrier> BufferBarriers;
+		if (bAsync)
+		{
+			for (const FBufferCopy& Copy : PendingBufferCopies)
+			{
+				if (Copy.bConcurrent)
+				{
+					continue;
+				}
+				VkBufferMemoryBarrier Barrier = {};
+				Barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+				Barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+				Barrier.dstAccessMask = 0;
+				Barrier.srcQueueFamilyIndex = SrcFamily;
+				Barrier.dstQueueFamilyIndex = DstFamily;
+				Barrier.buffer = Copy.Dst;
+				Barrier.offset = Copy.Region.dstOffset;
+				Barrier.size = Copy.Region.size;
+				BufferBarriers.push_back(Barrier);
+			}
+		}
+		if (!ImageBarriers.empty() || !BufferBarriers.empty())
+		{
+			vkCmdPipelineBarrier(CommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0,
+				0, nullptr, static_cast<uint32_t>(BufferBarriers.size()), BufferBarriers.data(), static_cast<uint32_t>(ImageBarriers.size()), ImageBarriers.data());
+		}
+		vkEndCommandBuffer(CommandBuffer);
+
+		// 4. Acquire half of the ownership transfer on the owner queue, the same barriers with the access on the owner side
+		VkCommandBuffer AcquireCommandBuffer = VK_NULL_HANDLE;
+		if (bAsync && (!ImageBarriers.empty() || !BufferBarriers.empty()))
+		{
+			AcquireCommandBuffer = acquireCommandBuffer(AcquireCommandPool, FreeAcquireCommandBuffers);
+			vkBeginCommandBuffer(AcquireCommandBuffer, &BeginInfo);
+			for (VkImageMemoryBarrier& Barrier : ImageBarriers)
+			{
+				Barrier.srcAccessMask = 0;
+				Barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+			}
+			for (VkBufferMemoryBarrier& Barrier : BufferBarriers)
+			{
+				Barrier.srcAccessMask = 0;
+				Barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+			}
+			vkCmdPipelineBarrier(AcquireCommandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0,
+				0, nullptr, static_cast<uint32_t>(BufferBarriers.size()), BufferBarriers.data(), static_cast<uint32_t>(ImageBarriers.size()), ImageBarriers.data());
+			vkEndCommandBuffer(AcquireCommandBuffer);
+		}
+
+		// 5. One submit for the copies, plus the acquire submit when async, which waits for the copies; the last one signals the next token
+		const uint64_t Token = SubmittedToken + 1;
+		bool bSubmitted = false;
+		if (bAsync)
+		{
+			bSubmitted = submitToQueue(TransferQueue, CommandBuffer, VK_NULL_HANDLE, TransferTimeline, Token)
+				&& submitToQueue(OwnerQueue, AcquireCommandBuffer, TransferTimeline, Timeline, Token);
+		}
+		else
+		{
+			bSubmitted = submitToQueue(TransferQueue, CommandBuffer, VK_NULL_HANDLE, Timeline, Token);
+		}
+
+		FBatch Batch;
+		Batch.CommandBuffer = CommandBuffer;
+		Batch.AcquireCommandBuffer = AcquireCommandBuffer;
+		Batch.Token = Token;
+		Batch.RingEnd = RingHead;
+		Batch.TempBuffers.swap(PendingTempBuffers);
+		PendingBufferCopies.clear();
+		PendingImageCopies.clear();
+		if (!bSubmitted)
+		{
+			// Nothing will signal the token, give the resources back right away
+			vkQueueWaitIdle(TransferQueue);
+			for (cBuffer& TempBuffer : Batch.TempBuffers)
+			{
+				TempBuffer.cleanUp();
+			}
+			FreeCommandBuffers.push_back(CommandBuffer);
+			if (AcquireCommandBuffer != VK_NULL_HANDLE)
+			{
+				FreeAcquireCommandBuffers.push_back(AcquireCommandBuffer);
+			}
+			RingTail = InFlight.empty() ? RingHead : RingTail;
+			return 0;
+		}
+		InFlight.push_back(std::move(Batch));
+		SubmittedToken = Token;
+		return Token;
+	}
+
+	bool cUploadContext::submitToQueue(VkQueue Queue, VkCommandBuffer CommandBuffer, VkSemaphore WaitSemaphore, VkSemaphore SignalSemaphore, uint64_t Value)
+	{
+		// The wait (if any) uses the same value as the signal, the transfer timeline and the tokens count batches alike
+		const VkPipelineStageFlags WaitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+		VkTimelineSemaphoreSubmitInfo TimelineSubmitInfo = {};
+		TimelineSubmitInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+		TimelineSubmitInfo.waitSemaphoreValueCount = WaitSemaphore != VK_NULL_HANDLE ? 1 : 0;
+		TimelineSubmitInfo.pWaitSemaphoreValues = &Value;
+		TimelineSubmitInfo.signalSemaphoreValueCount = 1;
+		TimelineSubmitInfo.pSignalSemaphoreValues = &Value;
+
+		VkSubmitInfo SubmitInfo = {};
+		SubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		SubmitInfo.pNext = &TimelineSubmitInfo;
+		SubmitInfo.waitSemaphoreCount = WaitSemaphore != VK_NULL_HANDLE ? 1 : 0;
+		SubmitInfo.pWaitSemaphores = &WaitSemaphore;
+		SubmitInfo.pWaitDstStageMask = &WaitStage;
+		SubmitInfo.commandBufferCount = CommandBuffer != VK_NULL_HANDLE ? 1 : 0;		// Nothing to acquire, the submit only forwards the signal
+		SubmitInfo.pCommandBuffers = &CommandBuffer;
+		SubmitInfo.signalSemaphoreCount = 1;
+		SubmitInfo.pSignalSemaphores = &SignalSemaphore;
+
+		VkResult Result = vkQueueSubmit(Queue, 1, &SubmitInfo, VK_NULL_HANDLE);
+		RESULT_CHECK(Result, "Fail to submit upload batch");
+		return Result == VK_SUCCESS;
+	}
+
+	void cUploadContext::waitLocked(uint64_t Token)
+	{
+		assert(Token <= SubmittedToken);
+		if (Token == 0)
+		{
+			return;
+		}
+		VkSemaphoreWaitInfo WaitInfo = {};
+		WaitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+		WaitInfo.semaphoreCount = 1;
+		WaitInfo.pSemaphores = &Timeline;
+		WaitInfo.pValues = &Token;
+
+		VkResult Result = vkWaitSemaphores(pMainDevice->LD, &WaitInfo, std::numeric_limits<uint64_t>::max());
+		RESULT_CHECK(Result, "Fail to wait for an upload batch");
+	}
+
+	void cUploadContext::retireLocked()
+	{
+		if (InFlight.empty())
+		{
+			return;
+		}
+		uint64_t Completed = 0;
+		VkResult Result = vkGetSemaphoreCounterValue(pMainDevice->LD, Timeline, &Completed);
+		RESULT_CHECK(Result, "Fail to get upload timeline semaphore value");
+
+		while (!InFlight.empty() && InFlight.front().Token <= Completed)
+		{
+			FBatch& Batch = InFlight.front();
+			RingTail = Batch.RingEnd;
+			for (cBuffer& TempBuffer : Batch.TempBuffers)
+			{
+				TempBuffer.cleanUp();
+			}
+			FreeCommandBuffers.push_back(Batch.CommandBuffer);
+			if (Batch.AcquireCommandBuffer != VK_NULL_HANDLE)
+			{
+				FreeAcquireCommandBuffers.push_back(Batch.AcquireCommandBuffer);
+			}
+			InFlight.pop_front();
+		}
+	}
+
+	VkCommandBuffer cUploadContext::acquireCommandBuffer(VkCommandPool Pool, std::vector<VkCommandBuffer>& FreeList)
+	{
+		if (!FreeList.empty())
+		{
+			VkCommandBuffer CommandBuffer = FreeList.back();
+			FreeList.pop_back();
+			return CommandBuffer;
+		}
+		VkCommandBufferAllocateInfo AllocInfo = {};
+		AllocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		AllocInfo.commandPool = Pool;
+		AllocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		AllocInfo.commandBufferCount = 1;
+
+		VkCommandBuffer CommandBuffer = VK_NULL_HANDLE;
+		VkResult Result = vkAllocateCommandBuffers(pMainDevice->LD, &AllocInfo, &CommandBuffer);
+		RESULT_CHECK(Result, "Fail to allocate upload command buffer");
+		return CommandBuffer;
+	}
+}
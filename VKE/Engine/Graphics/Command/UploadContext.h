@@ -0,0 +1,128 @@
+/*
+	UploadContext moves data from the CPU into device local buffers and images without stalling on every copy
+	Data is written into a persistently mapped staging ring, the copies and image layout transitions are only recorded into a batch
+	Submit() records the whole batch into one command buffer and one queue submit, which signals a timeline semaphore
+	The signaled value is the completion token of the batch, consumers wait on it (GPU side in a submit or CPU side with Wait)
+	Ring memory of a batch is reused once its token is reached, data larger than the ring gets a temporary staging buffer
+	With a dedicated transfer queue family the copies run on the transfer queue asynchronously to rendering,
+	the batch releases its resources to the owner (graphic) family and a second, barrier only submit on the owner queue acquires them
+	That acquire submit signals the token, so once a token is reached the resources can be used by the owner family right away
+*/
+#pragma once
+#define GLFW_INCLUDE_VULKAN
+#include "GLFW/glfw3.h"
+
+#include "Buffer/Buffer.h"
+
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <stdint.h>
+namespace VKE
+{
+	struct FMainDevice;
+
+	class cUploadContext
+	{
+	public:
+		/* Constructors and destructor*/
+		cUploadContext() {}
+		~cUploadContext() {}
+		cUploadContext(const cUploadContext& i_other) = delete;
+		cUploadContext& operator = (const cUploadContext& i_other) = delete;
+
+		// Copies run on TransferQueue, uploaded resources are used by OwnerFamily; both may be the same family
+		// Neither queue must be submitted to from another thread while an upload batch is submitted
+		bool init(FMainDevice* iMainDevice, uint32_t iTransferFamily, VkQueue iTransferQueue, uint32_t iOwnerFamily, VkQueue iOwnerQueue, VkDeviceSize iRingSize = DEFAULT_RING_SIZE);
+		// Waits for every submitted batch
+		void cleanUp();
+
+		// Stage Size bytes for Dst at DstOffset, Dst needs VK_BUFFER_USAGE_TRANSFER_DST_BIT
+		// bConcurrent: Dst is shared concurrently with the transfer family, so there is no ownership to transfer
+		bool UploadBuffer(VkBuffer Dst, const void* pData, VkDeviceSize Size, VkDeviceSize DstOffset = 0, bool bConcurrent = false);
+		// Stage tightly packed pixels of mip 0 / layer 0, the image goes UNDEFINED -> TRANSFER_DST -> SHADER_READ_ONLY in the batch
+		bool UploadImage(VkImage Dst, const void* pData, VkDeviceSize Size, uint32_t Width, uint32_t Height);
+
+		// Submit everything staged since the last submit as one batch
+		// Returns the batch's token, or the last token when nothing is staged; 0 means nothing has ever been submitted
+		uint64_t Submit();
+		// Block the CPU until the token is reached
+		void Wait(uint64_t Token);
+		bool IsComplete(uint64_t Token) const;
+		// Latest token the GPU has reached
+		uint64_t GetCompletedToken() const;
+
+		uint64_t GetSubmittedToken() const { return SubmittedToken; }
+		// Token the next Submit() will return, uploads staged now are part of that batch
+		uint64_t GetPendingToken() const { return SubmittedToken + 1; }
+		// Copies run on a queue family of their own
+		bool IsAsync() const { return TransferFamily != OwnerFamily; }
+		// Timeline semaphore the tokens are values of, wait on it in a submit to use the uploaded data
+		VkSemaphore GetSemaphore() const { return Timeline; }
+		VkDeviceSize GetRingSize() const { return RingSize; }
+
+		static const VkDeviceSize DEFAULT_RING_SIZE = 32ull * 1024 * 1024;
+	private:
+		struct FBufferCopy
+		{
+			VkBuffer Src;
+			VkBuffer Dst;
+			VkBufferCopy Region;
+			bool bConcurrent;
+		};
+		struct FImageCopy
+		{
+			VkBuffer Src;
+			VkImage Dst;
+			VkBufferImageCopy Region;
+		};
+		struct FBatch
+		{
+			VkCommandBuffer CommandBuffer = VK_NULL_HANDLE;
+			VkCommandBuffer AcquireCommandBuffer = VK_NULL_HANDLE;		// Owner family side of the ownership transfer, null when not async
+			uint64_t Token = 0;
+			uint64_t RingEnd = 0;						// Ring head when the batch was submitted, the ring tail moves here when it completes
+			std::vector<cBuffer> TempBuffers;			// Staging buffers of uploads that did not fit into the ring
+		};
+
+		// Copy Size bytes into staging memory, returns the buffer and the offset the copy has to read from
+		bool stage(const void* pData, VkDeviceSize Size, VkBuffer& oBuffer, VkDeviceSize& oOffset);
+		uint64_t submitLocked();
+		// Submit CommandBuffer (may be null) to Queue, signal Value on SignalSemaphore and optionally wait WaitValue on WaitSemaphore first
+		bool submitToQueue(VkQueue Queue, VkCommandBuffer CommandBuffer, VkSemaphore WaitSemaphore, VkSemaphore SignalSemaphore, uint64_t Value);
+		void waitLocked(uint64_t Token);
+		// Give back the ring memory / command buffers of the batches that have completed
+		void retireLocked();
+		VkCommandBuffer acquireCommandBuffer(VkCommandPool Pool, std::vector<VkCommandBuffer>& FreeList);
+
+		FMainDevice* pMainDevice = nullptr;
+		uint32_t TransferFamily = 0;
+		uint32_t OwnerFamily = 0;
+		VkQueue TransferQueue = VK_NULL_HANDLE;
+		VkQueue OwnerQueue = VK_NULL_HANDLE;
+		VkCommandPool CommandPool = VK_NULL_HANDLE;
+		VkCommandPool AcquireCommandPool = VK_NULL_HANDLE;		// Owner family, only created when async
+		VkSemaphore Timeline = VK_NULL_HANDLE;					// Tokens
+		VkSemaphore TransferTimeline = VK_NULL_HANDLE;			// Copies of a batch are done, the acquire submit waits on it; only created when async
+		uint64_t SubmittedToken = 0;
+
+		// Ring head / tail only go up, the offset in the ring buffer is the value modulo RingSize
+		cBuffer RingBuffer;
+		char* pRingMapped = nullptr;
+		VkDeviceSize RingSize = 0;
+		VkDeviceSize Alignment = 16;
+		uint64_t RingHead = 0;
+		uint64_t RingTail = 0;
+
+		// Staged, not recorded yet
+		std::vector<FBufferCopy> PendingBufferCopies;
+		std::vector<FImageCopy> PendingImageCopies;
+		std::vector<cBuffer> PendingTempBuffers;
+
+		std::deque<FBatch> InFlight;
+		std::vector<VkCommandBuffer> FreeCommandBuffers;
+		std::vector<VkCommandBuffer> FreeAcquireCommandBuffers;
+		// Assets can be loaded off the main thread
+		mutable std::mutex Mutex;
+	};
+}
@@ -100,68 +100,14 @@ namespace VKE
 			// . initialize data, create storage buffer and uniform buffer
 			Emitters[i].init(iMainDevice);
 			Emitters[i].Transform.Update();
+			// Placed, not moved: nothing to blend from before the first fixed step
+			Emitters[i].Transform.SavePrevious();
 		}
 		// . set up descriptor set related
 		prepareDescriptors();
-		// . Create semaphores and fences
-		createSynchronization();
 		// . Create compute pipeline
 		createComputePipeline();
-		// . Need to signal in init stage because the graphic pass is running before the compute pass, so making sure no need to wait at for the compute pass in the first render
-		// Signal the semaphore with an empty queue (no wait, no command buffer, no fence to signal)
-		{
-			VkSubmitInfo SubmitInfo = {};
-			SubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-			SubmitInfo.signalSemaphoreCount = 1;
-			SubmitInfo.pSignalSemaphores = &OnComputeFinished;
-
-			VkResult Result = vkQueueSubmit(ComputeQueue, 1, &SubmitInfo, VK_NULL_HANDLE);
-			RESULT_CHECK(Result, "Fail to submit initial compute queue");
-			// Wait for the queue to finish
-			Result = vkQueueWaitIdle(ComputeQueue);
-			RESULT_CHECK(Result, "Fail to wait the queue to finish");
-		}
-
-		// . Record command lines
-		recordComputeCommands();
-
-		const uint32_t EmitterCount = Emitters.size();
-		// If graphics and compute queue family indices differ, acquire and immediately release the storage buffer, so that the initial acquire from the graphics command buffers are matched up properly
-		if (needSynchronization())
-		{
-			// Create a transient command buffer for setting up the initial buffer transfer state
-			VkCommandBuffer TransferCommandBuffer = BeginCommandBuffer(pMainDevice->LD, ComputeCommandPool);
-			
-			std::vector<VkBufferMemoryBarrier> BufferBarriers(EmitterCount);
-			for (uint32_t i = 0; i < EmitterCount; ++i)
-			{
-				BufferBarriers[i] = Emitters[i].ComputeOwnBarrier(0, VK_ACCESS_SHADER_WRITE_BIT);
-			}
-
-			vkCmdPipelineBarrier(TransferCommandBuffer,
-				VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
-				VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-				0,
-				0, nullptr,
-				EmitterCount, BufferBarriers.data(),
-				0, nullptr);
-			
-			for (uint32_t i = 0; i < EmitterCount; ++i)
-			{
-				BufferBarriers[i] = Emitters[i].GraphicOwnBarrier(VK_ACCESS_SHADER_WRITE_BIT, 0);
-			}
-
-			vkCmdPipelineBarrier(
-				TransferCommandBuffer,
-				VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-				VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
-				0,
-				0, nullptr,
-				EmitterCount, BufferBarriers.data(),
-				0, nullptr);
-
-			EndCommandBuffer(TransferCommandBuffer, pMainDevice->LD, ComputeQueue, ComputeCommandPool);
-		}
+		// . Command buffers are recorded every frame in recordComputeCommands
 	}
 
 	void FComputePass::cleanUp()
@@ -169,10 +115,9 @@ namespace VKE
 		// wait until the device is not doing anything (nothing on any queue)
 		vkDeviceWaitIdle(pMainDevice->LD);
 
-		vkDestroySemaphore(pMainDevice->LD, OnComputeFinished, nullptr);
-
 		cleanupSwapChain();
 
+		CommandCache.cleanUp();
 		vkDestroyCommandPool(pMainDevice->LD, ComputeCommandPool, nullptr);
 		
 		for (cEmitter& emitter : Emitters)
@@ -180,76 +125,56 @@ namespace VKE
 			emitter.cleanUp();
 		}
 		Emitters.clear();
-
-		vkDestroyDescriptorPool(pMainDevice->LD, DescriptorPool, nullptr);
 	}
 
-	void FComputePass::recordComputeCommands()
+	void FComputePass::recordComputeCommands(uint32_t FrameIndex)
 	{
-		const uint32_t EmitterCount = Emitters.size();
+		const uint32_t Entry = FrameIndex * cEmitter::ParticleBufferCount + ReadBufferIndex;
+		if (CommandCache.IsValid(Entry))
+		{
+			CommandBuffers[FrameIndex] = CommandCache.Get(Entry)[0];
+			return;
+		}
+		// Recycle the entry, it is only submitted from this frame slot and the caller makes sure the slot's compute timeline value is reached
+		CommandCache.BeginRecord(Entry);
+		CommandBuffers[FrameIndex] = CommandCache.Allocate(Entry);
+		VkCommandBuffer& CommandBuffer = CommandBuffers[FrameIndex];
 		VkCommandBufferBeginInfo BufferBeginInfo = {};
 		BufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-		//BufferBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
+		BufferBeginInfo.flags = 0;													// Submitted again every time this slot reads the same buffer
 
 		// Begin command buffer
 		VkResult Result = vkBeginCommandBuffer(CommandBuffer, &BufferBeginInfo);
 		RESULT_CHECK(Result, "Fail to start recording a compute command buffer");
 
 		// Particle Movement
-
-		// Add memory barrier to ensure that the (graphics) vertex shader has fetched attributes before compute starts to write to the buffer
-		if (needSynchronization())
-		{
-			std::vector<VkBufferMemoryBarrier> BufferBarriers(EmitterCount);
-
-			// Let compute queue own the buffers
-			for (uint32_t i = 0; i < EmitterCount; ++i)
-			{
-				// Compute shader will write data to the storage buffer
-				BufferBarriers[i] = Emitters[i].ComputeOwnBarrier(0, VK_ACCESS_SHADER_WRITE_BIT);
-			}
-			// Block the compute shader until vertex shader finished reading the storage buffer
-			vkCmdPipelineBarrier(CommandBuffer,
-				VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
-				VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-				0,										// No Dependency flag
-				0, nullptr,								// Not a Memory barrier
-				EmitterCount, BufferBarriers.data(),	// Buffer memory Barriers
-				0, nullptr);							// Not a Image memory barrier
-		}
+		// The previous dispatch on this queue wrote the buffer this one reads, and read the buffer this one writes.
+		// A barrier at the start of the command buffer covers every earlier submission of the queue, so it orders dispatch N after N-1.
+		// Graphics reading the buffer being written is covered by the submit waiting on the graphics timeline value of the frame that drew it
+		VkMemoryBarrier ParticleBarrier = {};
+		ParticleBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		ParticleBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		ParticleBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		vkCmdPipelineBarrier(CommandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &ParticleBarrier, 0, nullptr, 0, nullptr);
 
 		// Dispatch the compute job
 		vkCmdBindPipeline(CommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, ComputePipeline);
 		
 		for (size_t i = 0; i < Emitters.size(); ++i)
 		{
-			Emitters[i].Dispatch(CommandBuffer, ComputePipelineLayout);
+			Emitters[i].Dispatch(CommandBuffer, ComputePipelineLayout, FrameIndex, ReadBufferIndex);
 		}
 
-		// Add barrier to ensure that compute shader has finished writing to the buffer
-		// Without this the (rendering) vertex shader may display incomplete results (partial data from last frame)
-		if (needSynchronization())
-		{
-			std::vector<VkBufferMemoryBarrier> BufferBarriers(EmitterCount);
-
-			// Let graphic queue own the buffers
-			for (uint32_t i = 0; i < EmitterCount; ++i)
-			{
-				BufferBarriers[i] = Emitters[i].GraphicOwnBarrier(VK_ACCESS_SHADER_WRITE_BIT, 0);
-			}
-
-			// Block the vertex input stage until compute shader has finished
-			vkCmdPipelineBarrier(CommandBuffer,
-				VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-				VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
-				0,
-				0, nullptr,
-				EmitterCount, BufferBarriers.data(),
-				0, nullptr);
-		}
 		Result = vkEndCommandBuffer(CommandBuffer);
 		RESULT_CHECK(Result, "Fail to stop recording a compute command buffer");
+		CommandCache.EndRecord(Entry, &CommandBuffer, 1);
+
+	}
 
+	void FComputePass::swapParticleBuffers()
+	{
+		// The buffer just written becomes the one graphics draws and the next dispatch reads
+		ReadBufferIndex = (ReadBufferIndex + 1) % cEmitter::ParticleBufferCount;
 	}
 
 	void FComputePass::recreateSwapChain()
@@ -258,50 +183,25 @@ namespace VKE
 
 		createComputePipeline();
 		createCommandBuffer();
-		recordComputeCommands();
 	}
 
 	void FComputePass::cleanupSwapChain()
 	{
-		vkFreeCommandBuffers(pMainDevice->LD, ComputeCommandPool, 1, &CommandBuffer);
+		// Cached dispatches bind the pipeline destroyed below, entries are recycled when recorded again
+		CommandCache.Invalidate();
+		CommandBuffers.clear();
 		vkDestroyPipeline(pMainDevice->LD, ComputePipeline, nullptr);
 		vkDestroyPipelineLayout(pMainDevice->LD, ComputePipelineLayout, nullptr);
 	}
 
 	void FComputePass::prepareDescriptors()
 	{
-		// 1. Create descriptor pools
-		//-------------------------------------------------------
-		{
-			const uint32_t DescriptorTypeCount = 3;
-			const uint32_t MaxDescriptorsPerType = 10;
-			VkDescriptorPoolSize PoolSize[DescriptorTypeCount] = {};
-			PoolSize[0].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-			PoolSize[0].descriptorCount = MaxDescriptorsPerType;
-			PoolSize[1].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-			PoolSize[1].descriptorCount = MaxDescriptorsPerType;
-			PoolSize[2].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-			PoolSize[2].descriptorCount = MaxDescriptorsPerType;
-
-			VkDescriptorPoolCreateInfo PoolCreateInfo = {};
-			PoolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-			PoolCreateInfo.maxSets = DescriptorTypeCount * MaxDescriptorsPerType;
-			PoolCreateInfo.poolSizeCount = DescriptorTypeCount;
-			PoolCreateInfo.pPoolSizes = PoolSize;
-
-			VkResult Result = vkCreateDescriptorPool(pMainDevice->LD, &PoolCreateInfo, nullptr, &DescriptorPool);
-			RESULT_CHECK(Result, "Failed to create a compute Descriptor Pool");
-		}
-
+		// Sets come from the device's descriptor allocator, which grows with the number of emitters
 		for (size_t i = 0; i < Emitters.size(); ++i)
 		{
 			Emitters[i].ComputeDescriptorSet.CreateDescriptorSetLayout(ComputePass);
-			Emitters[i].ComputeDescriptorSet.AllocateDescriptorSet(DescriptorPool);
+			Emitters[i].ComputeDescriptorSet.AllocateDescriptorSet();
 			Emitters[i].ComputeDescriptorSet.BindDescriptorWithSet();
-
-			Emitters[i].RenderDescriptorSet.CreateDescriptorSetLayout(ParticlePass_frag);
-			Emitters[i].RenderDescriptorSet.AllocateDescriptorSet(DescriptorPool);
-			Emitters[i].RenderDescriptorSet.BindDescriptorWithSet();
 		}
 		
 
@@ -316,8 +216,13 @@ namespace VKE
 		PipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
 		PipelineLayoutCreateInfo.setLayoutCount = 1;
 		PipelineLayoutCreateInfo.pSetLayouts = &SetLayouts;
-		PipelineLayoutCreateInfo.pushConstantRangeCount = 0;
-		PipelineLayoutCreateInfo.pPushConstantRanges = nullptr;
+		// Index of the particle buffer to read from
+		VkPushConstantRange PushConstantRange = {};
+		PushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		PushConstantRange.offset = 0;
+		PushConstantRange.size = sizeof(uint32_t);
+		PipelineLayoutCreateInfo.pushConstantRangeCount = 1;
+		PipelineLayoutCreateInfo.pPushConstantRanges = &PushConstantRange;
 
 		VkResult Result = vkCreatePipelineLayout(pMainDevice->LD, &PipelineLayoutCreateInfo, nullptr, &ComputePipelineLayout);
 		RESULT_CHECK(Result, "Fail to craete comptue pipeline layout.");
@@ -352,33 +257,21 @@ namespace VKE
 		VkCommandPoolCreateInfo cmdPoolInfo = {};
 		cmdPoolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
 		cmdPoolInfo.queueFamilyIndex = pMainDevice->QueueFamilyIndices.computeFamily;
-		cmdPoolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+		cmdPoolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
 		auto Result = vkCreateCommandPool(pMainDevice->LD, &cmdPoolInfo, nullptr, &ComputeCommandPool);
 		RESULT_CHECK(Result, "Fail to create Compute Command Pool\n");
+
+		// Per frame slot pools for the dispatch commands
+		if (!CommandCache.init(pMainDevice, pMainDevice->QueueFamilyIndices.computeFamily, MAX_FRAME_DRAWS * cEmitter::ParticleBufferCount))
+		{
+			printf("Fail to create compute command cache\n");
+		}
 	}
 
 	void FComputePass::createCommandBuffer()
 	{
-		VkCommandBufferAllocateInfo cbAllocInfo = {};
-		cbAllocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-		cbAllocInfo.commandPool = ComputeCommandPool;
-		cbAllocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-
-		cbAllocInfo.commandBufferCount = 1;
-
-		VkResult Result = vkAllocateCommandBuffers(pMainDevice->LD, &cbAllocInfo, &CommandBuffer);
-		RESULT_CHECK(Result, "Fail to allocate compute command buffers.");
+		// Command buffers come from the command cache when recording
+		CommandBuffers.resize(MAX_FRAME_DRAWS, VK_NULL_HANDLE);
 	}
 
-	void FComputePass::createSynchronization()
-	{
-		// 1. Create semaphore
-		{
-			VkSemaphoreCreateInfo SemaphoreCreateInfo = {};
-			SemaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
-
-			VkResult Result = vkCreateSemaphore(pMainDevice->LD, &SemaphoreCreateInfo, nullptr, &OnComputeFinished);
-			RESULT_CHECK(Result, "Fail to create OnComputeFinish Semaphore");
-		}
-	}
 }
\ No newline at end of file
@@ -7,6 +7,7 @@
 #include "BufferFormats.h"
 #include "Descriptors/DescriptorSet.h"
 #include "ParticleSystem/Emitter.h"
+#include "Command/CommandCache.h"
 
 namespace VKE
 {
@@ -24,28 +25,31 @@ namespace VKE
 		bool needSynchronization() const;
 
 		// Command related
-		VkCommandPool ComputeCommandPool;
-		VkCommandBuffer CommandBuffer;
+		VkCommandPool ComputeCommandPool;										// One-off commands on the compute queue
+		// Recorded dispatches per frame slot and read buffer, entry FrameIndex * ParticleBufferCount + ReadBufferIndex
+		// Dispatch parameters come from uniform buffers, only the emitter set and the pipeline need re-recording
+		cCommandCache CommandCache;
+		std::vector<VkCommandBuffer> CommandBuffers;							// Command buffer to submit for each frame slot
 
-		// Descriptor related
-		VkDescriptorPool DescriptorPool;			
-	
 		std::vector<cEmitter> Emitters;											// Emitter for this particles
 
+		// Particle buffer holding the latest simulated particles, drawn by graphics and read by the next dispatch
+		uint32_t ReadBufferIndex = 0;
+		// Graphics timeline value of the last frame drawing each particle buffer, a dispatch writing a buffer waits on it
+		uint64_t BufferGraphicsValues[cEmitter::ParticleBufferCount] = {};
+
 		// Pipeline related
 		VkPipelineLayout ComputePipelineLayout;
 		VkPipeline ComputePipeline;
 
-		// Synchronization related
-		// Signal when compute pass is finished
-		VkSemaphore OnComputeFinished;
-
 		void init(FMainDevice* const iMainDevice);
 
 		void cleanUp();
 
-		// Compute pass commands, no need to re-record like graphic commands
-		void recordComputeCommands();
+		// Make CommandBuffers[FrameIndex] dispatch from ReadBufferIndex to the other particle buffer, recorded only when the cached one is out of date
+		void recordComputeCommands(uint32_t FrameIndex);
+		// Call after submitting the dispatches, the written buffer becomes ReadBufferIndex
+		void swapParticleBuffers();
 
 		void undateUniformBuffer();
 
@@ -62,6 +66,5 @@ namespace VKE
 		void createComputePipeline();
 		void createCommandPool();
 		void createCommandBuffer();
-		void createSynchronization();
 	};
 }
\ No newline at end of file
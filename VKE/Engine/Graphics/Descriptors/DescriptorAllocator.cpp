@@ -0,0 +1,171 @@
+#include "DescriptorAllocator.h"
+#include "Utilities.h"
+
+#include "assert.h"
+
+namespace VKE
+{
+	namespace
+	{
+		// Descriptors per set of every type the engine's set layouts use, a pool of N sets gets N times these
+		// Frame data / object table / emitters use buffers, the third pass two input attachments, textures live in the texture table
+		// Emitters keep their per frame uniform data in two dynamic uniform buffers
+		const VkDescriptorPoolSize DESCRIPTORS_PER_SET[] =
+		{
+			{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1 },
+			{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 2 },
+			{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2 },
+			{ VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, 2 },
+		};
+		const uint32_t DESCRIPTOR_TYPE_COUNT = sizeof(DESCRIPTORS_PER_SET) / sizeof(DESCRIPTORS_PER_SET[0]);
+	}
+
+	bool cDescriptorAllocator::init(FMainDevice* iMainDevice, uint32_t iFrameCount, uint32_t iInitialSetsPerPool)
+	{
+		assert(iMainDevice && iFrameCount > 0 && iInitialSetsPerPool > 0);
+		pMainDevice = iMainDevice;
+		PersistentChain = FPoolChain();
+		PersistentChain.NextSetCount = iInitialSetsPerPool;
+		// Transient sets are few per frame, their pools start small
+		FrameChains.assign(iFrameCount, FPoolChain());
+		for (FPoolChain& Chain : FrameChains)
+		{
+			Chain.NextSetCount = iInitialSetsPerPool / 4 > 0 ? iInitialSetsPerPool / 4 : 1;
+		}
+		return true;
+	}
+
+	void cDescriptorAllocator::cleanUp()
+	{
+		std::lock_guard<std::mutex> Lock(Mutex);
+		destroyChain(PersistentChain);
+		for (FPoolChain& Chain : FrameChains)
+		{
+			destroyChain(Chain);
+		}
+		FrameChains.clear();
+	}
+
+	VkDescriptorSet cDescriptorAllocator::Allocate(VkDescriptorSetLayout Layout)
+	{
+		std::lock_guard<std::mutex> Lock(Mutex);
+		return allocateFromChain(PersistentChain, Layout);
+	}
+
+	VkDescriptorSet cDescriptorAllocator::AllocateTransient(uint32_t FrameIndex, VkDescriptorSetLayout Layout)
+	{
+		assert(FrameIndex < FrameChains.size());
+		return allocateFromChain(FrameChains[FrameIndex], Layout);
+	}
+
+	void cDescriptorAllocator::ResetFrame(uint32_t FrameIndex)
+	{
+		assert(FrameIndex < FrameChains.size());
+		FPoolChain& Chain = FrameChains[FrameIndex];
+		// Only the pools that have been allocated from since the last reset
+		for (uint32_t i = 0; i < Chain.Pools.size() && i <= Chain.Current; ++i)
+		{
+			VkResult Result = vkResetDescriptorPool(pMainDevice->LD, Chain.Pools[i], 0);
+			RESULT_CHECK_ARGS(Result, "Fail to reset transient descriptor pool[%d]", i);
+		}
+		Chain.Current = 0;
+		Chain.SetCount = 0;
+	}
+
+	FDescriptorAllocatorStats cDescriptorAllocator::GetStats() const
+	{
+		std::lock_guard<std::mutex> Lock(Mutex);
+		FDescriptorAllocatorStats Stats;
+		Stats.PoolCount = static_cast<uint32_t>(PersistentChain.Pools.size());
+		Stats.PersistentSetCount = PersistentChain.SetCount;
+		for (uint32_t Count : PersistentChain.PoolSetCounts)
+		{
+			Stats.PersistentSetCapacity += Count;
+		}
+		for (const FPoolChain& Chain : FrameChains)
+		{
+			Stats.PoolCount += static_cast<uint32_t>(Chain.Pools.size());
+			Stats.TransientSetCount += Chain.SetCount;
+			for (uint32_t Count : Chain.PoolSetCounts)
+			{
+				Stats.TransientSetCapacity += Count;
+			}
+		}
+		return Stats;
+	}
+
+	VkDescriptorSet cDescriptorAllocator::allocateFromChain(FPoolChain& Chain, VkDescriptorSetLayout Layout)
+	{
+		VkDescriptorSetAllocateInfo SetAllocInfo = {};
+		SetAllocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		SetAllocInfo.descriptorSetCount = 1;
+		SetAllocInfo.pSetLayouts = &Layout;
+
+		while (true)
+		{
+			// 1. Next pool of the chain, created when every existing one is exhausted
+			const bool bNewPool = Chain.Current == Chain.Pools.size();
+			if (bNewPool)
+			{
+				VkDescriptorPool Pool = createPool(Chain.NextSetCount);
+				if (Pool == VK_NULL_HANDLE)
+				{
+					return VK_NULL_HANDLE;
+				}
+				Chain.Pools.push_back(Pool);
+				Chain.PoolSetCounts.push_back(Chain.NextSetCount);
+				Chain.NextSetCount *= 2;
+			}
+
+			// 2. Exhausted pools are skipped from now on, any other error is not going to be fixed by another pool
+			SetAllocInfo.descriptorPool = Chain.Pools[Chain.Current];
+			VkDescriptorSet Set = VK_NULL_HANDLE;
+			VkResult Result = vkAllocateDescriptorSets(pMainDevice->LD, &SetAllocInfo, &Set);
+			if (Result == VK_SUCCESS)
+			{
+				++Chain.SetCount;
+				return Set;
+			}
+			// A new pool that cannot hold the set never will, the layout uses a type the pools are not sized for
+			if (bNewPool || (Result != VK_ERROR_OUT_OF_POOL_MEMORY && Result != VK_ERROR_FRAGMENTED_POOL))
+			{
+				RESULT_CHECK(Result, "Fail to Allocate Descriptor Set!");
+				return VK_NULL_HANDLE;
+			}
+			++Chain.Current;
+		}
+	}
+
+	VkDescriptorPool cDescriptorAllocator::createPool(uint32_t SetCount)
+	{
+		VkDescriptorPoolSize PoolSizes[DESCRIPTOR_TYPE_COUNT];
+		for (uint32_t i = 0; i < DESCRIPTOR_TYPE_COUNT; ++i)
+		{
+			PoolSizes[i].type = DESCRIPTORS_PER_SET[i].type;
+			PoolSizes[i].descriptorCount = DESCRIPTORS_PER_SET[i].descriptorCount * SetCount;
+		}
+
+		VkDescriptorPoolCreateInfo PoolCreateInfo = {};
+		PoolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		PoolCreateInfo.maxSets = SetCount;
+		PoolCreateInfo.poolSizeCount = DESCRIPTOR_TYPE_COUNT;
+		PoolCreateInfo.pPoolSizes = PoolSizes;
+
+		VkDescriptorPool Pool = VK_NULL_HANDLE;
+		VkResult Result = vkCreateDescriptorPool(pMainDevice->LD, &PoolCreateInfo, nullptr, &Pool);
+		RESULT_CHECK_ARGS(Result, "Fail to create a descriptor pool of %d sets", SetCount);
+		return Result == VK_SUCCESS ? Pool : VK_NULL_HANDLE;
+	}
+
+	void cDescriptorAllocator::destroyChain(FPoolChain& Chain)
+	{
+		for (VkDescriptorPool Pool : Chain.Pools)
+		{
+			vkDestroyDescriptorPool(pMainDevice->LD, Pool, nullptr);
+		}
+		Chain.Pools.clear();
+		Chain.PoolSetCounts.clear();
+		Chain.Current = 0;
+		Chain.SetCount = 0;
+	}
+}
@@ -0,0 +1,72 @@
+/*
+	DescriptorAllocator hands out descriptor sets from chains of descriptor pools that grow on demand
+	A pool is sized for a number of sets, with a fixed ratio of descriptors of every type the engine uses per set,
+	when a pool is exhausted (out of pool memory / fragmented) the next pool of the chain is used or created, twice as large as the last one
+	1. Persistent sets (frame data, input attachments, emitters, object table) come from one shared chain and live until cleanUp
+	2. Transient sets come from a chain per frame slot, ResetFrame resets all of the slot's pools at once and keeps them for the next frame
+	Sets are never freed one by one, so no pool needs VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT
+*/
+#pragma once
+#define GLFW_INCLUDE_VULKAN
+#include "GLFW/glfw3.h"
+
+#include <vector>
+#include <mutex>
+#include <stdint.h>
+namespace VKE
+{
+	struct FMainDevice;
+
+	struct FDescriptorAllocatorStats
+	{
+		uint32_t PoolCount = 0;					// Persistent + transient pools
+		uint32_t PersistentSetCount = 0;		// Live persistent sets
+		uint32_t PersistentSetCapacity = 0;		// Sets the persistent pools were created for
+		uint32_t TransientSetCount = 0;			// Transient sets allocated by the frame slots since their last reset
+		uint32_t TransientSetCapacity = 0;
+	};
+
+	class cDescriptorAllocator
+	{
+	public:
+		/* Constructors and destructor*/
+		cDescriptorAllocator() {}
+		~cDescriptorAllocator() {}
+		cDescriptorAllocator(const cDescriptorAllocator& i_other) = delete;
+		cDescriptorAllocator& operator = (const cDescriptorAllocator& i_other) = delete;
+
+		bool init(FMainDevice* iMainDevice, uint32_t iFrameCount, uint32_t iInitialSetsPerPool = DEFAULT_SETS_PER_POOL);
+		// Destroys every pool, all sets allocated from the allocator become invalid
+		void cleanUp();
+
+		// Set that lives until cleanUp, returns VK_NULL_HANDLE when no pool can be created
+		VkDescriptorSet Allocate(VkDescriptorSetLayout Layout);
+		// Set that lives until the next ResetFrame of FrameIndex, only the render thread allocates transient sets
+		VkDescriptorSet AllocateTransient(uint32_t FrameIndex, VkDescriptorSetLayout Layout);
+		// Reset the frame slot's pools, only valid when the GPU has finished all work of this slot
+		void ResetFrame(uint32_t FrameIndex);
+
+		FDescriptorAllocatorStats GetStats() const;
+
+		static const uint32_t DEFAULT_SETS_PER_POOL = 64;
+	private:
+		struct FPoolChain
+		{
+			std::vector<VkDescriptorPool> Pools;
+			std::vector<uint32_t> PoolSetCounts;	// Sets each pool was created for
+			uint32_t Current = 0;					// Pools before it are exhausted
+			uint32_t NextSetCount = 0;				// Size of the next pool to create
+			uint32_t SetCount = 0;					// Allocated since creation / the last reset
+		};
+
+		VkDescriptorSet allocateFromChain(FPoolChain& Chain, VkDescriptorSetLayout Layout);
+		VkDescriptorPool createPool(uint32_t SetCount);
+		void destroyChain(FPoolChain& Chain);
+
+		FMainDevice* pMainDevice = nullptr;
+		FPoolChain PersistentChain;
+		std::vector<FPoolChain> FrameChains;
+		// Meshes can be created off the render thread
+		mutable std::mutex Mutex;
+	};
+}
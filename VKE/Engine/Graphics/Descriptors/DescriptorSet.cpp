@@ -2,6 +2,7 @@
 #include "Descriptor_Buffer.h"
 #include "Descriptor_Dynamic.h"
 #include "Descriptor_Image.h"
+#include "DescriptorAllocator.h"
 
 #include <map>
 namespace VKE
@@ -14,7 +15,7 @@ namespace VKE
 		cDescriptor_Buffer* newBufferDescriptor = DBG_NEW cDescriptor_Buffer();
 		newBufferDescriptor->SetDescriptorBufferRange(BufferFormatSize, ObjectCount);
 		newBufferDescriptor->CreateDescriptor(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, Descriptors.size(), ShaderStage, pMainDevice);
-		newBufferDescriptor->CreateBuffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		newBufferDescriptor->CreateBuffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, EMemoryCategory::Uniform);
 		Descriptors.push_back(newBufferDescriptor);
 	}
 
@@ -23,7 +24,7 @@ namespace VKE
 		cDescriptor_DynamicBuffer* newDBufferDescriptor = DBG_NEW cDescriptor_DynamicBuffer();
 		newDBufferDescriptor->SetDescriptorBufferRange(BufferFormatSize, ObjectCount);
 		newDBufferDescriptor->CreateDescriptor(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, Descriptors.size(), ShaderStage, pMainDevice);
-		newDBufferDescriptor->CreateBuffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		newDBufferDescriptor->CreateBuffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, EMemoryCategory::Uniform);
 		Descriptors.push_back(newDBufferDescriptor);
 	}
 
@@ -36,12 +37,12 @@ namespace VKE
 		Descriptors.push_back(newImageDescriptor);
 	}
 
-	void cDescriptorSet::CreateStorageBufferDescriptor(VkDeviceSize BufferFormatSize, uint32_t ObjectCount, VkShaderStageFlags ShaderStage, VkBufferUsageFlags UsageFlags, VkMemoryPropertyFlags MemoryPropertyFlags)
+	void cDescriptorSet::CreateStorageBufferDescriptor(VkDeviceSize BufferFormatSize, uint32_t ObjectCount, VkShaderStageFlags ShaderStage, VkBufferUsageFlags UsageFlags, VkMemoryPropertyFlags MemoryPropertyFlags, EMemoryCategory Category, const std::vector<uint32_t>& SharingQueueFamilies)
 	{
 		cDescriptor_Buffer* newSBufferDescriptor = DBG_NEW cDescriptor_Buffer();
 		newSBufferDescriptor->SetDescriptorBufferRange(BufferFormatSize, ObjectCount);
 		newSBufferDescriptor->CreateDescriptor(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, Descriptors.size(), ShaderStage, pMainDevice);
-		newSBufferDescriptor->CreateBuffer(UsageFlags, MemoryPropertyFlags);
+		newSBufferDescriptor->CreateBuffer(UsageFlags, MemoryPropertyFlags, Category, SharingQueueFamilies);
 
 		Descriptors.push_back(newSBufferDescriptor);
 	}
@@ -75,17 +76,10 @@ namespace VKE
 		
 	}
 
-	void cDescriptorSet::AllocateDescriptorSet(VkDescriptorPool Pool)
+	void cDescriptorSet::AllocateDescriptorSet()
 	{
-		VkDescriptorSetAllocateInfo SetAllocInfo = {};
-		SetAllocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-		SetAllocInfo.descriptorPool = Pool;													// Pool to allocate descriptor set from
-		SetAllocInfo.descriptorSetCount = 1;									// Number of sets to allocate
-		SetAllocInfo.pSetLayouts = &GetDescriptorSetLayout();
-
-		// Allocate descriptor sets (multiple)
-		VkResult Result = vkAllocateDescriptorSets(pMainDevice->LD, &SetAllocInfo, &DescriptorSet);
-		RESULT_CHECK(Result, "Fail to Allocate Descriptor Set!");
+		// The allocator chains another pool when the current one is exhausted, failures are reported there
+		DescriptorSet = pMainDevice->DescriptorAllocator->Allocate(GetDescriptorSetLayout());
 	}
 
 	void cDescriptorSet::BindDescriptorWithSet()
@@ -9,8 +9,6 @@ namespace VKE
 	{
 		FirstPass_vert,
 		ThirdPass_frag,
-		FirstPass_frag,
-		ParticlePass_frag,
 		ComputePass,
 		Invalid = uint8_t(-1),
 	};
@@ -68,13 +66,13 @@ namespace VKE
 
 		void CreateImageBufferDescriptor(cImageBuffer* const & iImageBuffer, VkDescriptorType Type, VkShaderStageFlags ShaderStage, VkImageLayout ImageLayout, VkSampler Sampler = VK_NULL_HANDLE);
 
-		void CreateStorageBufferDescriptor(VkDeviceSize BufferFormatSize, uint32_t ObjectCount, VkShaderStageFlags ShaderStage, VkBufferUsageFlags UsageFlags, VkMemoryPropertyFlags MemoryPropertyFlags);
+		void CreateStorageBufferDescriptor(VkDeviceSize BufferFormatSize, uint32_t ObjectCount, VkShaderStageFlags ShaderStage, VkBufferUsageFlags UsageFlags, VkMemoryPropertyFlags MemoryPropertyFlags, EMemoryCategory Category, const std::vector<uint32_t>& SharingQueueFamilies = {});
 
 		// Create Descriptor set layout
 		void CreateDescriptorSetLayout(EDescriptorSetType iDescriptorType);
 		
-		// Allocate Descriptor Set
-		void AllocateDescriptorSet(VkDescriptorPool Pool);
+		// Allocate Descriptor Set from the device's descriptor allocator, it lives until the allocator is cleaned up
+		void AllocateDescriptorSet();
 		
 		// Bind Descriptor's content to the descriptor set
 		void BindDescriptorWithSet();
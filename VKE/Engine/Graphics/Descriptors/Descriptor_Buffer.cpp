@@ -28,35 +28,73 @@ namespace VKE
 		this->ObjectCount = ObjectCount;
 	}
 
-	void cDescriptor_Buffer::CreateBuffer(VkBufferUsageFlags UsageFlags, VkMemoryPropertyFlags MemoryPropertyFlags)
+	void cDescriptor_Buffer::CreateBuffer(VkBufferUsageFlags UsageFlags, VkMemoryPropertyFlags MemoryPropertyFlags, EMemoryCategory Category, const std::vector<uint32_t>& SharingQueueFamilies)
 	{
 		// Create uniform buffer
-		if (!Buffer.CreateBufferAndAllocateMemory(pMainDevice->PD, pMainDevice->LD, BufferInfo.range * ObjectCount, UsageFlags, MemoryPropertyFlags))
+		if (!Buffer.CreateBufferAndAllocateMemory(pMainDevice, BufferInfo.range * ObjectCount, UsageFlags, MemoryPropertyFlags, Category, SharingQueueFamilies))
 		{
 			return;
 		}
 
 		BufferInfo.buffer = Buffer.GetvkBuffer();
+
+		// Map once for the whole lifetime of the buffer
+		if (MemoryPropertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+		{
+			pMapped = Buffer.Map();
+			// Start from zeros on both sides so the shadow always matches what the GPU sees
+			Shadow.assign(static_cast<size_t>(BufferInfo.range * ObjectCount), 0);
+			memset(pMapped, 0, Shadow.size());
+			Buffer.Flush(0, Shadow.size());
+			WrittenSlotCount = 0;
+		}
 	}
 
 	void cDescriptor_Buffer::UpdateBufferData(void* srcData)
 	{
-		void * pData = nullptr;
-		vkMapMemory(Buffer.GetDevice(), Buffer.GetMemory(), 0, BufferInfo.range, 0, &pData);
-		memcpy(pData, srcData, static_cast<size_t>(BufferInfo.range));
-		vkUnmapMemory(Buffer.GetDevice(), Buffer.GetMemory());
+		UpdatePartialData(srcData, 0, BufferInfo.range);
 	}
 
 	void cDescriptor_Buffer::UpdatePartialData(void * srcData, VkDeviceSize Offset, VkDeviceSize Size)
 	{
-		void* pData = nullptr;
-		vkMapMemory(Buffer.GetDevice(), Buffer.GetMemory(), Offset, Size, 0, &pData);
-		memcpy(pData, srcData, static_cast<size_t>(Size));
-		vkUnmapMemory(Buffer.GetDevice(), Buffer.GetMemory());
+		assert(pMapped && Offset + Size <= Shadow.size());
+		const char* pSrc = static_cast<const char*>(srcData);
+		const size_t SlotSize = static_cast<size_t>(BufferInfo.range);
+
+		// 1. Find the first and last slot that differ from what the GPU already has
+		size_t DirtyBegin = static_cast<size_t>(Size);
+		size_t DirtyEnd = 0;
+		for (size_t Begin = 0; Begin < Size; Begin += SlotSize)
+		{
+			const size_t Length = Begin + SlotSize < Size ? SlotSize : static_cast<size_t>(Size) - Begin;
+			if (memcmp(&Shadow[static_cast<size_t>(Offset) + Begin], pSrc + Begin, Length) != 0)
+			{
+				DirtyBegin = Begin < DirtyBegin ? Begin : DirtyBegin;
+				DirtyEnd = Begin + Length;
+				++WrittenSlotCount;
+			}
+		}
+		if (DirtyEnd == 0)
+		{
+			return;
+		}
+
+		// 2. Write the dirty range to the shadow and the mapped memory, then flush it if the memory is not coherent
+		const size_t DirtyOffset = static_cast<size_t>(Offset) + DirtyBegin;
+		const size_t DirtySize = DirtyEnd - DirtyBegin;
+		memcpy(&Shadow[DirtyOffset], pSrc + DirtyBegin, DirtySize);
+		memcpy(static_cast<char*>(pMapped) + DirtyOffset, pSrc + DirtyBegin, DirtySize);
+		Buffer.Flush(DirtyOffset, DirtySize);
 	}
 
 	void cDescriptor_Buffer::cleanUp()
 	{
+		if (pMapped)
+		{
+			Buffer.Unmap();
+			pMapped = nullptr;
+		}
+		Shadow.clear();
 		Buffer.cleanUp();
 	}
 
@@ -23,11 +23,15 @@ namespace VKE
 
 		// Calculate the buffer size, different types of buffers should have different size calculations
 		virtual void SetDescriptorBufferRange(VkDeviceSize BufferFormatSize, uint32_t ObjectCount);
-		virtual void CreateBuffer(VkBufferUsageFlags UsageFlags, VkMemoryPropertyFlags MemoryPropertyFlags);
+		virtual void CreateBuffer(VkBufferUsageFlags UsageFlags, VkMemoryPropertyFlags MemoryPropertyFlags, EMemoryCategory Category, const std::vector<uint32_t>& SharingQueueFamilies = {});
 		/* Update Function */
-		// Update the full memory block
+		// Host visible buffers stay mapped from CreateBuffer to cleanUp, updates are compared with a CPU shadow copy
+		// and only the slots that changed are written (and flushed for non-coherent memory)
+		// Update the first slot
 		void UpdateBufferData(void* srcData);
 		void UpdatePartialData(void * srcData, VkDeviceSize Offset, VkDeviceSize Size);
+		// Slots written to the GPU since creation, for profiling
+		uint64_t GetWrittenSlotCount() const { return WrittenSlotCount; }
 
 		/* Clean up Function */
 		virtual void cleanUp();
@@ -51,6 +55,11 @@ namespace VKE
 		// Object count should be considered in allocating memory
 		uint32_t ObjectCount;
 
+		// Persistent mapping of host visible buffers and the last data written to it
+		void* pMapped = nullptr;
+		std::vector<char> Shadow;
+		uint64_t WrittenSlotCount = 0;
+
 	};
 
 }
\ No newline at end of file
@@ -33,7 +33,8 @@ namespace VKE
 	void cDescriptor_DynamicBuffer::allocateDynamicBufferTransferSpace()
 	{
 		// Create space in memory to hold dynamic buffer that is aligned to our required alignment
-		pAllocatedTransferSpace = _aligned_malloc(static_cast<size_t>(BufferInfo.range * ObjectCount), static_cast<size_t>(BufferInfo.range));
+		// The slot size is only a multiple of the alignment, the alignment itself is the power of two _aligned_malloc needs
+		pAllocatedTransferSpace = _aligned_malloc(static_cast<size_t>(BufferInfo.range * ObjectCount), static_cast<size_t>(GetMinUniformOffsetAlignment()));
 	}
 
 }
\ No newline at end of file
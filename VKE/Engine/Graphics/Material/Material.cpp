@@ -0,0 +1,55 @@
+#include "Material.h"
+
+#include <assert.h>
+#include <map>
+
+namespace VKE
+{
+	std::map<FMaterialDesc, uint32_t> s_MaterialContainer;
+	std::vector<std::unique_ptr<VKE::cMaterial>> s_MaterialList;
+
+	void cMaterial::Init()
+	{
+		// The default material always takes ID 0
+		assert(s_MaterialList.empty());
+		s_MaterialList.push_back(std::make_unique<cMaterial>(0, FMaterialDesc()));
+		s_MaterialContainer.insert({ FMaterialDesc(), 0 });
+	}
+
+	const cMaterial* cMaterial::Load(const FMaterialDesc& iDesc)
+	{
+		assert(!s_MaterialList.empty());
+		auto It = s_MaterialContainer.find(iDesc);
+		if (It != s_MaterialContainer.end())
+		{
+			return s_MaterialList[It->second].get();
+		}
+		// Not exist
+		const uint32_t NewID = static_cast<uint32_t>(s_MaterialList.size());
+		s_MaterialList.push_back(std::make_unique<cMaterial>(NewID, iDesc));
+		s_MaterialContainer.insert({ iDesc, NewID });
+		return s_MaterialList.back().get();
+	}
+
+	const cMaterial* cMaterial::Get(uint32_t ID)
+	{
+		assert(!s_MaterialList.empty());
+		if (ID >= s_MaterialList.size())
+		{
+			printf("ERROR: Material ID is larger than the list! Returning default material\n");
+			return s_MaterialList[0].get();
+		}
+		return s_MaterialList[ID].get();
+	}
+
+	uint32_t cMaterial::GetCount()
+	{
+		return static_cast<uint32_t>(s_MaterialList.size());
+	}
+
+	void cMaterial::Free()
+	{
+		s_MaterialContainer.clear();
+		s_MaterialList.clear();
+	}
+}
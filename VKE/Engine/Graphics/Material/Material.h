@@ -0,0 +1,50 @@
+/*
+	Material is what a draw needs besides its geometry, shared by every mesh / emitter using the same textures
+	Materials are deduplicated by their description, an imported model with hundreds of meshes ends up with one material per unique texture set
+	Material IDs are dense and handed out in creation order, ID 0 is the default white material,
+	so an ID fits into a sort key and indexes a per-material table
+	Textures are sampled from the texture table, so a material needs no descriptor set of its own, it resolves to texture table slots
+	Init / Load / Free only run on the render thread, Get can be called from recording jobs and never modifies the list
+*/
+#pragma once
+#include "Texture/Texture.h"
+
+#include <memory>
+#include <vector>
+#include <stdint.h>
+namespace VKE
+{
+	struct FMaterialDesc
+	{
+		int AlbedoTextureID = EDefaultTextureID::White;			// Slot in the texture table
+
+		bool operator < (const FMaterialDesc& i_other) const { return AlbedoTextureID < i_other.AlbedoTextureID; }
+	};
+
+	class cMaterial
+	{
+	public:
+		// Create the default material, must be called before any Load / Get
+		static void Init();
+		// Material of this description, created the first time it is asked for
+		static const cMaterial* Load(const FMaterialDesc& iDesc);
+		// Default material for invalid IDs
+		static const cMaterial* Get(uint32_t ID);
+		static uint32_t GetCount();
+		// Free all materials
+		static void Free();
+
+		cMaterial(uint32_t iID, const FMaterialDesc& iDesc) : ID(iID), Desc(iDesc) {}
+		cMaterial(const cMaterial& i_other) = delete;
+		cMaterial& operator = (const cMaterial& i_other) = delete;
+		~cMaterial() {}
+
+		/** Getters */
+		uint32_t GetID() const { return ID; }
+		uint32_t GetAlbedoTextureID() const { return static_cast<uint32_t>(Desc.AlbedoTextureID); }
+		const FMaterialDesc& GetDesc() const { return Desc; }
+	private:
+		uint32_t ID;
+		FMaterialDesc Desc;
+	};
+}
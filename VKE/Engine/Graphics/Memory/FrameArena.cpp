@@ -0,0 +1,108 @@
+#include "FrameArena.h"
+
+#include "assert.h"
+
+namespace VKE
+{
+	bool cFrameArena::init(uint32_t iFrameCount, size_t iSlotSize)
+	{
+		assert(iFrameCount > 0 && iSlotSize > 0);
+		cleanUp();
+		Slots.resize(iFrameCount);
+		for (FSlot& Slot : Slots)
+		{
+			Slot.pBlock = new char[iSlotSize];
+			Slot.Size = iSlotSize;
+			Slot.pCurrent = Slot.pBlock;
+			Slot.CurrentSize = Slot.Size;
+		}
+		CurrentSlot = 0;
+		OverflowCount = 0;
+		return true;
+	}
+
+	void cFrameArena::cleanUp()
+	{
+		for (FSlot& Slot : Slots)
+		{
+			for (char* pOverflow : Slot.Overflows)
+			{
+				delete[] pOverflow;
+			}
+			delete[] Slot.pBlock;
+		}
+		Slots.clear();
+	}
+
+	void cFrameArena::BeginFrame(uint32_t FrameIndex)
+	{
+		assert(FrameIndex < Slots.size());
+		CurrentSlot = FrameIndex;
+		FSlot& Slot = Slots[FrameIndex];
+		// The last frame of this slot did not fit, grow the block so the next one does
+		if (!Slot.Overflows.empty())
+		{
+			for (char* pOverflow : Slot.Overflows)
+			{
+				delete[] pOverflow;
+			}
+			Slot.Overflows.clear();
+			delete[] Slot.pBlock;
+			Slot.Size += Slot.OverflowBytes;
+			Slot.pBlock = new char[Slot.Size];
+			Slot.OverflowBytes = 0;
+		}
+		Slot.pCurrent = Slot.pBlock;
+		Slot.CurrentSize = Slot.Size;
+		Slot.Head = 0;
+		Slot.UsedBytes = 0;
+	}
+
+	void* cFrameArena::Allocate(size_t Size, size_t Alignment)
+	{
+		assert(!Slots.empty() && Alignment > 0 && (Alignment & (Alignment - 1)) == 0);
+		FSlot& Slot = Slots[CurrentSlot];
+		// Align the address, overflow blocks are only aligned to what new[] guarantees
+		auto Carve = [&]() -> void*
+		{
+			const uintptr_t Base = reinterpret_cast<uintptr_t>(Slot.pCurrent);
+			const uintptr_t Aligned = (Base + Slot.Head + Alignment - 1) & ~static_cast<uintptr_t>(Alignment - 1);
+			const size_t NewHead = static_cast<size_t>(Aligned - Base) + Size;
+			if (NewHead > Slot.CurrentSize)
+			{
+				return nullptr;
+			}
+			Slot.UsedBytes += NewHead - Slot.Head;
+			Slot.Head = NewHead;
+			return reinterpret_cast<void*>(Aligned);
+		};
+
+		void* pData = Carve();
+		if (pData)
+		{
+			return pData;
+		}
+		// Overflow, at least as large as the slot so a frame that is slightly too big does not end up with many small blocks
+		const size_t OverflowSize = Size + Alignment > Slot.Size ? Size + Alignment : Slot.Size;
+		char* pOverflow = new char[OverflowSize];
+		Slot.Overflows.push_back(pOverflow);
+		Slot.OverflowBytes += OverflowSize;
+		++OverflowCount;
+		Slot.pCurrent = pOverflow;
+		Slot.CurrentSize = OverflowSize;
+		Slot.Head = 0;
+		pData = Carve();
+		assert(pData);
+		return pData;
+	}
+
+	size_t cFrameArena::GetUsedBytes() const
+	{
+		return Slots.empty() ? 0 : Slots[CurrentSlot].UsedBytes;
+	}
+
+	size_t cFrameArena::GetSlotSize() const
+	{
+		return Slots.empty() ? 0 : Slots[CurrentSlot].Size;
+	}
+}
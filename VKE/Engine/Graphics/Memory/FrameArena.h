@@ -0,0 +1,87 @@
+/*
+	FrameArena is a linear (bump) allocator for CPU data that only lives for one frame, e.g. submit infos, barrier lists, record tasks
+	Every frame slot owns one block, BeginFrame rewinds the slot once its GPU work is finished, nothing is freed one by one
+	A frame that needs more than its block takes the rest from overflow blocks, the slot's block grows to fit them on its next BeginFrame,
+	so after the first few frames a steady state frame does not touch the general purpose heap at all
+	cFrameAllocator adapts the arena to STL containers, deallocate does nothing and the memory goes back with the whole frame
+	Only the render thread allocates from the arena
+*/
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <stdint.h>
+namespace VKE
+{
+	class cFrameArena
+	{
+	public:
+		/* Constructors and destructor*/
+		cFrameArena() {}
+		~cFrameArena() { cleanUp(); }
+		cFrameArena(const cFrameArena& i_other) = delete;
+		cFrameArena& operator = (const cFrameArena& i_other) = delete;
+
+		bool init(uint32_t iFrameCount, size_t iSlotSize = DEFAULT_SLOT_SIZE);
+		void cleanUp();
+
+		// Rewind a frame slot and allocate from it until the next BeginFrame, everything it handed out in its previous frame is invalid
+		void BeginFrame(uint32_t FrameIndex);
+
+		// Uninitialized memory that lives until the current slot's next BeginFrame
+		void* Allocate(size_t Size, size_t Alignment = alignof(std::max_align_t));
+		template <class T>
+		T* AllocateArray(size_t Count) { return static_cast<T*>(Allocate(sizeof(T) * Count, alignof(T))); }
+
+		// Bytes the current frame has allocated so far, overflow included
+		size_t GetUsedBytes() const;
+		size_t GetSlotSize() const;
+		// Number of heap allocations made because a frame did not fit into its slot, a steady state frame does not increase it
+		uint64_t GetOverflowCount() const { return OverflowCount; }
+
+		static const size_t DEFAULT_SLOT_SIZE = 64 * 1024;
+	private:
+		struct FSlot
+		{
+			char* pBlock = nullptr;
+			size_t Size = 0;
+			// Block allocations are carved from, the slot's own block or the latest overflow block
+			char* pCurrent = nullptr;
+			size_t CurrentSize = 0;
+			size_t Head = 0;
+			size_t UsedBytes = 0;
+			std::vector<char*> Overflows;
+			size_t OverflowBytes = 0;
+		};
+
+		std::vector<FSlot> Slots;
+		uint32_t CurrentSlot = 0;
+		uint64_t OverflowCount = 0;
+	};
+
+	// STL allocator on top of a cFrameArena, containers using it must not outlive the frame they were filled in
+	template <class T>
+	class cFrameAllocator
+	{
+	public:
+		typedef T value_type;
+
+		cFrameAllocator(cFrameArena& iArena) : pArena(&iArena) {}
+		template <class U>
+		cFrameAllocator(const cFrameAllocator<U>& i_other) : pArena(i_other.GetArena()) {}
+
+		T* allocate(size_t Count) { return pArena->AllocateArray<T>(Count); }
+		void deallocate(T*, size_t) {}
+
+		cFrameArena* GetArena() const { return pArena; }
+		template <class U>
+		bool operator == (const cFrameAllocator<U>& i_other) const { return pArena == i_other.GetArena(); }
+		template <class U>
+		bool operator != (const cFrameAllocator<U>& i_other) const { return pArena != i_other.GetArena(); }
+	private:
+		cFrameArena* pArena;
+	};
+
+	template <class T>
+	using FrameVector = std::vector<T, cFrameAllocator<T>>;
+}
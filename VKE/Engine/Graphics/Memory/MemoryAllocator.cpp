@@ -0,0 +1,682 @@
+#include "MemoryAllocator.h"
+#include "Utilities.h"
+
+#include "assert.h"
+
+namespace VKE
+{
+	const char* GetMemoryCategoryName(EMemoryCategory Category)
+	{
+		switch (Category)
+		{
+		case EMemoryCategory::Mesh: return "Mesh";
+		case EMemoryCategory::Texture: return "Texture";
+		case EMemoryCategory::Attachment: return "Attachment";
+		case EMemoryCategory::Uniform: return "Uniform";
+		case EMemoryCategory::Particle: return "Particle";
+		case EMemoryCategory::Staging: return "Staging";
+		default: return "Other";
+		}
+	}
+
+	bool cMemoryAllocator::init(VkPhysicalDevice iPD, VkDevice iLD, bool iMemoryBudget, VkDeviceSize iBlockSize)
+	{
+		// Buddy nodes halve the block, it has to be a power of two
+		assert(iBlockSize >= MIN_BUDDY_SIZE && (iBlockSize & (iBlockSize - 1)) == 0);
+		PD = iPD;
+		LD = iLD;
+		BlockSize = iBlockSize;
+		bMemoryBudget = iMemoryBudget;
+		vkGetPhysicalDeviceMemoryProperties(PD, &MemoryProperties);
+
+		VkPhysicalDeviceProperties DeviceProperties;
+		vkGetPhysicalDeviceProperties(PD, &DeviceProperties);
+		MaxAllocationCount = DeviceProperties.limits.maxMemoryAllocationCount;
+		NonCoherentAtomSize = DeviceProperties.limits.nonCoherentAtomSize;
+
+		Pools.clear();
+		Stats = FMemoryStats();
+		for (VkDeviceSize& Bytes : HeapBytes)
+		{
+			Bytes = 0;
+		}
+		return true;
+	}
+
+	void cMemoryAllocator::cleanUp()
+	{
+		std::lock_guard<std::mutex> Lock(Mutex);
+		if (Stats.ResourceCount > 0)
+		{
+			printf("cMemoryAllocator::cleanUp(): %d allocations are still alive\n", Stats.ResourceCount);
+		}
+		for (FPool& Pool : Pools)
+		{
+			for (FBlock& Block : Pool.Blocks)
+			{
+				releaseBlock(Pool, Block);
+			}
+		}
+		Pools.clear();
+	}
+
+	bool cMemoryAllocator::AllocateForBuffer(VkBuffer Buffer, VkMemoryPropertyFlags Properties, EMemoryStrategy Strategy, EMemoryCategory Category, FMemoryAllocation& oAllocation)
+	{
+		// Get buffer memory requirements, and whether the driver wants it in its own memory
+		VkMemoryDedicatedRequirements DedicatedRequirements = {};
+		DedicatedRequirements.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS;
+		VkMemoryRequirements2 MemRequirements = {};
+		MemRequirements.sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2;
+		MemRequirements.pNext = &DedicatedRequirements;
+		VkBufferMemoryRequirementsInfo2 RequirementsInfo = {};
+		RequirementsInfo.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_REQUIREMENTS_INFO_2;
+		RequirementsInfo.buffer = Buffer;
+		vkGetBufferMemoryRequirements2(LD, &RequirementsInfo, &MemRequirements);
+
+		if (DedicatedRequirements.prefersDedicatedAllocation || DedicatedRequirements.requiresDedicatedAllocation)
+		{
+			Strategy = EMemoryStrategy::Dedicated;
+		}
+		if (!allocate(MemRequirements.memoryRequirements, Properties, Strategy, Category, false, Buffer, VK_NULL_HANDLE, oAllocation))
+		{
+			return false;
+		}
+
+		VkResult Result = vkBindBufferMemory(LD, Buffer, oAllocation.Memory, oAllocation.Offset);
+		RESULT_CHECK(Result, "Fail to bind buffer with memory.");
+		if (Result != VK_SUCCESS)
+		{
+			Free(oAllocation);
+			return false;
+		}
+		return true;
+	}
+
+	bool cMemoryAllocator::AllocateForImage(VkImage Image, VkMemoryPropertyFlags Properties, EMemoryCategory Category, FMemoryAllocation& oAllocation)
+	{
+		// Get image memory requirements, and whether the driver wants it in its own memory
+		VkMemoryDedicatedRequirements DedicatedRequirements = {};
+		DedicatedRequirements.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS;
+		VkMemoryRequirements2 MemRequirements = {};
+		MemRequirements.sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2;
+		MemRequirements.pNext = &DedicatedRequirements;
+		VkImageMemoryRequirementsInfo2 RequirementsInfo = {};
+		RequirementsInfo.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_REQUIREMENTS_INFO_2;
+		RequirementsInfo.image = Image;
+		vkGetImageMemoryRequirements2(LD, &RequirementsInfo, &MemRequirements);
+
+		// Render targets usually prefer dedicated memory, textures end up in the buddy pools
+		EMemoryStrategy Strategy = EMemoryStrategy::Buddy;
+		if (DedicatedRequirements.prefersDedicatedAllocation || DedicatedRequirements.requiresDedicatedAllocation)
+		{
+			Strategy = EMemoryStrategy::Dedicated;
+		}
+		if (!allocate(MemRequirements.memoryRequirements, Properties, Strategy, Category, true, VK_NULL_HANDLE, Image, oAllocation))
+		{
+			return false;
+		}
+
+		VkResult Result = vkBindImageMemory(LD, Image, oAllocation.Memory, oAllocation.Offset);
+		RESULT_CHECK(Result, "Fail to bind image with memory.");
+		if (Result != VK_SUCCESS)
+		{
+			Free(oAllocation);
+			return false;
+		}
+		return true;
+	}
+
+	void cMemoryAllocator::Free(FMemoryAllocation& ioAllocation)
+	{
+		if (!ioAllocation.IsValid())
+		{
+			return;
+		}
+		std::lock_guard<std::mutex> Lock(Mutex);
+		--Stats.ResourceCount;
+		FMemoryStats::FCategory& Category = Stats.Categories[static_cast<size_t>(ioAllocation.Category)];
+		--Category.ResourceCount;
+		Category.Bytes -= ioAllocation.Size;
+		if (ioAllocation.Strategy == EMemoryStrategy::Dedicated)
+		{
+			vkFreeMemory(LD, ioAllocation.Memory, nullptr);
+			--Stats.DeviceAllocationCount;
+			Stats.DedicatedBytes -= ioAllocation.Size;
+			HeapBytes[MemoryProperties.memoryTypes[ioAllocation.MemoryTypeIndex].heapIndex] -= ioAllocation.Size;
+			ioAllocation = FMemoryAllocation();
+			return;
+		}
+
+		FPool& Pool = Pools[ioAllocation.PoolIndex];
+		FBlock& Block = Pool.Blocks[ioAllocation.BlockIndex];
+		if (Pool.Strategy == EMemoryStrategy::Buddy)
+		{
+			freeBuddy(Block, ioAllocation.Offset, ioAllocation.BuddyLevel);
+		}
+		else
+		{
+			Stats.UsedBytes -= ioAllocation.Size;
+		}
+
+		--Block.AllocationCount;
+		if (Block.AllocationCount == 0)
+		{
+			// Linear block is free again from the start
+			Block.Head = 0;
+			// Keep one block of the pool around so a load / free pattern does not allocate device memory every time
+			uint32_t LiveBlockCount = 0;
+			for (const FBlock& Other : Pool.Blocks)
+			{
+				LiveBlockCount += Other.Memory != VK_NULL_HANDLE ? 1 : 0;
+			}
+			if (LiveBlockCount > 1)
+			{
+				releaseBlock(Pool, Block);
+			}
+		}
+		ioAllocation = FMemoryAllocation();
+	}
+
+	void* cMemoryAllocator::Map(const FMemoryAllocation& Allocation)
+	{
+		assert(Allocation.IsValid());
+		assert(MemoryProperties.memoryTypes[Allocation.MemoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+		void* pData = nullptr;
+		if (Allocation.Strategy == EMemoryStrategy::Dedicated)
+		{
+			VkResult Result = vkMapMemory(LD, Allocation.Memory, 0, Allocation.Size, 0, &pData);
+			RESULT_CHECK(Result, "Fail to map memory.");
+			return pData;
+		}
+
+		std::lock_guard<std::mutex> Lock(Mutex);
+		FBlock& Block = Pools[Allocation.PoolIndex].Blocks[Allocation.BlockIndex];
+		// The whole block is mapped once and shared by every allocation inside it
+		if (Block.MapCount == 0)
+		{
+			VkResult Result = vkMapMemory(LD, Block.Memory, 0, VK_WHOLE_SIZE, 0, &Block.pMapped);
+			RESULT_CHECK(Result, "Fail to map memory.");
+			if (Result != VK_SUCCESS)
+			{
+				return nullptr;
+			}
+		}
+		++Block.MapCount;
+		return static_cast<char*>(Block.pMapped) + Allocation.Offset;
+	}
+
+	void cMemoryAllocator::Unmap(const FMemoryAllocation& Allocation)
+	{
+		assert(Allocation.IsValid());
+		if (Allocation.Strategy == EMemoryStrategy::Dedicated)
+		{
+			vkUnmapMemory(LD, Allocation.Memory);
+			return;
+		}
+
+		std::lock_guard<std::mutex> Lock(Mutex);
+		FBlock& Block = Pools[Allocation.PoolIndex].Blocks[Allocation.BlockIndex];
+		assert(Block.MapCount > 0);
+		if (--Block.MapCount == 0)
+		{
+			vkUnmapMemory(LD, Block.Memory);
+			Block.pMapped = nullptr;
+		}
+	}
+
+	void cMemoryAllocator::Flush(const FMemoryAllocation& Allocation, VkDeviceSize Offset, VkDeviceSize Size)
+	{
+		if (Size == 0 || IsCoherent(Allocation))
+		{
+			return;
+		}
+		const VkMappedMemoryRange Range = getMappedRange(Allocation, Offset, Size);
+		VkResult Result = vkFlushMappedMemoryRanges(LD, 1, &Range);
+		RESULT_CHECK(Result, "Fail to flush mapped memory.");
+	}
+
+	void cMemoryAllocator::Invalidate(const FMemoryAllocation& Allocation, VkDeviceSize Offset, VkDeviceSize Size)
+	{
+		if (Size == 0 || IsCoherent(Allocation))
+		{
+			return;
+		}
+		const VkMappedMemoryRange Range = getMappedRange(Allocation, Offset, Size);
+		VkResult Result = vkInvalidateMappedMemoryRanges(LD, 1, &Range);
+		RESULT_CHECK(Result, "Fail to invalidate mapped memory.");
+	}
+
+	VkMappedMemoryRange cMemoryAllocator::getMappedRange(const FMemoryAllocation& Allocation, VkDeviceSize Offset, VkDeviceSize Size) const
+	{
+		// Flushed / invalidated ranges have to start and end on nonCoherentAtomSize, unless they end at the end of the memory object
+		VkDeviceSize MemorySize = Allocation.Size;
+		if (Allocation.Strategy != EMemoryStrategy::Dedicated)
+		{
+			std::lock_guard<std::mutex> Lock(Mutex);
+			MemorySize = Pools[Allocation.PoolIndex].Blocks[Allocation.BlockIndex].Size;
+		}
+		const VkDeviceSize Begin = (Allocation.Offset + Offset) / NonCoherentAtomSize * NonCoherentAtomSize;
+		const VkDeviceSize End = (Allocation.Offset + Offset + Size + NonCoherentAtomSize - 1) / NonCoherentAtomSize * NonCoherentAtomSize;
+
+		VkMappedMemoryRange Range = {};
+		Range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+		Range.memory = Allocation.Memory;
+		Range.offset = Begin;
+		Range.size = End < MemorySize ? End - Begin : VK_WHOLE_SIZE;
+		return Range;
+	}
+
+	bool cMemoryAllocator::IsCoherent(const FMemoryAllocation& Allocation) const
+	{
+		return (MemoryProperties.memoryTypes[Allocation.MemoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+	}
+
+	FMemoryStats cMemoryAllocator::GetStats() const
+	{
+		std::lock_guard<std::mutex> Lock(Mutex);
+		FMemoryStats Result = Stats;
+		// Free ranges are only known by the blocks, collect them here instead of on every allocation
+		for (const FPool& Pool : Pools)
+		{
+			for (const FBlock& Block : Pool.Blocks)
+			{
+				if (Block.Memory == VK_NULL_HANDLE)
+				{
+					continue;
+				}
+				VkDeviceSize FreeBytes = 0;
+				VkDeviceSize LargestFreeBytes = 0;
+				if (Pool.Strategy == EMemoryStrategy::Buddy)
+				{
+					for (uint32_t Level = 0; Level < Block.FreeNodes.size(); ++Level)
+					{
+						const VkDeviceSize NodeSize = Block.Size >> Level;
+						FreeBytes += NodeSize * Block.FreeNodes[Level].size();
+						if (LargestFreeBytes == 0 && !Block.FreeNodes[Level].empty())
+						{
+							LargestFreeBytes = NodeSize;
+						}
+					}
+				}
+				else
+				{
+					// Memory before the head is only reused once the whole block is free
+					FreeBytes = Block.Size - Block.Head;
+					LargestFreeBytes = FreeBytes;
+				}
+				Result.FreeBytes += FreeBytes;
+				Result.LargestFreeBytes += LargestFreeBytes;
+			}
+		}
+		return Result;
+	}
+
+	uint32_t cMemoryAllocator::GetHeapBudgets(FHeapBudget (&oBudgets)[VK_MAX_MEMORY_HEAPS]) const
+	{
+		std::lock_guard<std::mutex> Lock(Mutex);
+		queryHeapBudgets(oBudgets);
+		return MemoryProperties.memoryHeapCount;
+	}
+
+	bool cMemoryAllocator::allocate(const VkMemoryRequirements& Requirements, VkMemoryPropertyFlags Properties, EMemoryStrategy Strategy, EMemoryCategory Category, bool bOptimalImage, VkBuffer DedicatedBuffer, VkImage DedicatedImage, FMemoryAllocation& oAllocation)
+	{
+		const uint32_t MemoryTypeIndex = findMemoryType(Requirements.memoryTypeBits, Properties);
+		if (MemoryTypeIndex == static_cast<uint32_t>(-1))
+		{
+			printf("cMemoryAllocator: no memory type with properties 0x%x\n", Properties);
+			return false;
+		}
+
+		std::lock_guard<std::mutex> Lock(Mutex);
+		if (Strategy != EMemoryStrategy::Dedicated)
+		{
+			const uint32_t PoolIndex = getPoolIndex(MemoryTypeIndex, bOptimalImage, Strategy);
+			// Large resources would waste most of a block
+			if (Requirements.size <= Pools[PoolIndex].BlockSize / 2
+				&& allocateFromPool(PoolIndex, Requirements.size, Requirements.alignment, oAllocation))
+			{
+				trackAllocation(Category, oAllocation);
+				return true;
+			}
+		}
+		if (!allocateDedicated(Requirements, MemoryTypeIndex, DedicatedBuffer, DedicatedImage, oAllocation))
+		{
+			return false;
+		}
+		trackAllocation(Category, oAllocation);
+		return true;
+	}
+
+	void cMemoryAllocator::trackAllocation(EMemoryCategory Category, FMemoryAllocation& ioAllocation)
+	{
+		ioAllocation.Category = Category;
+		++Stats.ResourceCount;
+		const VkDeviceSize TotalBytes = Stats.UsedBytes + Stats.DedicatedBytes;
+		Stats.PeakBytes = TotalBytes > Stats.PeakBytes ? TotalBytes : Stats.PeakBytes;
+
+		FMemoryStats::FCategory& CategoryStats = Stats.Categories[static_cast<size_t>(Category)];
+		++CategoryStats.ResourceCount;
+		CategoryStats.Bytes += ioAllocation.Size;
+		CategoryStats.PeakBytes = CategoryStats.Bytes > CategoryStats.PeakBytes ? CategoryStats.Bytes : CategoryStats.PeakBytes;
+	}
+
+	bool cMemoryAllocator::allocateDedicated(const VkMemoryRequirements& Requirements, uint32_t MemoryTypeIndex, VkBuffer Buffer, VkImage Image, FMemoryAllocation& oAllocation)
+	{
+		if (Stats.DeviceAllocationCount >= MaxAllocationCount)
+		{
+			printf("cMemoryAllocator: reached maxMemoryAllocationCount (%d)\n", MaxAllocationCount);
+			return false;
+		}
+		checkBudget(MemoryTypeIndex, Requirements.size);
+		// Tell the driver which resource owns this memory
+		VkMemoryDedicatedAllocateInfo DedicatedInfo = {};
+		DedicatedInfo.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO;
+		DedicatedInfo.buffer = Buffer;
+		DedicatedInfo.image = Image;
+
+		VkMemoryAllocateInfo MemAllocInfo = {};
+		MemAllocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		MemAllocInfo.pNext = &DedicatedInfo;
+		MemAllocInfo.allocationSize = Requirements.size;
+		MemAllocInfo.memoryTypeIndex = MemoryTypeIndex;
+
+		VkDeviceMemory Memory = VK_NULL_HANDLE;
+		VkResult Result = vkAllocateMemory(LD, &MemAllocInfo, nullptr, &Memory);
+		RESULT_CHECK(Result, "Fail to allocate dedicated memory.");
+		if (Result != VK_SUCCESS)
+		{
+			return false;
+		}
+		++Stats.DeviceAllocationCount;
+		Stats.DedicatedBytes += Requirements.size;
+		HeapBytes[MemoryProperties.memoryTypes[MemoryTypeIndex].heapIndex] += Requirements.size;
+
+		oAllocation = FMemoryAllocation();
+		oAllocation.Memory = Memory;
+		oAllocation.Offset = 0;
+		oAllocation.Size = Requirements.size;
+		oAllocation.MemoryTypeIndex = MemoryTypeIndex;
+		oAllocation.Strategy = EMemoryStrategy::Dedicated;
+		return true;
+	}
+
+	bool cMemoryAllocator::allocateFromPool(uint32_t PoolIndex, VkDeviceSize Size, VkDeviceSize Alignment, FMemoryAllocation& oAllocation)
+	{
+		FPool& Pool = Pools[PoolIndex];
+		VkDeviceSize Offset = 0;
+		uint32_t Level = 0;
+		auto TryBlock = [&](FBlock& Block) -> bool
+		{
+			return Pool.Strategy == EMemoryStrategy::Buddy ? allocateBuddy(Block, Size, Alignment, Offset, Level) : allocateLinear(Block, Size, Alignment, Offset);
+		};
+
+		// 1. Existing blocks
+		uint32_t BlockIndex = 0;
+		bool bFound = false;
+		for (; BlockIndex < Pool.Blocks.size(); ++BlockIndex)
+		{
+			FBlock& Block = Pool.Blocks[BlockIndex];
+			if (Block.Memory != VK_NULL_HANDLE && TryBlock(Block))
+			{
+				bFound = true;
+				break;
+			}
+		}
+		// 2. New block
+		if (!bFound)
+		{
+			if (!createBlock(Pool, BlockIndex) || !TryBlock(Pool.Blocks[BlockIndex]))
+			{
+				return false;
+			}
+		}
+
+		FBlock& Block = Pool.Blocks[BlockIndex];
+		++Block.AllocationCount;
+		if (Pool.Strategy == EMemoryStrategy::Linear)
+		{
+			Stats.UsedBytes += Size;
+		}
+
+		oAllocation = FMemoryAllocation();
+		oAllocation.Memory = Block.Memory;
+		oAllocation.Offset = Offset;
+		oAllocation.Size = Size;
+		oAllocation.MemoryTypeIndex = Pool.MemoryTypeIndex;
+		oAllocation.Strategy = Pool.Strategy;
+		oAllocation.PoolIndex = PoolIndex;
+		oAllocation.BlockIndex = BlockIndex;
+		oAllocation.BuddyLevel = Level;
+		return true;
+	}
+
+	bool cMemoryAllocator::allocateBuddy(FBlock& Block, VkDeviceSize Size, VkDeviceSize Alignment, VkDeviceSize& oOffset, uint32_t& oLevel)
+	{
+		// Nodes are aligned to their own size, so a node at least as large as the alignment satisfies it
+		VkDeviceSize NodeSize = MIN_BUDDY_SIZE;
+		while (NodeSize < Size || NodeSize < Alignment)
+		{
+			NodeSize <<= 1;
+		}
+		if (NodeSize > Block.Size)
+		{
+			return false;
+		}
+		uint32_t Level = 0;
+		while ((Block.Size >> Level) > NodeSize)
+		{
+			++Level;
+		}
+
+		// 1. Smallest free node that is large enough
+		int32_t FreeLevel = static_cast<int32_t>(Level);
+		while (FreeLevel >= 0 && Block.FreeNodes[FreeLevel].empty())
+		{
+			--FreeLevel;
+		}
+		if (FreeLevel < 0)
+		{
+			return false;
+		}
+		VkDeviceSize Offset = *Block.FreeNodes[FreeLevel].begin();
+		Block.FreeNodes[FreeLevel].erase(Block.FreeNodes[FreeLevel].begin());
+
+		// 2. Split it down to the requested level, the upper halves become free
+		for (uint32_t i = static_cast<uint32_t>(FreeLevel); i < Level; ++i)
+		{
+			Block.FreeNodes[i + 1].insert(Offset + (Block.Size >> (i + 1)));
+		}
+
+		Stats.UsedBytes += NodeSize;
+		oOffset = Offset;
+		oLevel = Level;
+		return true;
+	}
+
+	bool cMemoryAllocator::allocateLinear(FBlock& Block, VkDeviceSize Size, VkDeviceSize Alignment, VkDeviceSize& oOffset)
+	{
+		const VkDeviceSize Offset = Alignment > 1 ? (Block.Head + Alignment - 1) / Alignment * Alignment : Block.Head;
+		if (Offset + Size > Block.Size)
+		{
+			return false;
+		}
+		Block.Head = Offset + Size;
+		oOffset = Offset;
+		return true;
+	}
+
+	void cMemoryAllocator::freeBuddy(FBlock& Block, VkDeviceSize Offset, uint32_t Level)
+	{
+		Stats.UsedBytes -= Block.Size >> Level;
+		// Merge with the buddy as long as it is free too
+		while (Level > 0)
+		{
+			const VkDeviceSize Buddy = Offset ^ (Block.Size >> Level);
+			auto It = Block.FreeNodes[Level].find(Buddy);
+			if (It == Block.FreeNodes[Level].end())
+			{
+				break;
+			}
+			Block.FreeNodes[Level].erase(It);
+			Offset = Offset < Buddy ? Offset : Buddy;
+			--Level;
+		}
+		Block.FreeNodes[Level].insert(Offset);
+	}
+
+	bool cMemoryAllocator::createBlock(FPool& Pool, uint32_t& oBlockIndex)
+	{
+		if (Stats.DeviceAllocationCount >= MaxAllocationCount)
+		{
+			printf("cMemoryAllocator: reached maxMemoryAllocationCount (%d)\n", MaxAllocationCount);
+			return false;
+		}
+		checkBudget(Pool.MemoryTypeIndex, Pool.BlockSize);
+		VkMemoryAllocateInfo MemAllocInfo = {};
+		MemAllocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		MemAllocInfo.allocationSize = Pool.BlockSize;
+		MemAllocInfo.memoryTypeIndex = Pool.MemoryTypeIndex;
+
+		VkDeviceMemory Memory = VK_NULL_HANDLE;
+		// Running out of memory here is not fatal, the resource falls back to a dedicated allocation
+		if (vkAllocateMemory(LD, &MemAllocInfo, nullptr, &Memory) != VK_SUCCESS)
+		{
+			return false;
+		}
+		++Stats.DeviceAllocationCount;
+		Stats.BlockBytes += Pool.BlockSize;
+		HeapBytes[MemoryProperties.memoryTypes[Pool.MemoryTypeIndex].heapIndex] += Pool.BlockSize;
+
+		// Reuse the slot of a released block
+		oBlockIndex = static_cast<uint32_t>(Pool.Blocks.size());
+		for (uint32_t i = 0; i < Pool.Blocks.size(); ++i)
+		{
+			if (Pool.Blocks[i].Memory == VK_NULL_HANDLE)
+			{
+				oBlockIndex = i;
+				break;
+			}
+		}
+		if (oBlockIndex == Pool.Blocks.size())
+		{
+			Pool.Blocks.push_back(FBlock());
+		}
+
+		FBlock& Block = Pool.Blocks[oBlockIndex];
+		Block = FBlock();
+		Block.Memory = Memory;
+		Block.Size = Pool.BlockSize;
+		if (Pool.Strategy == EMemoryStrategy::Buddy)
+		{
+			uint32_t LevelCount = 1;
+			while ((Block.Size >> (LevelCount - 1)) > MIN_BUDDY_SIZE)
+			{
+				++LevelCount;
+			}
+			Block.FreeNodes.resize(LevelCount);
+			Block.FreeNodes[0].insert(0);
+		}
+		return true;
+	}
+
+	void cMemoryAllocator::releaseBlock(const FPool& Pool, FBlock& Block)
+	{
+		if (Block.Memory == VK_NULL_HANDLE)
+		{
+			return;
+		}
+		if (Block.MapCount > 0)
+		{
+			vkUnmapMemory(LD, Block.Memory);
+		}
+		vkFreeMemory(LD, Block.Memory, nullptr);
+		--Stats.DeviceAllocationCount;
+		Stats.BlockBytes -= Block.Size;
+		HeapBytes[MemoryProperties.memoryTypes[Pool.MemoryTypeIndex].heapIndex] -= Block.Size;
+		Block = FBlock();
+	}
+
+	void cMemoryAllocator::checkBudget(uint32_t MemoryTypeIndex, VkDeviceSize Size) const
+	{
+		FHeapBudget Budgets[VK_MAX_MEMORY_HEAPS];
+		queryHeapBudgets(Budgets);
+		const uint32_t HeapIndex = MemoryProperties.memoryTypes[MemoryTypeIndex].heapIndex;
+		const FHeapBudget& Heap = Budgets[HeapIndex];
+		if (Heap.Usage + Size > Heap.Budget)
+		{
+			printf("cMemoryAllocator: allocating %llu KB goes over the budget of heap %d (%llu / %llu MB used)\n",
+				static_cast<unsigned long long>(Size >> 10), HeapIndex,
+				static_cast<unsigned long long>(Heap.Usage >> 20), static_cast<unsigned long long>(Heap.Budget >> 20));
+		}
+	}
+
+	void cMemoryAllocator::queryHeapBudgets(FHeapBudget (&oBudgets)[VK_MAX_MEMORY_HEAPS]) const
+	{
+		VkPhysicalDeviceMemoryBudgetPropertiesEXT BudgetProperties = {};
+		BudgetProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+		if (bMemoryBudget)
+		{
+			// Budgets change with other processes and the OS, they have to be queried again every time
+			VkPhysicalDeviceMemoryProperties2 Properties2 = {};
+			Properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+			Properties2.pNext = &BudgetProperties;
+			vkGetPhysicalDeviceMemoryProperties2(PD, &Properties2);
+		}
+		for (uint32_t i = 0; i < MemoryProperties.memoryHeapCount; ++i)
+		{
+			FHeapBudget& Budget = oBudgets[i];
+			Budget.Size = MemoryProperties.memoryHeaps[i].size;
+			Budget.bDeviceLocal = (MemoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
+			Budget.AllocatorBytes = HeapBytes[i];
+			if (bMemoryBudget)
+			{
+				Budget.Budget = BudgetProperties.heapBudget[i];
+				Budget.Usage = BudgetProperties.heapUsage[i];
+			}
+			else
+			{
+				// Without the extension only our own allocations are known, and the OS usually keeps a part of every heap
+				Budget.Budget = Budget.Size / 10 * 8;
+				Budget.Usage = HeapBytes[i];
+			}
+		}
+	}
+
+	uint32_t cMemoryAllocator::getPoolIndex(uint32_t MemoryTypeIndex, bool bOptimalImage, EMemoryStrategy Strategy)
+	{
+		for (uint32_t i = 0; i < Pools.size(); ++i)
+		{
+			if (Pools[i].MemoryTypeIndex == MemoryTypeIndex && Pools[i].bOptimalImages == bOptimalImage && Pools[i].Strategy == Strategy)
+			{
+				return i;
+			}
+		}
+
+		FPool NewPool;
+		NewPool.MemoryTypeIndex = MemoryTypeIndex;
+		NewPool.bOptimalImages = bOptimalImage;
+		NewPool.Strategy = Strategy;
+		// A block should not take more than 1/8 of its heap, e.g. the 256MB device local + host visible heap
+		const VkDeviceSize HeapSize = MemoryProperties.memoryHeaps[MemoryProperties.memoryTypes[MemoryTypeIndex].heapIndex].size;
+		NewPool.BlockSize = BlockSize;
+		while (NewPool.BlockSize > MIN_BUDDY_SIZE && NewPool.BlockSize * 8 > HeapSize)
+		{
+			NewPool.BlockSize >>= 1;
+		}
+		Pools.push_back(NewPool);
+		return static_cast<uint32_t>(Pools.size() - 1);
+	}
+
+	uint32_t cMemoryAllocator::findMemoryType(uint32_t AllowedTypes, VkMemoryPropertyFlags Properties) const
+	{
+		for (uint32_t i = 0; i < MemoryProperties.memoryTypeCount; ++i)
+		{
+			if ((AllowedTypes & (1 << i))
+				&& ((MemoryProperties.memoryTypes[i].propertyFlags & Properties) == Properties))
+			{
+				return i;
+			}
+		}
+		return static_cast<uint32_t>(-1);
+	}
+}
@@ -0,0 +1,186 @@
+/*
+	MemoryAllocator sub-allocates buffers and images from large VkDeviceMemory blocks instead of one vkAllocateMemory per resource
+	Every memory type has its own pools of blocks:
+	1. Buddy pools for long lived resources (meshes, textures, uniform / storage buffers), freed blocks merge with their buddies
+	2. Linear pools for short lived resources (staging buffers), allocations are bumped and a block rewinds once all of them are freed
+	Linear resources (buffers) and optimal tiled images never share a block, so bufferImageGranularity can never be violated
+	Resources larger than half a block get a dedicated allocation
+	Host visible blocks are mapped on demand and stay mapped while any allocation in them is mapped, a VkDeviceMemory can only be mapped once
+	Every allocation is accounted to a category (mesh, texture, ...), heap budgets come from VK_EXT_memory_budget when the device supports it,
+	going over a heap's budget prints a warning before the driver would fail with VK_ERROR_OUT_OF_DEVICE_MEMORY
+*/
+#pragma once
+#define GLFW_INCLUDE_VULKAN
+#include "GLFW/glfw3.h"
+
+#include <vector>
+#include <set>
+#include <mutex>
+#include <stdint.h>
+namespace VKE
+{
+	enum class EMemoryStrategy : uint8_t
+	{
+		Buddy,				// General purpose
+		Linear,				// Short lived, freed soon after creation
+		Dedicated,			// Own VkDeviceMemory
+	};
+
+	// What a resource is used for, only for accounting
+	enum class EMemoryCategory : uint8_t
+	{
+		Mesh,				// Vertex / index buffers
+		Texture,			// Sampled images
+		Attachment,			// Render targets, depth buffers
+		Uniform,			// Uniform buffers, object tables
+		Particle,			// Particle storage buffers
+		Staging,			// Upload sources
+		Other,
+		Count,
+	};
+	const char* GetMemoryCategoryName(EMemoryCategory Category);
+
+	// Where a resource lives inside the device memory, returned by cMemoryAllocator and given back to free it
+	struct FMemoryAllocation
+	{
+		VkDeviceMemory Memory = VK_NULL_HANDLE;
+		VkDeviceSize Offset = 0;
+		VkDeviceSize Size = 0;
+		uint32_t MemoryTypeIndex = 0;
+
+		// Book keeping of the allocator
+		EMemoryStrategy Strategy = EMemoryStrategy::Buddy;
+		uint32_t PoolIndex = 0;
+		uint32_t BlockIndex = 0;
+		uint32_t BuddyLevel = 0;
+		EMemoryCategory Category = EMemoryCategory::Other;
+
+		bool IsValid() const { return Memory != VK_NULL_HANDLE; }
+	};
+
+	struct FMemoryStats
+	{
+		uint32_t DeviceAllocationCount = 0;		// Live vkAllocateMemory calls, bounded by maxMemoryAllocationCount
+		uint32_t ResourceCount = 0;				// Live sub-allocations + dedicated allocations
+		VkDeviceSize BlockBytes = 0;			// Reserved in blocks
+		VkDeviceSize UsedBytes = 0;				// Handed out from blocks, buddy rounding included
+		VkDeviceSize DedicatedBytes = 0;
+		VkDeviceSize PeakBytes = 0;				// Highest UsedBytes + DedicatedBytes so far
+
+		// Filled by GetStats from the blocks
+		VkDeviceSize FreeBytes = 0;				// Not handed out in blocks
+		VkDeviceSize LargestFreeBytes = 0;		// Sum of the largest free range of every block
+
+		struct FCategory
+		{
+			uint32_t ResourceCount = 0;
+			VkDeviceSize Bytes = 0;				// Requested sizes, without buddy rounding
+			VkDeviceSize PeakBytes = 0;
+		};
+		FCategory Categories[static_cast<size_t>(EMemoryCategory::Count)];
+
+		// 0 when the free memory of every block is one range, close to 1 when it is scattered in small pieces
+		float GetFragmentation() const { return FreeBytes > 0 ? 1.0f - static_cast<float>(LargestFreeBytes) / static_cast<float>(FreeBytes) : 0.0f; }
+	};
+
+	struct FHeapBudget
+	{
+		VkDeviceSize Size = 0;
+		VkDeviceSize Budget = 0;				// What this process can allocate from the heap without failing or being paged out
+		VkDeviceSize Usage = 0;					// Used by this process, includes memory allocated outside the allocator (swap chain, imgui)
+		VkDeviceSize AllocatorBytes = 0;		// Blocks + dedicated allocations of the allocator in this heap
+		bool bDeviceLocal = false;
+	};
+
+	class cMemoryAllocator
+	{
+	public:
+		/* Constructors and destructor*/
+		cMemoryAllocator() {}
+		~cMemoryAllocator() {}
+		cMemoryAllocator(const cMemoryAllocator& i_other) = delete;
+		cMemoryAllocator& operator = (const cMemoryAllocator& i_other) = delete;
+
+		// iMemoryBudget: VK_EXT_memory_budget is enabled on the device, otherwise budgets are estimated from the heap sizes
+		bool init(VkPhysicalDevice iPD, VkDevice iLD, bool iMemoryBudget = false, VkDeviceSize iBlockSize = DEFAULT_BLOCK_SIZE);
+		// Every allocation has to be freed before, the remaining blocks are released
+		void cleanUp();
+
+		// Allocate and bind memory for a created buffer / image
+		bool AllocateForBuffer(VkBuffer Buffer, VkMemoryPropertyFlags Properties, EMemoryStrategy Strategy, EMemoryCategory Category, FMemoryAllocation& oAllocation);
+		bool AllocateForImage(VkImage Image, VkMemoryPropertyFlags Properties, EMemoryCategory Category, FMemoryAllocation& oAllocation);
+		void Free(FMemoryAllocation& ioAllocation);
+
+		// Pointer to the start of the allocation, the memory type has to be host visible
+		void* Map(const FMemoryAllocation& Allocation);
+		void Unmap(const FMemoryAllocation& Allocation);
+		// Make CPU writes in [Offset, Offset + Size) of the allocation visible to the GPU, nothing to do for coherent memory
+		void Flush(const FMemoryAllocation& Allocation, VkDeviceSize Offset, VkDeviceSize Size);
+		// Make GPU writes in [Offset, Offset + Size) of the allocation visible to the CPU, nothing to do for coherent memory
+		void Invalidate(const FMemoryAllocation& Allocation, VkDeviceSize Offset, VkDeviceSize Size);
+		bool IsCoherent(const FMemoryAllocation& Allocation) const;
+
+		FMemoryStats GetStats() const;
+		// Fill one entry per memory heap and return the heap count, no heap allocation so it can run every frame
+		uint32_t GetHeapBudgets(FHeapBudget (&oBudgets)[VK_MAX_MEMORY_HEAPS]) const;
+		bool HasMemoryBudget() const { return bMemoryBudget; }
+		VkDeviceSize GetBlockSize() const { return BlockSize; }
+
+		static const VkDeviceSize DEFAULT_BLOCK_SIZE = 64ull * 1024 * 1024;
+		static const VkDeviceSize MIN_BUDDY_SIZE = 256;
+	private:
+		struct FBlock
+		{
+			VkDeviceMemory Memory = VK_NULL_HANDLE;
+			VkDeviceSize Size = 0;
+			void* pMapped = nullptr;
+			uint32_t MapCount = 0;
+			uint32_t AllocationCount = 0;
+			// Buddy: free node offsets per level, level 0 is the whole block
+			std::vector<std::set<VkDeviceSize>> FreeNodes;
+			// Linear: next free offset
+			VkDeviceSize Head = 0;
+		};
+
+		struct FPool
+		{
+			uint32_t MemoryTypeIndex = 0;
+			bool bOptimalImages = false;
+			EMemoryStrategy Strategy = EMemoryStrategy::Buddy;
+			VkDeviceSize BlockSize = 0;			// Power of two, smaller than the default for small heaps
+			std::vector<FBlock> Blocks;			// Released blocks keep their slot with a null Memory
+		};
+
+		bool allocate(const VkMemoryRequirements& Requirements, VkMemoryPropertyFlags Properties, EMemoryStrategy Strategy, EMemoryCategory Category, bool bOptimalImage, VkBuffer DedicatedBuffer, VkImage DedicatedImage, FMemoryAllocation& oAllocation);
+		bool allocateDedicated(const VkMemoryRequirements& Requirements, uint32_t MemoryTypeIndex, VkBuffer Buffer, VkImage Image, FMemoryAllocation& oAllocation);
+		bool allocateFromPool(uint32_t PoolIndex, VkDeviceSize Size, VkDeviceSize Alignment, FMemoryAllocation& oAllocation);
+		bool allocateBuddy(FBlock& Block, VkDeviceSize Size, VkDeviceSize Alignment, VkDeviceSize& oOffset, uint32_t& oLevel);
+		bool allocateLinear(FBlock& Block, VkDeviceSize Size, VkDeviceSize Alignment, VkDeviceSize& oOffset);
+		// Category and peak accounting of a new allocation
+		void trackAllocation(EMemoryCategory Category, FMemoryAllocation& ioAllocation);
+		void freeBuddy(FBlock& Block, VkDeviceSize Offset, uint32_t Level);
+		bool createBlock(FPool& Pool, uint32_t& oBlockIndex);
+		void releaseBlock(const FPool& Pool, FBlock& Block);
+		// Non coherent range of the allocation, rounded to nonCoherentAtomSize
+		VkMappedMemoryRange getMappedRange(const FMemoryAllocation& Allocation, VkDeviceSize Offset, VkDeviceSize Size) const;
+		// Warn when a new device allocation of Size bytes would take the heap of the memory type over its budget
+		void checkBudget(uint32_t MemoryTypeIndex, VkDeviceSize Size) const;
+		void queryHeapBudgets(FHeapBudget (&oBudgets)[VK_MAX_MEMORY_HEAPS]) const;
+		uint32_t getPoolIndex(uint32_t MemoryTypeIndex, bool bOptimalImage, EMemoryStrategy Strategy);
+		uint32_t findMemoryType(uint32_t AllowedTypes, VkMemoryPropertyFlags Properties) const;
+
+		VkPhysicalDevice PD = VK_NULL_HANDLE;
+		VkDevice LD = VK_NULL_HANDLE;
+		VkPhysicalDeviceMemoryProperties MemoryProperties = {};
+		VkDeviceSize BlockSize = DEFAULT_BLOCK_SIZE;
+		uint32_t MaxAllocationCount = 0;
+		VkDeviceSize NonCoherentAtomSize = 1;
+		bool bMemoryBudget = false;
+		VkDeviceSize HeapBytes[VK_MAX_MEMORY_HEAPS] = {};	// Blocks + dedicated allocations per heap
+
+		std::vector<FPool> Pools;
+		FMemoryStats Stats;
+		// Assets can be created off the main thread
+		mutable std::mutex Mutex;
+	};
+}
@@ -0,0 +1,175 @@
+#include "GeometryArena.h"
+#include "Command/UploadContext.h"
+#include "Descriptors/DescriptorAllocator.h"
+
+#include "assert.h"
+
+namespace VKE
+{
+	bool cGeometryArena::init(FMainDevice* iMainDevice, uint32_t iBlockVertexCount, uint32_t iBlockIndexCount)
+	{
+		assert(iBlockVertexCount > 0 && iBlockIndexCount > 0);
+		pMainDevice = iMainDevice;
+		BlockVertexCount = iBlockVertexCount;
+		BlockIndexCount = iBlockIndexCount;
+
+		// Descriptor set layout of vertex pulling, the block's vertices as one storage buffer
+		VkDescriptorSetLayoutBinding Binding = {};
+		Binding.binding = 0;
+		Binding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		Binding.descriptorCount = 1;
+		Binding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+
+		VkDescriptorSetLayoutCreateInfo LayoutCreateInfo = {};
+		LayoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		LayoutCreateInfo.bindingCount = 1;
+		LayoutCreateInfo.pBindings = &Binding;
+		VkResult Result = vkCreateDescriptorSetLayout(pMainDevice->LD, &LayoutCreateInfo, nullptr, &DescriptorSetLayout);
+		RESULT_CHECK(Result, "Fail to create geometry arena descriptor set layout.");
+		return Result == VK_SUCCESS;
+	}
+
+	void cGeometryArena::cleanUp()
+	{
+		std::lock_guard<std::mutex> Lock(Mutex);
+		for (FBlock& Block : Blocks)
+		{
+			if (Block.MeshCount > 0)
+			{
+				printf("Geometry arena block still holds %d meshes.\n", Block.MeshCount);
+			}
+			Block.VertexBuffer.cleanUp();
+			Block.IndexBuffer.cleanUp();
+		}
+		Blocks.clear();
+		vkDestroyDescriptorSetLayout(pMainDevice->LD, DescriptorSetLayout, nullptr);
+		DescriptorSetLayout = VK_NULL_HANDLE;
+	}
+
+	bool cGeometryArena::Allocate(const std::vector<FVertex>& iVertices, const std::vector<uint32_t>& iIndices, FGeometryRange& oRange)
+	{
+		const uint32_t VertexCount = static_cast<uint32_t>(iVertices.size());
+		const uint32_t IndexCount = static_cast<uint32_t>(iIndices.size());
+		std::lock_guard<std::mutex> Lock(Mutex);
+
+		// 1. First block with room for both, a new one otherwise
+		uint32_t BlockIndex = FGeometryRange::INVALID_BLOCK;
+		for (uint32_t i = 0; i < Blocks.size(); ++i)
+		{
+			if (Blocks[i].VertexCapacity - Blocks[i].VertexHead >= VertexCount && Blocks[i].IndexCapacity - Blocks[i].IndexHead >= IndexCount)
+			{
+				BlockIndex = i;
+				break;
+			}
+		}
+		if (BlockIndex == FGeometryRange::INVALID_BLOCK)
+		{
+			if (!createBlock(VertexCount > BlockVertexCount ? VertexCount : BlockVertexCount, IndexCount > BlockIndexCount ? IndexCount : BlockIndexCount))
+			{
+				return false;
+			}
+			BlockIndex = static_cast<uint32_t>(Blocks.size() - 1);
+		}
+
+		// 2. Take the range and stage the data, the buffers are concurrent so no ownership is transferred
+		FBlock& Block = Blocks[BlockIndex];
+		oRange.Block = BlockIndex;
+		oRange.VertexOffset = Block.VertexHead;
+		oRange.VertexCount = VertexCount;
+		oRange.FirstIndex = Block.IndexHead;
+		oRange.IndexCount = IndexCount;
+		Block.VertexHead += VertexCount;
+		Block.IndexHead += IndexCount;
+		++Block.MeshCount;
+
+		if (!pMainDevice->UploadContext->UploadBuffer(Block.VertexBuffer.GetvkBuffer(), iVertices.data(), sizeof(FVertex) * VertexCount, sizeof(FVertex) * oRange.VertexOffset, true)
+			|| !pMainDevice->UploadContext->UploadBuffer(Block.IndexBuffer.GetvkBuffer(), iIndices.data(), sizeof(uint32_t) * IndexCount, sizeof(uint32_t) * oRange.FirstIndex, true))
+		{
+			// 3. Give the range back, it is still the tail of the block since the lock is held
+			Block.VertexHead = oRange.VertexOffset;
+			Block.IndexHead = oRange.FirstIndex;
+			--Block.MeshCount;
+			oRange = FGeometryRange();
+			return false;
+		}
+		return true;
+	}
+
+	void cGeometryArena::Free(FGeometryRange& ioRange)
+	{
+		if (!ioRange.IsValid())
+		{
+			return;
+		}
+		std::lock_guard<std::mutex> Lock(Mutex);
+		assert(ioRange.Block < Blocks.size());
+		FBlock& Block = Blocks[ioRange.Block];
+		assert(Block.MeshCount > 0);
+		if (--Block.MeshCount == 0)
+		{
+			Block.VertexHead = 0;
+			Block.IndexHead = 0;
+		}
+		ioRange = FGeometryRange();
+	}
+
+	FGeometryArenaStats cGeometryArena::GetStats() const
+	{
+		std::lock_guard<std::mutex> Lock(Mutex);
+		FGeometryArenaStats Stats;
+		Stats.BlockCount = static_cast<uint32_t>(Blocks.size());
+		for (const FBlock& Block : Blocks)
+		{
+			Stats.MeshCount += Block.MeshCount;
+			Stats.UsedVertices += Block.VertexHead;
+			Stats.VertexCapacity += Block.VertexCapacity;
+			Stats.UsedIndices += Block.IndexHead;
+			Stats.IndexCapacity += Block.IndexCapacity;
+		}
+		return Stats;
+	}
+
+	bool cGeometryArena::createBlock(uint32_t iVertexCapacity, uint32_t iIndexCapacity)
+	{
+		FBlock Block;
+		const std::vector<uint32_t> SharingFamilies = pMainDevice->GraphicTransferSharingFamilies();
+		// Vertex input or vertex pulling, only local visible to GPU
+		if (!Block.VertexBuffer.CreateBufferAndAllocateMemory(pMainDevice, sizeof(FVertex) * iVertexCapacity,
+			VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, EMemoryCategory::Mesh, SharingFamilies))
+		{
+			return false;
+		}
+		if (!Block.IndexBuffer.CreateBufferAndAllocateMemory(pMainDevice, sizeof(uint32_t) * iIndexCapacity,
+			VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, EMemoryCategory::Mesh, SharingFamilies))
+		{
+			Block.VertexBuffer.cleanUp();
+			return false;
+		}
+		Block.VertexCapacity = iVertexCapacity;
+		Block.IndexCapacity = iIndexCapacity;
+
+		// The set lives as long as the descriptor allocator
+		Block.DescriptorSet = pMainDevice->DescriptorAllocator->Allocate(DescriptorSetLayout);
+		if (Block.DescriptorSet != VK_NULL_HANDLE)
+		{
+			VkDescriptorBufferInfo BufferInfo = {};
+			BufferInfo.buffer = Block.VertexBuffer.GetvkBuffer();
+			BufferInfo.offset = 0;
+			BufferInfo.range = VK_WHOLE_SIZE;
+
+			VkWriteDescriptorSet SetWrite = {};
+			SetWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			SetWrite.dstSet = Block.DescriptorSet;
+			SetWrite.dstBinding = 0;
+			SetWrite.dstArrayElement = 0;
+			SetWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			SetWrite.descriptorCount = 1;
+			SetWrite.pBufferInfo = &BufferInfo;
+			vkUpdateDescriptorSets(pMainDevice->LD, 1, &SetWrite, 0, nullptr);
+		}
+		Blocks.push_back(Block);
+		return true;
+	}
+}
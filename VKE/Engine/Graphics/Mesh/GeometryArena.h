@@ -0,0 +1,93 @@
+/*
+	GeometryArena sub-allocates the vertices and indices of every mesh from a few large device local buffers
+	A mesh is a range of one block: its vertices start at VertexOffset and its indices at FirstIndex, the indices stay relative to the mesh,
+	so draws pass them as vertexOffset / firstIndex and all meshes of a block share a single vertex / index buffer bind
+	Blocks are filled front to back, a mesh that does not fit into any block gets a new one (at least as big as the mesh)
+	Meshes live as long as the asset container, so freed ranges are not reused one by one, a block is rewound once all of its meshes are freed
+	The buffers are shared concurrently with the transfer family, uploading into a new range never transfers ownership of the whole buffer
+	The vertex buffer is a storage buffer as well, a block's descriptor set exposes it to vertex shaders pulling vertices by gl_VertexIndex
+	Allocate / Free can be called from loading jobs
+*/
+#pragma once
+#define GLFW_INCLUDE_VULKAN
+#include "GLFW/glfw3.h"
+
+#include "Utilities.h"
+#include "Buffer/Buffer.h"
+
+#include <vector>
+#include <mutex>
+namespace VKE
+{
+	// Where a mesh lives in the arena
+	struct FGeometryRange
+	{
+		static const uint32_t INVALID_BLOCK = ~0u;
+
+		uint32_t Block = INVALID_BLOCK;
+		uint32_t VertexOffset = 0;			// First vertex, passed as vertexOffset
+		uint32_t VertexCount = 0;
+		uint32_t FirstIndex = 0;
+		uint32_t IndexCount = 0;
+
+		bool IsValid() const { return Block != INVALID_BLOCK; }
+	};
+
+	struct FGeometryArenaStats
+	{
+		uint32_t BlockCount = 0;
+		uint32_t MeshCount = 0;
+		uint64_t UsedVertices = 0;
+		uint64_t VertexCapacity = 0;
+		uint64_t UsedIndices = 0;
+		uint64_t IndexCapacity = 0;
+	};
+
+	class cGeometryArena
+	{
+	public:
+		/* Constructors and destructor*/
+		cGeometryArena() {}
+		~cGeometryArena() {}
+		cGeometryArena(const cGeometryArena& i_other) = delete;
+		cGeometryArena& operator = (const cGeometryArena& i_other) = delete;
+
+		bool init(FMainDevice* iMainDevice, uint32_t iBlockVertexCount = GEOMETRY_BLOCK_VERTEX_COUNT, uint32_t iBlockIndexCount = GEOMETRY_BLOCK_INDEX_COUNT);
+		// Every range has to be freed before
+		void cleanUp();
+
+		// Find room for the mesh and stage its data in the upload context, usable once the upload context's next token is reached
+		bool Allocate(const std::vector<FVertex>& iVertices, const std::vector<uint32_t>& iIndices, FGeometryRange& oRange);
+		// The GPU must be done with the range, ioRange becomes invalid
+		void Free(FGeometryRange& ioRange);
+
+		const VkBuffer& GetVertexBuffer(uint32_t Block) const { return Blocks[Block].VertexBuffer.GetvkBuffer(); }
+		const VkBuffer& GetIndexBuffer(uint32_t Block) const { return Blocks[Block].IndexBuffer.GetvkBuffer(); }
+		// Vertex pulling, binding 0 is the block's vertex buffer as a storage buffer
+		VkDescriptorSetLayout GetDescriptorSetLayout() const { return DescriptorSetLayout; }
+		const VkDescriptorSet& GetDescriptorSet(uint32_t Block) const { return Blocks[Block].DescriptorSet; }
+
+		FGeometryArenaStats GetStats() const;
+	private:
+		struct FBlock
+		{
+			cBuffer VertexBuffer;
+			cBuffer IndexBuffer;
+			uint32_t VertexCapacity = 0;
+			uint32_t IndexCapacity = 0;
+			uint32_t VertexHead = 0;
+			uint32_t IndexHead = 0;
+			uint32_t MeshCount = 0;
+			VkDescriptorSet DescriptorSet = VK_NULL_HANDLE;
+		};
+
+		bool createBlock(uint32_t iVertexCapacity, uint32_t iIndexCapacity);
+
+		FMainDevice* pMainDevice = nullptr;
+		uint32_t BlockVertexCount = 0;
+		uint32_t BlockIndexCount = 0;
+		std::vector<FBlock> Blocks;
+		VkDescriptorSetLayout DescriptorSetLayout = VK_NULL_HANDLE;
+		mutable std::mutex Mutex;
+	};
+}
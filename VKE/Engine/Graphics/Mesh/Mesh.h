@@ -5,20 +5,27 @@
 #include <vector>
 #include "BufferFormats.h"
 #include "Utilities.h"
-#include "Buffer/Buffer.h"
-#include "Descriptors/DescriptorSet.h"
+#include "Mesh/GeometryArena.h"
 #include <memory>
 
 namespace VKE
 {
+	// Local space axis aligned bounding box
+	struct FMeshBounds
+	{
+		glm::vec3 Min;
+		glm::vec3 Max;
+	};
 
 	class cMesh
 	{
 	public:
 		// Load asset
+		// Vertices / indices are staged into the geometry arena by the upload context, they are ready once its next submitted token is reached
+		// Bounds are computed from the vertices unless the importer already has them
+		// Returns nullptr when the geometry arena can't hold the mesh
 		static std::shared_ptr<cMesh> Load(const std::string& iMeshName, FMainDevice& iMainDevice,
-			VkQueue TransferQueue, VkCommandPool TransferCommandPool,
-			const std::vector<FVertex>& iVertices, const std::vector<uint32_t>& iIndices);
+			const std::vector<FVertex>& iVertices, const std::vector<uint32_t>& iIndices, const FMeshBounds* iBounds = nullptr);
 		// Free all assets
 		static void Free();
 		static uint32_t s_CreatedResourcesCount;
@@ -29,33 +36,42 @@ namespace VKE
 		~cMesh();
 
 		cMesh(FMainDevice& iMainDevice, 
-			VkQueue TransferQueue, VkCommandPool TransferCommandPool,
-			const std::vector<FVertex>& iVertices, const std::vector<uint32_t>& iIndices);
+			const std::vector<FVertex>& iVertices, const std::vector<uint32_t>& iIndices, const FMeshBounds* iBounds = nullptr);
 
 		void cleanUp();
-		void CreateDescriptorSet(VkDescriptorPool SamplerDescriptorPool);
 
-		uint32_t GetVertexCount() const { return VertexCount; }
-		const VkBuffer& GetVertexBuffer() const { return VertexBuffer.GetvkBuffer(); }
+		// Buffers are shared by every mesh of the same arena block, draw with GetFirstIndex / GetVertexOffset
+		uint32_t GetVertexCount() const { return Geometry.VertexCount; }
+		const VkBuffer& GetVertexBuffer() const;
+		int32_t GetVertexOffset() const { return static_cast<int32_t>(Geometry.VertexOffset); }
+
+		uint32_t GetIndexCount() const { return Geometry.IndexCount; }
+		const VkBuffer& GetIndexBuffer() const;
+		uint32_t GetFirstIndex() const { return Geometry.FirstIndex; }
+
+		const FGeometryRange& GetGeometry() const { return Geometry; }
+		// Unique per created mesh, orders meshes in draw sort keys
+		uint32_t GetID() const { return ID; }
 
-		uint32_t GetIndexCount() const { return IndexCount; }
-		const VkBuffer& GetIndexBuffer() const { return IndexBuffer.GetvkBuffer(); }
+		// Local space bounding box of the vertices, culled against the frustum per mesh on the CPU and per instance on the GPU
+		const glm::vec3& GetBoundsCenter() const { return BoundsCenter; }
+		const glm::vec3& GetBoundsExtent() const { return BoundsExtent; }
 
+		// ID of the mesh's cMaterial, shared with every mesh using the same textures
 		void SetMaterialID(int MatID) { MaterialID = MatID; }
 		int GetMaterialID() const {	return MaterialID; }
-		const VkDescriptorSet& GetDescriptorSet() { return SamplerDescriptorSet.GetDescriptorSet(); }
 
 	private:
 		int MaterialID = 0;
+		uint32_t ID = 0;
 		
-		uint32_t VertexCount, IndexCount;
-		cBuffer VertexBuffer, IndexBuffer;
+		FGeometryRange Geometry;
+		glm::vec3 BoundsCenter = glm::vec3(0.0f);
+		glm::vec3 BoundsExtent = glm::vec3(0.0f);			// Half size
 		
 		FMainDevice* pMainDevice;
-		cDescriptorSet SamplerDescriptorSet;	// @TODO: Should be put in Material class
 
-		bool createVertexBuffer(const std::vector<FVertex>& iVertices, VkQueue TransferQueue, VkCommandPool TransferCommandPool);
-		bool createIndexBuffer(const std::vector<uint32_t>& iIndices, VkQueue TransferQueue, VkCommandPool TransferCommandPool);
+		void computeBounds(const std::vector<FVertex>& iVertices);
 		
 	};
 }
@@ -1,5 +1,6 @@
 #include "Model.h"
 #include "Mesh/Mesh.h"
+#include "Job/JobSystem.h"
 
 #include "assimp/Importer.hpp"
 #include <assimp/scene.h>
@@ -34,33 +35,81 @@ namespace VKE
 		return TextureList;
 	}
 
-	std::vector < std::shared_ptr<cMesh> > cModel::LoadNode(const std::string& iFileName, FMainDevice& MainDevice, VkQueue TransferQueue, VkCommandPool TransferCommandPool, aiNode* Node, const aiScene* Scene, const std::vector<int>& MatToTex)
+	std::vector < std::shared_ptr<cMesh> > cModel::LoadNode(const std::string& iFileName, FMainDevice& MainDevice, aiNode* Node, const aiScene* Scene, const std::vector<uint32_t>& MatToMaterial)
 	{
+		// 1. Flatten the node tree
+		std::vector<std::pair<std::string, aiMesh*>> NodeMeshes;
+		gatherMeshes(iFileName, Node, Scene, NodeMeshes);
+
+		// 2. Decode vertices / indices of all meshes on the job system
+		std::vector<std::vector<FVertex>> Vertices(NodeMeshes.size());
+		std::vector<std::vector<uint32_t>> Indices(NodeMeshes.size());
+		JobSystem::ParallelFor(NodeMeshes.size(), 1, [&](size_t Begin, size_t End)
+		{
+			for (size_t i = Begin; i < End; ++i)
+			{
+				DecodeMesh(NodeMeshes[i].second, Vertices[i], Indices[i]);
+			}
+		});
+
+		// 3. Create the buffers and stage the data on this thread, the upload context copies all of them in one batch
 		std::vector<std::shared_ptr<cMesh>> MeshList;
+		MeshList.reserve(NodeMeshes.size());
+		for (size_t i = 0; i < NodeMeshes.size(); ++i)
+		{
+			FMeshBounds Bounds;
+			const bool HasBounds = ImportedBounds(NodeMeshes[i].second, Bounds);
+			std::shared_ptr<cMesh> NewMesh = cMesh::Load(NodeMeshes[i].first, MainDevice, Vertices[i], Indices[i], HasBounds ? &Bounds : nullptr);
+			if (!NewMesh)
+			{
+				continue;
+			}
+			NewMesh->SetMaterialID(MatToMaterial[NodeMeshes[i].second->mMaterialIndex]);
+			MeshList.push_back(NewMesh);
+		}
 
-		// Go through each mesh at this node and create it, then add it to our mesh list
+		return MeshList;
+	}
+
+	void cModel::gatherMeshes(const std::string& iFileName, aiNode* Node, const aiScene* Scene, std::vector<std::pair<std::string, aiMesh*>>& oMeshes)
+	{
+		// Go through each mesh at this node
 		for (size_t i = 0; i < Node->mNumMeshes; ++i)
 		{
-			// Load mesh here
-			MeshList.push_back(LoadMesh(iFileName, MainDevice, TransferQueue, TransferCommandPool, Scene->mMeshes[Node->mMeshes[i]], Scene, MatToTex));
+			oMeshes.push_back({ iFileName, Scene->mMeshes[Node->mMeshes[i]] });
 		}
 
-		// Go though each node attached to this node and load it
+		// Go though each node attached to this node
 		for (size_t i = 0; i < Node->mNumChildren; ++i)
 		{
 			std::string ChildName = iFileName + "_" + Node->mChildren[i]->mName.C_Str();
-			auto newList = LoadNode(ChildName, MainDevice, TransferQueue, TransferCommandPool, Node->mChildren[i], Scene, MatToTex);
-			MeshList.insert(MeshList.end(), newList.begin(), newList.end());
+			gatherMeshes(ChildName, Node->mChildren[i], Scene, oMeshes);
 		}
-
-		return MeshList;
 	}
 
-	std::shared_ptr<cMesh> cModel::LoadMesh(const std::string& iFileName, FMainDevice& MainDevice, VkQueue TransferQueue, VkCommandPool TransferCommandPool, aiMesh* Mesh, const aiScene* Scene, const std::vector<int>& MatToTex)
+	std::shared_ptr<cMesh> cModel::LoadMesh(const std::string& iFileName, FMainDevice& MainDevice, aiMesh* Mesh, const aiScene* Scene, const std::vector<uint32_t>& MatToMaterial)
 	{
 		std::vector<FVertex> Vertices;
 		std::vector<uint32_t> Indices;
+		DecodeMesh(Mesh, Vertices, Indices);
 
+		// Create new mesh with details
+		FMeshBounds Bounds;
+		const bool HasBounds = ImportedBounds(Mesh, Bounds);
+		std::shared_ptr<cMesh> NewMesh = cMesh::Load(iFileName, MainDevice, Vertices, Indices, HasBounds ? &Bounds : nullptr);
+		if (!NewMesh)
+		{
+			return nullptr;
+		}
+		uint32_t MaterialID = MatToMaterial[Mesh->mMaterialIndex];
+
+		NewMesh->SetMaterialID(MaterialID);
+
+		return NewMesh;
+	}
+
+	void cModel::DecodeMesh(const aiMesh* Mesh, std::vector<FVertex>& Vertices, std::vector<uint32_t>& Indices)
+	{
 		Vertices.resize(Mesh->mNumVertices);
 
 		for (size_t i = 0; i < Vertices.size(); ++i)
@@ -92,14 +141,19 @@ namespace VKE
 				Indices.push_back(Face.mIndices[j]);
 			}
 		}
+	}
 
-		// Create new mesh with details
-		std::shared_ptr<cMesh> NewMesh = cMesh::Load(iFileName, MainDevice, TransferQueue, TransferCommandPool, Vertices, Indices);
-		int MaterialID = MatToTex[Mesh->mMaterialIndex];
-
-		NewMesh->SetMaterialID(MaterialID);
-
-		return NewMesh;
+	bool cModel::ImportedBounds(const aiMesh* Mesh, FMeshBounds& oBounds)
+	{
+		const aiAABB& AABB = Mesh->mAABB;
+		// Left zeroed without the post process, computing it from the vertices is right either way
+		if (Mesh->mNumVertices == 0 || (AABB.mMin == aiVector3D() && AABB.mMax == aiVector3D()))
+		{
+			return false;
+		}
+		oBounds.Min = { AABB.mMin.x, AABB.mMin.y, AABB.mMin.z };
+		oBounds.Max = { AABB.mMax.x, AABB.mMax.y, AABB.mMax.z };
+		return true;
 	}
 
 	void cModel::cleanUp()
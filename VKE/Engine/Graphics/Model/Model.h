@@ -14,8 +14,12 @@ namespace VKE
 	{
 	public:
 		static std::vector<std::string> LoadMaterials(const aiScene* scene);
-		static std::vector < std::shared_ptr<cMesh> > LoadNode(const std::string& iFileName, FMainDevice& MainDevice, VkQueue TransferQueue, VkCommandPool TransferCommandPool, aiNode* Node, const aiScene* Scene, const std::vector<int>& MatToTex);
-		static std::shared_ptr<cMesh> LoadMesh(const std::string& iFileName, FMainDevice& MainDevice, VkQueue TransferQueue, VkCommandPool TransferCommandPool, aiMesh* Mesh, const aiScene* Scene, const std::vector<int>& MatToTex);
+		static std::vector < std::shared_ptr<cMesh> > LoadNode(const std::string& iFileName, FMainDevice& MainDevice, aiNode* Node, const aiScene* Scene, const std::vector<uint32_t>& MatToMaterial);
+		static std::shared_ptr<cMesh> LoadMesh(const std::string& iFileName, FMainDevice& MainDevice, aiMesh* Mesh, const aiScene* Scene, const std::vector<uint32_t>& MatToMaterial);
+		// CPU side conversion of an assimp mesh, no Vulkan calls so it can run on any thread
+		static void DecodeMesh(const aiMesh* Mesh, std::vector<FVertex>& oVertices, std::vector<uint32_t>& oIndices);
+		// Box from aiProcess_GenBoundingBoxes, false when the importer did not fill it
+		static bool ImportedBounds(const aiMesh* Mesh, FMeshBounds& oBounds);
 		
 		cModel() = delete;
 		cModel(std::shared_ptr<cMesh> iMesh) { MeshList.push_back(iMesh); }
@@ -27,10 +31,17 @@ namespace VKE
 		/** Getters / Setters */
 		size_t GetMeshCount() const { return MeshList.size(); }
 		std::shared_ptr<cMesh> GetMesh(size_t idx) { assert(idx < GetMeshCount()); return MeshList[idx]; }
+		// Upload token of the batch holding the model's meshes and textures, the model can be drawn once it is reached
+		void SetUploadToken(uint64_t Token) { UploadToken = Token; }
+		uint64_t GetUploadToken() const { return UploadToken; }
 
 		cTransform Transform;
 	protected:
 		std::vector<std::shared_ptr<cMesh>> MeshList;
+		uint64_t UploadToken = 0;
+
+		// Meshes of a node tree in LoadNode order with their names
+		static void gatherMeshes(const std::string& iFileName, aiNode* Node, const aiScene* Scene, std::vector<std::pair<std::string, aiMesh*>>& oMeshes);
 		
 	};
 }
\ No newline at end of file
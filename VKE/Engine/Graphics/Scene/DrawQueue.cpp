@@ -0,0 +1,82 @@
+#include "DrawQueue.h"
+
+#include <string.h>
+
+namespace VKE
+{
+	const uint32_t RADIX_BITS = 8;
+	const uint32_t RADIX_SIZE = 1u << RADIX_BITS;
+	const uint32_t RADIX_PASSES = 64 / RADIX_BITS;
+
+	uint64_t cDrawQueue::MakeKey(uint32_t Pass, uint32_t Pipeline, uint32_t Block, uint32_t Material, uint32_t Mesh, float Depth)
+	{
+		// Bits of a non negative float grow with its value, the upper 16 keep the exponent and the leading mantissa bits
+		uint32_t DepthBits = 0;
+		if (Depth > 0.0f)
+		{
+			memcpy(&DepthBits, &Depth, sizeof(DepthBits));
+		}
+		return (static_cast<uint64_t>(Pass & 0xF) << 60)
+			| (static_cast<uint64_t>(Pipeline & 0xF) << 56)
+			| (static_cast<uint64_t>(Block & 0xFF) << 48)
+			| (static_cast<uint64_t>(Material & 0xFFFF) << 32)
+			| (static_cast<uint64_t>(Mesh & 0xFFFF) << 16)
+			| static_cast<uint64_t>(DepthBits >> 16);
+	}
+
+	void cDrawQueue::Sort()
+	{
+		PassCount = 0;
+		const size_t Count = Packets.size();
+		if (Count < 2)
+		{
+			return;
+		}
+		Scratch.resize(Count);
+
+		// 1. Histograms of every digit in one go
+		uint32_t Histograms[RADIX_PASSES][RADIX_SIZE] = {};
+		for (const FDrawPacket& Packet : Packets)
+		{
+			for (uint32_t Pass = 0; Pass < RADIX_PASSES; ++Pass)
+			{
+				++Histograms[Pass][(Packet.Key >> (Pass * RADIX_BITS)) & (RADIX_SIZE - 1)];
+			}
+		}
+
+		// 2. Scatter by each digit from the least significant one, skipping digits all keys share
+		FDrawPacket* pSrc = Packets.data();
+		FDrawPacket* pDst = Scratch.data();
+		for (uint32_t Pass = 0; Pass < RADIX_PASSES; ++Pass)
+		{
+			const uint32_t Shift = Pass * RADIX_BITS;
+			uint32_t* Histogram = Histograms[Pass];
+			if (Histogram[(pSrc[0].Key >> Shift) & (RADIX_SIZE - 1)] == Count)
+			{
+				continue;
+			}
+			// Start of every digit's range
+			uint32_t Offset = 0;
+			for (uint32_t Digit = 0; Digit < RADIX_SIZE; ++Digit)
+			{
+				const uint32_t DigitCount = Histogram[Digit];
+				Histogram[Digit] = Offset;
+				Offset += DigitCount;
+			}
+			for (size_t i = 0; i < Count; ++i)
+			{
+				pDst[Histogram[(pSrc[i].Key >> Shift) & (RADIX_SIZE - 1)]++] = pSrc[i];
+			}
+			FDrawPacket* pTemp = pSrc;
+			pSrc = pDst;
+			pDst = pTemp;
+			++PassCount;
+		}
+
+		// 3. Odd number of passes leaves the result in the scratch buffer
+		if (pSrc != Packets.data())
+		{
+			Packets.swap(Scratch);
+		}
+	}
+}
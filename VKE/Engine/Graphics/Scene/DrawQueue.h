@@ -0,0 +1,49 @@
+/*
+	DrawQueue orders draw packets by a 64 bit sort key, most significant field first:
+	pass (4) | pipeline (4) | geometry arena block (8) | material (16) | mesh (16) | depth bucket (16)
+	so sorted draws of the same state are adjacent and whoever submits them only changes what differs from the previous draw,
+	the depth bucket orders draws of the same state front to back for early-Z
+	Keys are sorted with an LSD radix sort, 8 bits per pass; a pass is skipped when all keys share its digit, fields that are
+	the same for every draw (one pass, one pipeline) cost nothing. The sort is stable, equal keys keep their push order
+	Fields are truncated to their width, the key only decides the order, submission still compares the real state
+	The queue keeps its memory between frames, it is used by one thread at a time
+*/
+#pragma once
+#include <vector>
+#include <stdint.h>
+#include <stddef.h>
+namespace VKE
+{
+	struct FDrawPacket
+	{
+		uint64_t Key;
+		uint32_t Index;									// Caller's draw the key belongs to
+	};
+
+	class cDrawQueue
+	{
+	public:
+		/* Constructors and destructor*/
+		cDrawQueue() {}
+		~cDrawQueue() {}
+		cDrawQueue(const cDrawQueue& i_other) = delete;
+		cDrawQueue& operator = (const cDrawQueue& i_other) = delete;
+
+		// Depth is any value growing with the distance to the camera, e.g. the squared distance, only its order is kept
+		static uint64_t MakeKey(uint32_t Pass, uint32_t Pipeline, uint32_t Block, uint32_t Material, uint32_t Mesh, float Depth);
+
+		void Clear() { Packets.clear(); }
+		void Reserve(size_t Count) { Packets.reserve(Count); }
+		void Push(uint64_t Key, uint32_t Index) { Packets.push_back({ Key, Index }); }
+		// Ascending keys
+		void Sort();
+
+		const std::vector<FDrawPacket>& GetPackets() const { return Packets; }
+		// Radix passes the last Sort needed, at most 8
+		uint32_t GetPassCount() const { return PassCount; }
+	private:
+		std::vector<FDrawPacket> Packets;
+		std::vector<FDrawPacket> Scratch;
+		uint32_t PassCount = 0;
+	};
+}
@@ -0,0 +1,133 @@
+#include "FrustumCuller.h"
+
+#include <math.h>
+#include <xmmintrin.h>
+#if defined(__AVX__)
+#include <immintrin.h>
+#endif
+
+namespace VKE
+{
+	// Widest register the culling loop may use, the component arrays are padded to it
+	const uint32_t CULL_MAX_LANES = 8;
+
+	void cFrustumCuller::ExtractPlanes(const glm::mat4& PVMatrix, glm::vec4 (&oPlanes)[6])
+	{
+		// glm is column major, Rows[i] is the i-th row of the matrix
+		glm::vec4 Rows[4];
+		for (int r = 0; r < 4; ++r)
+		{
+			Rows[r] = glm::vec4(PVMatrix[0][r], PVMatrix[1][r], PVMatrix[2][r], PVMatrix[3][r]);
+		}
+		oPlanes[0] = Rows[3] + Rows[0];		// Left
+		oPlanes[1] = Rows[3] - Rows[0];		// Right
+		oPlanes[2] = Rows[3] + Rows[1];		// Bottom (top when y is flipped, both are tested)
+		oPlanes[3] = Rows[3] - Rows[1];		// Top
+		oPlanes[4] = Rows[3] + Rows[2];		// Near, for -w < z, a bit conservative with a 0..1 depth range
+		oPlanes[5] = Rows[3] - Rows[2];		// Far
+		for (glm::vec4& Plane : oPlanes)
+		{
+			const float Length = glm::length(glm::vec3(Plane));
+			if (Length > 0.0f)
+			{
+				Plane /= Length;
+			}
+		}
+	}
+
+	uint32_t cFrustumCuller::Add(const glm::mat4& iModel, const glm::vec3& iCenter, const glm::vec3& iExtent)
+	{
+		if (Count == CenterX.size())
+		{
+			const size_t NewSize = CenterX.empty() ? CULL_MAX_LANES * 32 : CenterX.size() * 2;
+			for (std::vector<float>* Component : { &CenterX, &CenterY, &CenterZ, &ExtentX, &ExtentY, &ExtentZ })
+			{
+				Component->resize(NewSize, 0.0f);
+			}
+		}
+
+		// Center moves with the full matrix, the extent of the box around the rotated / scaled box is |M| * extent (Arvo)
+		const glm::vec3 Center = glm::vec3(iModel * glm::vec4(iCenter, 1.0f));
+		const glm::mat3 AbsM = glm::mat3(glm::abs(glm::vec3(iModel[0])), glm::abs(glm::vec3(iModel[1])), glm::abs(glm::vec3(iModel[2])));
+		const glm::vec3 Extent = AbsM * iExtent;
+
+		CenterX[Count] = Center.x; CenterY[Count] = Center.y; CenterZ[Count] = Center.z;
+		ExtentX[Count] = Extent.x; ExtentY[Count] = Extent.y; ExtentZ[Count] = Extent.z;
+		return Count++;
+	}
+
+	void cFrustumCuller::Cull(const glm::mat4& PVMatrix)
+	{
+		glm::vec4 Planes[6];
+		ExtractPlanes(PVMatrix, Planes);
+		Visible.resize(Count);
+		uint32_t VisibleCount = 0;
+
+		// Per plane and box: distance of the center d = n . c + w, projected radius r = |n| . e, the box is outside when d + r < 0
+#if defined(__AVX__)
+		const uint32_t LANES = 8;
+		__m256 N[6][3], AbsN[6][3], W[6];
+		for (int p = 0; p < 6; ++p)
+		{
+			for (int c = 0; c < 3; ++c)
+			{
+				N[p][c] = _mm256_set1_ps(Planes[p][c]);
+				AbsN[p][c] = _mm256_set1_ps(fabsf(Planes[p][c]));
+			}
+			W[p] = _mm256_set1_ps(Planes[p].w);
+		}
+		const __m256 Zero = _mm256_setzero_ps();
+		for (uint32_t i = 0; i < Count; i += LANES)
+		{
+			const __m256 CX = _mm256_loadu_ps(&CenterX[i]), CY = _mm256_loadu_ps(&CenterY[i]), CZ = _mm256_loadu_ps(&CenterZ[i]);
+			const __m256 EX = _mm256_loadu_ps(&ExtentX[i]), EY = _mm256_loadu_ps(&ExtentY[i]), EZ = _mm256_loadu_ps(&ExtentZ[i]);
+			__m256 Inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+			for (int p = 0; p < 6; ++p)
+			{
+				const __m256 D = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(N[p][0], CX), _mm256_mul_ps(N[p][1], CY)), _mm256_add_ps(_mm256_mul_ps(N[p][2], CZ), W[p]));
+				const __m256 R = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(AbsN[p][0], EX), _mm256_mul_ps(AbsN[p][1], EY)), _mm256_mul_ps(AbsN[p][2], EZ));
+				Inside = _mm256_and_ps(Inside, _mm256_cmp_ps(_mm256_add_ps(D, R), Zero, _CMP_GE_OQ));
+			}
+			uint32_t Mask = static_cast<uint32_t>(_mm256_movemask_ps(Inside));
+#else
+		const uint32_t LANES = 4;
+		__m128 N[6][3], AbsN[6][3], W[6];
+		for (int p = 0; p < 6; ++p)
+		{
+			for (int c = 0; c < 3; ++c)
+			{
+				N[p][c] = _mm_set1_ps(Planes[p][c]);
+				AbsN[p][c] = _mm_set1_ps(fabsf(Planes[p][c]));
+			}
+			W[p] = _mm_set1_ps(Planes[p].w);
+		}
+		const __m128 Zero = _mm_setzero_ps();
+		for (uint32_t i = 0; i < Count; i += LANES)
+		{
+			const __m128 CX = _mm_loadu_ps(&CenterX[i]), CY = _mm_loadu_ps(&CenterY[i]), CZ = _mm_loadu_ps(&CenterZ[i]);
+			const __m128 EX = _mm_loadu_ps(&ExtentX[i]), EY = _mm_loadu_ps(&ExtentY[i]), EZ = _mm_loadu_ps(&ExtentZ[i]);
+			__m128 Inside = _mm_cmpeq_ps(Zero, Zero);
+			for (int p = 0; p < 6; ++p)
+			{
+				const __m128 D = _mm_add_ps(_mm_add_ps(_mm_mul_ps(N[p][0], CX), _mm_mul_ps(N[p][1], CY)), _mm_add_ps(_mm_mul_ps(N[p][2], CZ), W[p]));
+				const __m128 R = _mm_add_ps(_mm_add_ps(_mm_mul_ps(AbsN[p][0], EX), _mm_mul_ps(AbsN[p][1], EY)), _mm_mul_ps(AbsN[p][2], EZ));
+				Inside = _mm_and_ps(Inside, _mm_cmpge_ps(_mm_add_ps(D, R), Zero));
+			}
+			uint32_t Mask = static_cast<uint32_t>(_mm_movemask_ps(Inside));
+#endif
+			// Lanes past the last box hold stale data
+			if (Count - i < LANES)
+			{
+				Mask &= (1u << (Count - i)) - 1;
+			}
+			for (uint32_t Lane = 0; Mask != 0; ++Lane, Mask >>= 1)
+			{
+				if (Mask & 1)
+				{
+					Visible[VisibleCount++] = i + Lane;
+				}
+			}
+		}
+		Visible.resize(VisibleCount);
+	}
+}
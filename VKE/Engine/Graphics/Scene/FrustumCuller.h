@@ -0,0 +1,44 @@
+/*
+	FrustumCuller tests world space bounding boxes against the camera frustum on the CPU
+	Boxes are kept as structure of arrays (center x / y / z, extent x / y / z), so one SIMD register holds the same component of
+	4 boxes (SSE) or 8 boxes (AVX when the compiler targets it), every plane is tested against a whole register at once
+	A box is outside when it lies fully behind one of the planes, the test is conservative: boxes crossing a frustum corner stay visible
+	Cull writes the indices of the visible boxes in ascending order, in the order they were added
+	Memory is kept between frames, Clear / Add / Cull run on one thread
+*/
+#pragma once
+#include "glm/glm.hpp"
+
+#include <vector>
+#include <stdint.h>
+namespace VKE
+{
+	class cFrustumCuller
+	{
+	public:
+		/* Constructors and destructor*/
+		cFrustumCuller() {}
+		~cFrustumCuller() {}
+		cFrustumCuller(const cFrustumCuller& i_other) = delete;
+		cFrustumCuller& operator = (const cFrustumCuller& i_other) = delete;
+
+		// Gribb / Hartmann planes of the view projection, normals point inside
+		static void ExtractPlanes(const glm::mat4& PVMatrix, glm::vec4 (&oPlanes)[6]);
+
+		void Clear() { Count = 0; }
+		// Local space box (center, half size) moved into world space by the model matrix, returns the box index
+		uint32_t Add(const glm::mat4& iModel, const glm::vec3& iCenter, const glm::vec3& iExtent);
+		// Fill the visible list with the boxes inside the frustum of the view projection
+		void Cull(const glm::mat4& PVMatrix);
+
+		const std::vector<uint32_t>& GetVisible() const { return Visible; }
+		uint32_t GetTestedCount() const { return Count; }
+		uint32_t GetVisibleCount() const { return static_cast<uint32_t>(Visible.size()); }
+	private:
+		// Components of the boxes, sized in multiples of 8 so the last register never reads past the end
+		std::vector<float> CenterX, CenterY, CenterZ;
+		std::vector<float> ExtentX, ExtentY, ExtentZ;
+		std::vector<uint32_t> Visible;
+		uint32_t Count = 0;
+	};
+}
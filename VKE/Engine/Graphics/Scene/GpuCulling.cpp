@@ -0,0 +1,256 @@
+#include "GpuCulling.h"
+#include "InstanceBatcher.h"
+#include "FrustumCuller.h"
+#include "BufferFormats.h"
+#include "Descriptors/DescriptorAllocator.h"
+
+#include "assert.h"
+
+namespace VKE
+{
+	// local_size_x of cull.comp
+	const uint32_t CULL_GROUP_SIZE = 64;
+	const uint32_t CULL_BINDING_COUNT = 5;
+
+	bool cGpuCulling::init(FMainDevice* iMainDevice, VkDescriptorSetLayout iObjectTableLayout)
+	{
+		pMainDevice = iMainDevice;
+
+		// 1. Descriptor set layout: instances, batches, draws, visible instances, stats, all storage buffers
+		VkDescriptorSetLayoutBinding Bindings[CULL_BINDING_COUNT] = {};
+		for (uint32_t i = 0; i < CULL_BINDING_COUNT; ++i)
+		{
+			Bindings[i].binding = i;
+			Bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			Bindings[i].descriptorCount = 1;
+			Bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		}
+		VkDescriptorSetLayoutCreateInfo LayoutCreateInfo = {};
+		LayoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		LayoutCreateInfo.bindingCount = CULL_BINDING_COUNT;
+		LayoutCreateInfo.pBindings = Bindings;
+		VkResult Result = vkCreateDescriptorSetLayout(pMainDevice->LD, &LayoutCreateInfo, nullptr, &DescriptorSetLayout);
+		RESULT_CHECK(Result, "Fail to create culling descriptor set layout.");
+
+		// 2. Pipeline
+		if (!createPipeline(iObjectTableLayout))
+		{
+			return false;
+		}
+
+		// 3. Buffers and sets of every frame slot, the sets live as long as the descriptor allocator
+		for (FSlot& Slot : Slots)
+		{
+			Slot.DescriptorSet = pMainDevice->DescriptorAllocator->Allocate(DescriptorSetLayout);
+			if (Slot.DescriptorSet == VK_NULL_HANDLE || !reserve(Slot, INSTANCE_BUFFER_INITIAL_CAPACITY, INSTANCE_BUFFER_INITIAL_CAPACITY))
+			{
+				return false;
+			}
+			if (!Slot.StatsBuffer.CreateBufferAndAllocateMemory(pMainDevice, sizeof(uint32_t),
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, EMemoryCategory::Other))
+			{
+				return false;
+			}
+			Slot.pMappedStats = Slot.StatsBuffer.Map();
+			*static_cast<uint32_t*>(Slot.pMappedStats) = 0;
+			Slot.StatsBuffer.Flush(0, sizeof(uint32_t));
+		}
+		return true;
+	}
+
+	void cGpuCulling::cleanUp()
+	{
+		for (FSlot& Slot : Slots)
+		{
+			releaseSlotBuffers(Slot);
+			if (Slot.pMappedStats)
+			{
+				Slot.StatsBuffer.Unmap();
+				Slot.pMappedStats = nullptr;
+			}
+			Slot.StatsBuffer.cleanUp();
+			Slot.InstanceCount = 0;
+			Slot.BatchCount = 0;
+			Slot.DescriptorSet = VK_NULL_HANDLE;
+		}
+		vkDestroyPipeline(pMainDevice->LD, Pipeline, nullptr);
+		vkDestroyPipelineLayout(pMainDevice->LD, PipelineLayout, nullptr);
+		vkDestroyDescriptorSetLayout(pMainDevice->LD, DescriptorSetLayout, nullptr);
+		Pipeline = VK_NULL_HANDLE;
+		PipelineLayout = VK_NULL_HANDLE;
+		DescriptorSetLayout = VK_NULL_HANDLE;
+		TestedCount = 0;
+		VisibleCount = 0;
+	}
+
+	bool cGpuCulling::Prepare(uint32_t FrameIndex, const cInstanceBatcher& Batcher)
+	{
+		assert(FrameIndex < MAX_FRAME_DRAWS);
+		FSlot& Slot = Slots[FrameIndex];
+		const uint32_t BatchCount = static_cast<uint32_t>(Batcher.GetBatches(FrameIndex).size());
+		Slot.InstanceCount = 0;
+		Slot.BatchCount = 0;
+		if (!reserve(Slot, Batcher.GetInstanceCount(FrameIndex), BatchCount))
+		{
+			return false;
+		}
+		Slot.InstanceCount = Batcher.GetInstanceCount(FrameIndex);
+		Slot.BatchCount = BatchCount;
+
+		// The batcher may have replaced its buffers with this build, point every binding at the current ones
+		const cBuffer* Buffers[CULL_BINDING_COUNT] = { &Batcher.GetInstanceBuffer(FrameIndex), &Batcher.GetBatchBuffer(FrameIndex), &Slot.DrawBuffer, &Slot.VisibleBuffer, &Slot.StatsBuffer };
+		VkDescriptorBufferInfo BufferInfos[CULL_BINDING_COUNT] = {};
+		VkWriteDescriptorSet SetWrites[CULL_BINDING_COUNT] = {};
+		for (uint32_t i = 0; i < CULL_BINDING_COUNT; ++i)
+		{
+			BufferInfos[i].buffer = Buffers[i]->GetvkBuffer();
+			BufferInfos[i].offset = 0;
+			BufferInfos[i].range = VK_WHOLE_SIZE;
+
+			SetWrites[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			SetWrites[i].dstSet = Slot.DescriptorSet;
+			SetWrites[i].dstBinding = i;
+			SetWrites[i].dstArrayElement = 0;
+			SetWrites[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			SetWrites[i].descriptorCount = 1;
+			SetWrites[i].pBufferInfo = &BufferInfos[i];
+		}
+		vkUpdateDescriptorSets(pMainDevice->LD, CULL_BINDING_COUNT, SetWrites, 0, nullptr);
+		return true;
+	}
+
+	void cGpuCulling::Record(VkCommandBuffer CB, uint32_t FrameIndex, const glm::mat4& PVMatrix, VkDescriptorSet ObjectTableSet)
+	{
+		assert(FrameIndex < MAX_FRAME_DRAWS);
+		FSlot& Slot = Slots[FrameIndex];
+		if (Slot.InstanceCount == 0)
+		{
+			// Nothing to cull and nothing drawn, the GPU is done with the slot so the count can be cleared here
+			*static_cast<uint32_t*>(Slot.pMappedStats) = 0;
+			Slot.StatsBuffer.Flush(0, sizeof(uint32_t));
+			return;
+		}
+
+		// 1. Clear instance counts of the draws and the visible count, a batch without visible instances keeps a zero draw
+		vkCmdFillBuffer(CB, Slot.DrawBuffer.GetvkBuffer(), 0, sizeof(VkDrawIndexedIndirectCommand) * Slot.BatchCount, 0);
+		vkCmdFillBuffer(CB, Slot.StatsBuffer.GetvkBuffer(), 0, sizeof(uint32_t), 0);
+
+		VkMemoryBarrier ClearBarrier = {};
+		ClearBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		ClearBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		ClearBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		vkCmdPipelineBarrier(CB, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &ClearBarrier, 0, nullptr, 0, nullptr);
+
+		// 2. One thread per instance
+		BufferFormats::FCullConstants Constants;
+		cFrustumCuller::ExtractPlanes(PVMatrix, Constants.FrustumPlanes);
+		Constants.InstanceCount = Slot.InstanceCount;
+
+		vkCmdBindPipeline(CB, VK_PIPELINE_BIND_POINT_COMPUTE, Pipeline);
+		const VkDescriptorSet DescriptorSetGroup[] = { ObjectTableSet, Slot.DescriptorSet };
+		vkCmdBindDescriptorSets(CB, VK_PIPELINE_BIND_POINT_COMPUTE, PipelineLayout, 0, 2, DescriptorSetGroup, 0, nullptr);
+		vkCmdPushConstants(CB, PipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(Constants), &Constants);
+		vkCmdDispatch(CB, (Slot.InstanceCount + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+
+		// 3. Draws read the commands and the visible instances, the CPU reads the count once the slot comes around again
+		VkMemoryBarrier CullBarrier = {};
+		CullBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		CullBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		CullBarrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_HOST_READ_BIT;
+		vkCmdPipelineBarrier(CB, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_HOST_BIT,
+			0, 1, &CullBarrier, 0, nullptr, 0, nullptr);
+	}
+
+	void cGpuCulling::ReadStats(uint32_t FrameIndex)
+	{
+		assert(FrameIndex < MAX_FRAME_DRAWS);
+		FSlot& Slot = Slots[FrameIndex];
+		Slot.StatsBuffer.Invalidate(0, sizeof(uint32_t));
+		VisibleCount = *static_cast<const uint32_t*>(Slot.pMappedStats);
+		TestedCount = Slot.InstanceCount;
+	}
+
+	bool cGpuCulling::createPipeline(VkDescriptorSetLayout iObjectTableLayout)
+	{
+		// 1. Object table and the culling set, planes and instance count are pushed
+		const VkDescriptorSetLayout SetLayouts[] = { iObjectTableLayout, DescriptorSetLayout };
+		VkPushConstantRange PushConstantRange = {};
+		PushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		PushConstantRange.offset = 0;
+		PushConstantRange.size = sizeof(BufferFormats::FCullConstants);
+
+		VkPipelineLayoutCreateInfo PipelineLayoutCreateInfo = {};
+		PipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		PipelineLayoutCreateInfo.setLayoutCount = 2;
+		PipelineLayoutCreateInfo.pSetLayouts = SetLayouts;
+		PipelineLayoutCreateInfo.pushConstantRangeCount = 1;
+		PipelineLayoutCreateInfo.pPushConstantRanges = &PushConstantRange;
+		VkResult Result = vkCreatePipelineLayout(pMainDevice->LD, &PipelineLayoutCreateInfo, nullptr, &PipelineLayout);
+		RESULT_CHECK(Result, "Fail to create culling pipeline layout.");
+		if (Result != VK_SUCCESS)
+		{
+			return false;
+		}
+
+		// 2. Load shader
+		FShaderModuleScopeGuard ComputeShaderModule;
+		std::vector<char> ComputeShaderCode = FileIO::ReadFile("Content/Shaders/cull.comp.spv");
+		ComputeShaderModule.CreateShaderModule(pMainDevice->LD, ComputeShaderCode);
+
+		// 3. Create the compute pipeline
+		VkComputePipelineCreateInfo ComputePipelineCreateInfo = {};
+		ComputePipelineCreateInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+		ComputePipelineCreateInfo.layout = PipelineLayout;
+		ComputePipelineCreateInfo.stage = Helpers::PipelineShaderStageCreateInfo(VK_SHADER_STAGE_COMPUTE_BIT, ComputeShaderModule.ShaderModule);
+		ComputePipelineCreateInfo.basePipelineHandle = VK_NULL_HANDLE;
+		ComputePipelineCreateInfo.basePipelineIndex = -1;
+
+		Result = vkCreateComputePipelines(pMainDevice->LD, VK_NULL_HANDLE, 1, &ComputePipelineCreateInfo, nullptr, &Pipeline);
+		RESULT_CHECK(Result, "Fail to create culling pipeline.");
+		return Result == VK_SUCCESS;
+	}
+
+	bool cGpuCulling::reserve(FSlot& Slot, uint32_t iInstanceCount, uint32_t iBatchCount)
+	{
+		if (iInstanceCount <= Slot.VisibleCapacity && iBatchCount <= Slot.DrawCapacity)
+		{
+			return true;
+		}
+		// Same growth as the batcher, so both reallocate at the same builds
+		uint32_t NewVisibleCapacity = Slot.VisibleCapacity > 0 ? Slot.VisibleCapacity : INSTANCE_BUFFER_INITIAL_CAPACITY;
+		while (NewVisibleCapacity < iInstanceCount)
+		{
+			NewVisibleCapacity *= 2;
+		}
+		uint32_t NewDrawCapacity = Slot.DrawCapacity > 0 ? Slot.DrawCapacity : INSTANCE_BUFFER_INITIAL_CAPACITY;
+		while (NewDrawCapacity < iBatchCount)
+		{
+			NewDrawCapacity *= 2;
+		}
+		releaseSlotBuffers(Slot);
+
+		// Only the GPU writes and reads them
+		if (!Slot.DrawBuffer.CreateBufferAndAllocateMemory(pMainDevice, sizeof(VkDrawIndexedIndirectCommand) * NewDrawCapacity,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, EMemoryCategory::Other))
+		{
+			return false;
+		}
+		if (!Slot.VisibleBuffer.CreateBufferAndAllocateMemory(pMainDevice, sizeof(BufferFormats::FInstanceData) * NewVisibleCapacity,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, EMemoryCategory::Other))
+		{
+			Slot.DrawBuffer.cleanUp();
+			return false;
+		}
+		Slot.VisibleCapacity = NewVisibleCapacity;
+		Slot.DrawCapacity = NewDrawCapacity;
+		return true;
+	}
+
+	void cGpuCulling::releaseSlotBuffers(FSlot& Slot)
+	{
+		Slot.DrawBuffer.cleanUp();
+		Slot.VisibleBuffer.cleanUp();
+		Slot.VisibleCapacity = 0;
+		Slot.DrawCapacity = 0;
+	}
+}
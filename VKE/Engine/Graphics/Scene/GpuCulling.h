@@ -0,0 +1,77 @@
+/*
+	GpuCulling turns the batches of the instance batcher into indirect draws on the GPU
+	A compute dispatch tests the bounding box of every mesh instance, moved by its object table entry, against the camera frustum,
+	packs the visible instances (object and texture index) from their batch's FirstInstance on and writes one VkDrawIndexedIndirectCommand per batch,
+	batches without a visible instance keep a zero draw
+	The dispatch goes into the frame's primary command buffer ahead of the render pass, so it sees the object table and camera of that frame,
+	recorded model draws only reference its output buffers, they stay cached until the CPU frustum culler's visible meshes change
+	Every frame slot owns its output buffers, Prepare grows them with the batcher's and the GPU has to be done with the slot then
+*/
+#pragma once
+#define GLFW_INCLUDE_VULKAN
+#include "GLFW/glfw3.h"
+
+#include "Utilities.h"
+#include "Buffer/Buffer.h"
+#include "glm/glm.hpp"
+
+namespace VKE
+{
+	class cInstanceBatcher;
+
+	class cGpuCulling
+	{
+	public:
+		/* Constructors and destructor*/
+		cGpuCulling() {}
+		~cGpuCulling() {}
+		cGpuCulling(const cGpuCulling& i_other) = delete;
+		cGpuCulling& operator = (const cGpuCulling& i_other) = delete;
+
+		// The object table is set 0 of the culling pipeline
+		bool init(FMainDevice* iMainDevice, VkDescriptorSetLayout iObjectTableLayout);
+		void cleanUp();
+
+		// Size the slot's output for the batcher's latest build of it and point the slot's descriptor set at the buffers
+		// Call after every build, before recording draws that reference the output buffers
+		bool Prepare(uint32_t FrameIndex, const cInstanceBatcher& Batcher);
+		// Clear the slot's draws and cull its instances, outside of a render pass
+		void Record(VkCommandBuffer CB, uint32_t FrameIndex, const glm::mat4& PVMatrix, VkDescriptorSet ObjectTableSet);
+		// Visible count of the slot's last culling, the GPU has to be done with the slot
+		void ReadStats(uint32_t FrameIndex);
+
+		// VkDrawIndexedIndirectCommand per batch, in batch order
+		const VkBuffer& GetDrawBuffer(uint32_t FrameIndex) const { return Slots[FrameIndex].DrawBuffer.GetvkBuffer(); }
+		// BufferFormats::FInstanceData per visible instance, bound at INSTANCE_BUFFER_BIND_ID
+		const VkBuffer& GetVisibleInstanceBuffer(uint32_t FrameIndex) const { return Slots[FrameIndex].VisibleBuffer.GetvkBuffer(); }
+		// Result of the last ReadStats
+		uint32_t GetTestedCount() const { return TestedCount; }
+		uint32_t GetVisibleCount() const { return VisibleCount; }
+	private:
+		struct FSlot
+		{
+			cBuffer DrawBuffer;
+			cBuffer VisibleBuffer;
+			cBuffer StatsBuffer;							// Host visible visible count, read back when the slot comes around again
+			void* pMappedStats = nullptr;
+			uint32_t DrawCapacity = 0;
+			uint32_t VisibleCapacity = 0;
+			uint32_t InstanceCount = 0;
+			uint32_t BatchCount = 0;
+			VkDescriptorSet DescriptorSet = VK_NULL_HANDLE;
+		};
+
+		bool createPipeline(VkDescriptorSetLayout iObjectTableLayout);
+		// Replace the slot's output buffers when they are smaller than the requested counts
+		bool reserve(FSlot& Slot, uint32_t iInstanceCount, uint32_t iBatchCount);
+		void releaseSlotBuffers(FSlot& Slot);
+
+		FMainDevice* pMainDevice = nullptr;
+		FSlot Slots[MAX_FRAME_DRAWS];
+		VkDescriptorSetLayout DescriptorSetLayout = VK_NULL_HANDLE;
+		VkPipelineLayout PipelineLayout = VK_NULL_HANDLE;
+		VkPipeline Pipeline = VK_NULL_HANDLE;
+		uint32_t TestedCount = 0;
+		uint32_t VisibleCount = 0;
+	};
+}
@@ -0,0 +1,162 @@
+#include "InstanceBatcher.h"
+#include "BufferFormats.h"
+#include "Mesh/Mesh.h"
+#include "Material/Material.h"
+
+#include "assert.h"
+
+namespace VKE
+{
+	bool cInstanceBatcher::init(FMainDevice* iMainDevice, uint32_t iInitialCapacity)
+	{
+		assert(iInitialCapacity > 0);
+		pMainDevice = iMainDevice;
+		for (FSlot& Slot : Slots)
+		{
+			if (!reserve(Slot, iInitialCapacity, iInitialCapacity))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void cInstanceBatcher::cleanUp()
+	{
+		for (FSlot& Slot : Slots)
+		{
+			releaseSlotBuffers(Slot);
+			Slot.InstanceCount = 0;
+			Slot.Batches.clear();
+		}
+		BatchCount = 0;
+		InstanceCount = 0;
+	}
+
+	bool cInstanceBatcher::Build(uint32_t FrameIndex, const FInstanceDraw* iDraws, size_t DrawCount)
+	{
+		assert(FrameIndex < MAX_FRAME_DRAWS);
+		FSlot& Slot = Slots[FrameIndex];
+		Slot.Batches.clear();
+		Slot.InstanceCount = 0;
+		BatchCount = 0;
+		InstanceCount = 0;
+
+		// 1. Same geometry arena block next to each other first, so consecutive batches share the buffer binds,
+		// then same material and same mesh, equal pairs end up adjacent, nearest first
+		DrawQueue.Clear();
+		DrawQueue.Reserve(DrawCount);
+		for (size_t i = 0; i < DrawCount; ++i)
+		{
+			const FInstanceDraw& Draw = iDraws[i];
+			DrawQueue.Push(cDrawQueue::MakeKey(0, 0, Draw.Mesh->GetGeometry().Block, Draw.MaterialID, Draw.Mesh->GetID(), Draw.Depth), static_cast<uint32_t>(i));
+		}
+		DrawQueue.Sort();
+		const std::vector<FDrawPacket>& Packets = DrawQueue.GetPackets();
+
+		// 2. Batches in sorted order, a new one starts whenever the mesh or material changes
+		for (size_t i = 0; i < DrawCount; ++i)
+		{
+			const FInstanceDraw& Draw = iDraws[Packets[i].Index];
+			if (Slot.Batches.empty() || Slot.Batches.back().Mesh != Draw.Mesh || Slot.Batches.back().MaterialID != Draw.MaterialID)
+			{
+				Slot.Batches.push_back({ Draw.Mesh, Draw.MaterialID, static_cast<uint32_t>(i), 0 });
+			}
+			++Slot.Batches.back().InstanceCount;
+		}
+
+		// 3. Room for every instance and batch, the GPU is done with this slot so the old buffers can go
+		if (!reserve(Slot, static_cast<uint32_t>(DrawCount), static_cast<uint32_t>(Slot.Batches.size())))
+		{
+			Slot.Batches.clear();
+			return false;
+		}
+
+		// 4. Culling input, instances remember their batch, batches carry what culling and the indirect draw need
+		BufferFormats::FCullInstance* pInstances = static_cast<BufferFormats::FCullInstance*>(Slot.pMappedInstances);
+		BufferFormats::FCullBatch* pBatches = static_cast<BufferFormats::FCullBatch*>(Slot.pMappedBatches);
+		for (size_t b = 0; b < Slot.Batches.size(); ++b)
+		{
+			const FDrawBatch& Batch = Slot.Batches[b];
+			BufferFormats::FCullBatch& CullBatch = pBatches[b];
+			CullBatch.BoundsCenter = glm::vec4(Batch.Mesh->GetBoundsCenter(), 0.0f);
+			CullBatch.BoundsExtent = glm::vec4(Batch.Mesh->GetBoundsExtent(), 0.0f);
+			CullBatch.IndexCount = Batch.Mesh->GetIndexCount();
+			CullBatch.FirstIndex = Batch.Mesh->GetFirstIndex();
+			CullBatch.VertexOffset = Batch.Mesh->GetVertexOffset();
+			CullBatch.FirstInstance = Batch.FirstInstance;
+			CullBatch.TextureID = cMaterial::Get(Batch.MaterialID)->GetAlbedoTextureID();
+			for (uint32_t i = Batch.FirstInstance; i < Batch.FirstInstance + Batch.InstanceCount; ++i)
+			{
+				pInstances[i].ObjectIndex = iDraws[Packets[i].Index].ObjectIndex;
+				pInstances[i].BatchIndex = static_cast<uint32_t>(b);
+			}
+		}
+		if (DrawCount > 0)
+		{
+			Slot.InstanceBuffer.Flush(0, sizeof(BufferFormats::FCullInstance) * DrawCount);
+			Slot.BatchBuffer.Flush(0, sizeof(BufferFormats::FCullBatch) * Slot.Batches.size());
+		}
+
+		Slot.InstanceCount = static_cast<uint32_t>(DrawCount);
+		BatchCount = static_cast<uint32_t>(Slot.Batches.size());
+		InstanceCount = static_cast<uint32_t>(DrawCount);
+		return true;
+	}
+
+	bool cInstanceBatcher::reserve(FSlot& Slot, uint32_t iInstanceCount, uint32_t iBatchCount)
+	{
+		if (iInstanceCount <= Slot.InstanceCapacity && iBatchCount <= Slot.BatchCapacity)
+		{
+			return true;
+		}
+		// Double the capacities so a growing scene reallocates only a few times
+		uint32_t NewInstanceCapacity = Slot.InstanceCapacity > 0 ? Slot.InstanceCapacity : INSTANCE_BUFFER_INITIAL_CAPACITY;
+		while (NewInstanceCapacity < iInstanceCount)
+		{
+			NewInstanceCapacity *= 2;
+		}
+		uint32_t NewBatchCapacity = Slot.BatchCapacity > 0 ? Slot.BatchCapacity : INSTANCE_BUFFER_INITIAL_CAPACITY;
+		while (NewBatchCapacity < iBatchCount)
+		{
+			NewBatchCapacity *= 2;
+		}
+		releaseSlotBuffers(Slot);
+
+		// Host visible so the CPU writes straight into them, flushed explicitly in case the memory is not coherent
+		if (!Slot.InstanceBuffer.CreateBufferAndAllocateMemory(pMainDevice, sizeof(BufferFormats::FCullInstance) * NewInstanceCapacity,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, EMemoryCategory::Uniform))
+		{
+			return false;
+		}
+		if (!Slot.BatchBuffer.CreateBufferAndAllocateMemory(pMainDevice, sizeof(BufferFormats::FCullBatch) * NewBatchCapacity,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, EMemoryCategory::Uniform))
+		{
+			Slot.InstanceBuffer.cleanUp();
+			return false;
+		}
+		Slot.pMappedInstances = Slot.InstanceBuffer.Map();
+		Slot.pMappedBatches = Slot.BatchBuffer.Map();
+		Slot.InstanceCapacity = NewInstanceCapacity;
+		Slot.BatchCapacity = NewBatchCapacity;
+		return true;
+	}
+
+	void cInstanceBatcher::releaseSlotBuffers(FSlot& Slot)
+	{
+		if (Slot.pMappedInstances)
+		{
+			Slot.InstanceBuffer.Unmap();
+			Slot.pMappedInstances = nullptr;
+		}
+		if (Slot.pMappedBatches)
+		{
+			Slot.BatchBuffer.Unmap();
+			Slot.pMappedBatches = nullptr;
+		}
+		Slot.InstanceBuffer.cleanUp();
+		Slot.BatchBuffer.cleanUp();
+		Slot.InstanceCapacity = 0;
+		Slot.BatchCapacity = 0;
+	}
+}
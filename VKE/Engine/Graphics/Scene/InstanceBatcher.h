@@ -0,0 +1,91 @@
+/*
+	InstanceBatcher groups mesh draws that share a mesh and a material into one instanced draw
+	Draws are ordered through a draw queue by geometry arena block, material, mesh and depth,
+	so a run of batches of one block is a single multi draw and a batch lists its instances front to back
+	It writes the input of GPU culling: every instance (object index + batch) and every batch (mesh bounds, index range, instance range, texture)
+	go into storage buffers, the culling pass packs the visible object indices of a batch at its FirstInstance and
+	writes the batch's indirect draw
+	Every frame slot owns its buffers and batches, they only change when the slot's model draws are recorded again,
+	so a steady scene neither rebuilds the batches nor writes the buffers
+	The buffers grow on demand, the GPU has to be done with the slot when it is built
+*/
+#pragma once
+#define GLFW_INCLUDE_VULKAN
+#include "GLFW/glfw3.h"
+
+#include "Utilities.h"
+#include "Buffer/Buffer.h"
+#include "Scene/DrawQueue.h"
+
+#include <vector>
+namespace VKE
+{
+	class cMesh;
+
+	// One mesh of one object to draw
+	struct FInstanceDraw
+	{
+		const cMesh* Mesh;
+		uint32_t MaterialID;
+		uint32_t ObjectIndex;
+		float Depth;									// Squared distance to the camera
+	};
+
+	// Instances [FirstInstance, FirstInstance + InstanceCount) of the instance buffer drawn with one call
+	struct FDrawBatch
+	{
+		const cMesh* Mesh;
+		uint32_t MaterialID;
+		uint32_t FirstInstance;
+		uint32_t InstanceCount;
+	};
+
+	class cInstanceBatcher
+	{
+	public:
+		/* Constructors and destructor*/
+		cInstanceBatcher() {}
+		~cInstanceBatcher() {}
+		cInstanceBatcher(const cInstanceBatcher& i_other) = delete;
+		cInstanceBatcher& operator = (const cInstanceBatcher& i_other) = delete;
+
+		bool init(FMainDevice* iMainDevice, uint32_t iInitialCapacity = INSTANCE_BUFFER_INITIAL_CAPACITY);
+		void cleanUp();
+
+		// Sort the draws by arena block, material, mesh and depth, write the frame slot's instance / batch buffers and batches
+		bool Build(uint32_t FrameIndex, const FInstanceDraw* iDraws, size_t DrawCount);
+
+		const std::vector<FDrawBatch>& GetBatches(uint32_t FrameIndex) const { return Slots[FrameIndex].Batches; }
+		// BufferFormats::FCullInstance per instance, sorted by batch
+		const cBuffer& GetInstanceBuffer(uint32_t FrameIndex) const { return Slots[FrameIndex].InstanceBuffer; }
+		// BufferFormats::FCullBatch per batch
+		const cBuffer& GetBatchBuffer(uint32_t FrameIndex) const { return Slots[FrameIndex].BatchBuffer; }
+		uint32_t GetInstanceCount(uint32_t FrameIndex) const { return Slots[FrameIndex].InstanceCount; }
+		// Result of the last Build
+		uint32_t GetBatchCount() const { return BatchCount; }
+		uint32_t GetInstanceCount() const { return InstanceCount; }
+		uint32_t GetSortPassCount() const { return DrawQueue.GetPassCount(); }
+	private:
+		struct FSlot
+		{
+			cBuffer InstanceBuffer;
+			cBuffer BatchBuffer;
+			void* pMappedInstances = nullptr;
+			void* pMappedBatches = nullptr;
+			uint32_t InstanceCapacity = 0;
+			uint32_t BatchCapacity = 0;
+			uint32_t InstanceCount = 0;
+			std::vector<FDrawBatch> Batches;
+		};
+
+		// Replace the slot's buffers when they are smaller than the requested counts
+		bool reserve(FSlot& Slot, uint32_t iInstanceCount, uint32_t iBatchCount);
+		void releaseSlotBuffers(FSlot& Slot);
+
+		FMainDevice* pMainDevice = nullptr;
+		FSlot Slots[MAX_FRAME_DRAWS];
+		cDrawQueue DrawQueue;
+		uint32_t BatchCount = 0;
+		uint32_t InstanceCount = 0;
+	};
+}
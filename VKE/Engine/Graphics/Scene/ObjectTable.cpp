@@ -0,0 +1,176 @@
+#include "ObjectTable.h"
+#include "Descriptors/DescriptorAllocator.h"
+
+#include "assert.h"
+
+namespace VKE
+{
+	static_assert(MAX_FRAME_DRAWS <= 8, "cObjectTable keeps one dirty bit per frame slot in a byte");
+	const uint8_t ALL_SLOTS_DIRTY = static_cast<uint8_t>((1u << MAX_FRAME_DRAWS) - 1);
+
+	bool cObjectTable::init(FMainDevice* iMainDevice, uint32_t iInitialCapacity)
+	{
+		pMainDevice = iMainDevice;
+		Count = 0;
+		Capacity = iInitialCapacity > 0 ? iInitialCapacity : 1;
+		Objects.assign(Capacity, BufferFormats::FObjectData());
+		DirtyMask.assign(Capacity, 0);
+
+		// 1. Descriptor set layout, one storage buffer read by vertex shaders and the culling pass
+		VkDescriptorSetLayoutBinding Binding = {};
+		Binding.binding = 0;
+		Binding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		Binding.descriptorCount = 1;
+		Binding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_COMPUTE_BIT;
+
+		VkDescriptorSetLayoutCreateInfo LayoutCreateInfo = {};
+		LayoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		LayoutCreateInfo.bindingCount = 1;
+		LayoutCreateInfo.pBindings = &Binding;
+		VkResult Result = vkCreateDescriptorSetLayout(pMainDevice->LD, &LayoutCreateInfo, nullptr, &DescriptorSetLayout);
+		RESULT_CHECK(Result, "Fail to create object table descriptor set layout.");
+
+		// 2. Buffers and sets of every frame slot, the sets live as long as the descriptor allocator
+		for (FSlot& Slot : Slots)
+		{
+			Slot.DescriptorSet = pMainDevice->DescriptorAllocator->Allocate(DescriptorSetLayout);
+			if (Slot.DescriptorSet == VK_NULL_HANDLE || !createSlotBuffer(Slot))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void cObjectTable::cleanUp()
+	{
+		for (FSlot& Slot : Slots)
+		{
+			if (Slot.pMapped)
+			{
+				Slot.Buffer.Unmap();
+				Slot.pMapped = nullptr;
+			}
+			Slot.Buffer.cleanUp();
+			Slot.Capacity = 0;
+			Slot.DescriptorSet = VK_NULL_HANDLE;
+		}
+		vkDestroyDescriptorSetLayout(pMainDevice->LD, DescriptorSetLayout, nullptr);
+		DescriptorSetLayout = VK_NULL_HANDLE;
+		Objects.clear();
+		DirtyMask.clear();
+		Count = 0;
+		Capacity = 0;
+	}
+
+	void cObjectTable::Resize(uint32_t iCount)
+	{
+		if (iCount > Capacity)
+		{
+			// Double the capacity so a growing scene reallocates the GPU buffers only a few times
+			while (Capacity < iCount)
+			{
+				Capacity *= 2;
+			}
+			Objects.resize(Capacity, BufferFormats::FObjectData());
+			DirtyMask.resize(Capacity, 0);
+		}
+		// New objects have to reach every slot
+		for (uint32_t i = Count; i < iCount; ++i)
+		{
+			Objects[i] = BufferFormats::FObjectData();
+			DirtyMask[i] = ALL_SLOTS_DIRTY;
+		}
+		Count = iCount;
+	}
+
+	void cObjectTable::Set(uint32_t Index, const glm::mat4& Model, uint32_t MaterialID)
+	{
+		assert(Index < Count);
+		const BufferFormats::FObjectData NewData(Model, MaterialID);
+		if (memcmp(&Objects[Index], &NewData, sizeof(NewData)) == 0)
+		{
+			return;
+		}
+		Objects[Index] = NewData;
+		DirtyMask[Index] = ALL_SLOTS_DIRTY;
+	}
+
+	bool cObjectTable::Upload(uint32_t FrameIndex)
+	{
+		assert(FrameIndex < MAX_FRAME_DRAWS);
+		FSlot& Slot = Slots[FrameIndex];
+		const uint8_t SlotBit = static_cast<uint8_t>(1u << FrameIndex);
+		UploadedCount = 0;
+
+		// 1. Table has outgrown this slot's buffer, the GPU is done with the old one so replace it and write everything
+		if (Slot.Capacity < Capacity)
+		{
+			Slot.Buffer.Unmap();
+			Slot.pMapped = nullptr;
+			Slot.Buffer.cleanUp();
+			if (!createSlotBuffer(Slot))
+			{
+				return false;
+			}
+			memcpy(Slot.pMapped, Objects.data(), sizeof(BufferFormats::FObjectData) * Count);
+			Slot.Buffer.Flush(0, sizeof(BufferFormats::FObjectData) * Count);
+			for (uint32_t i = 0; i < Count; ++i)
+			{
+				DirtyMask[i] &= ~SlotBit;
+			}
+			UploadedCount = Count;
+			return true;
+		}
+
+		// 2. Only the objects this slot has not seen yet
+		uint32_t DirtyBegin = Count;
+		uint32_t DirtyEnd = 0;
+		BufferFormats::FObjectData* pDst = static_cast<BufferFormats::FObjectData*>(Slot.pMapped);
+		for (uint32_t i = 0; i < Count; ++i)
+		{
+			if (DirtyMask[i] & SlotBit)
+			{
+				pDst[i] = Objects[i];
+				DirtyMask[i] &= ~SlotBit;
+				DirtyBegin = i < DirtyBegin ? i : DirtyBegin;
+				DirtyEnd = i + 1;
+				++UploadedCount;
+			}
+		}
+		if (DirtyEnd > DirtyBegin)
+		{
+			Slot.Buffer.Flush(sizeof(BufferFormats::FObjectData) * DirtyBegin, sizeof(BufferFormats::FObjectData) * (DirtyEnd - DirtyBegin));
+		}
+		return false;
+	}
+
+	bool cObjectTable::createSlotBuffer(FSlot& Slot)
+	{
+		// Host visible so the CPU writes straight into it, flushed explicitly in case the memory is not coherent
+		const VkDeviceSize BufferSize = sizeof(BufferFormats::FObjectData) * Capacity;
+		if (!Slot.Buffer.CreateBufferAndAllocateMemory(pMainDevice, BufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, EMemoryCategory::Uniform))
+		{
+			return false;
+		}
+		Slot.pMapped = Slot.Buffer.Map();
+		Slot.Capacity = Capacity;
+
+		// Point the slot's descriptor set to the new buffer
+		VkDescriptorBufferInfo BufferInfo = {};
+		BufferInfo.buffer = Slot.Buffer.GetvkBuffer();
+		BufferInfo.offset = 0;
+		BufferInfo.range = BufferSize;
+
+		VkWriteDescriptorSet SetWrite = {};
+		SetWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		SetWrite.dstSet = Slot.DescriptorSet;
+		SetWrite.dstBinding = 0;
+		SetWrite.dstArrayElement = 0;
+		SetWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		SetWrite.descriptorCount = 1;
+		SetWrite.pBufferInfo = &BufferInfo;
+		vkUpdateDescriptorSets(pMainDevice->LD, 1, &SetWrite, 0, nullptr);
+		return true;
+	}
+}
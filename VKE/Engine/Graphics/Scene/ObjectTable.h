@@ -0,0 +1,70 @@
+/*
+	ObjectTable holds per-object GPU data (model matrix as 3x4 rows, material index) in a storage buffer
+	Shaders read it with the object index, a per-instance vertex attribute for models and a push constant for emitters
+	The CPU table is the master copy, every frame slot owns a persistently mapped storage buffer of it,
+	a slot only receives the objects that changed since it was last uploaded
+	The table grows on demand, a slot's buffer (and its descriptor set) is replaced on that slot's next upload
+*/
+#pragma once
+#define GLFW_INCLUDE_VULKAN
+#include "GLFW/glfw3.h"
+
+#include "Utilities.h"
+#include "BufferFormats.h"
+#include "Buffer/Buffer.h"
+
+#include <vector>
+namespace VKE
+{
+	class cObjectTable
+	{
+	public:
+		/* Constructors and destructor*/
+		cObjectTable() {}
+		~cObjectTable() {}
+		cObjectTable(const cObjectTable& i_other) = delete;
+		cObjectTable& operator = (const cObjectTable& i_other) = delete;
+
+		bool init(FMainDevice* iMainDevice, uint32_t iInitialCapacity = OBJECT_TABLE_INITIAL_CAPACITY);
+		void cleanUp();
+
+		// Set the number of objects, new objects start as identity
+		void Resize(uint32_t iCount);
+		uint32_t GetCount() const { return Count; }
+		uint32_t GetCapacity() const { return Capacity; }
+
+		// Update one object, unchanged data is not uploaded again
+		// Different indices can be set from different threads, Resize must not run meanwhile
+		void Set(uint32_t Index, const glm::mat4& Model, uint32_t MaterialID);
+
+		// Copy the objects that changed to the frame slot's buffer, the GPU must be done with this slot
+		// Returns true when the slot's buffer has been replaced, command buffers that bound the old descriptor set are invalid then
+		bool Upload(uint32_t FrameIndex);
+		// Objects written by the last Upload
+		uint32_t GetUploadedCount() const { return UploadedCount; }
+
+		VkDescriptorSetLayout GetDescriptorSetLayout() const { return DescriptorSetLayout; }
+		const VkDescriptorSet& GetDescriptorSet(uint32_t FrameIndex) const { return Slots[FrameIndex].DescriptorSet; }
+	private:
+		struct FSlot
+		{
+			cBuffer Buffer;
+			void* pMapped = nullptr;
+			uint32_t Capacity = 0;
+			VkDescriptorSet DescriptorSet = VK_NULL_HANDLE;
+		};
+
+		bool createSlotBuffer(FSlot& Slot);
+
+		FMainDevice* pMainDevice = nullptr;
+		std::vector<BufferFormats::FObjectData> Objects;
+		// One bit per frame slot that has not received the latest data of the object
+		std::vector<uint8_t> DirtyMask;
+		uint32_t Count = 0;
+		uint32_t Capacity = 0;
+		uint32_t UploadedCount = 0;
+
+		FSlot Slots[MAX_FRAME_DRAWS];
+		VkDescriptorSetLayout DescriptorSetLayout = VK_NULL_HANDLE;
+	};
+}
@@ -0,0 +1,71 @@
+#include "SamplerCache.h"
+#include "Utilities.h"
+
+#include <tuple>
+
+namespace VKE
+{
+	bool FSamplerDesc::operator < (const FSamplerDesc& i_other) const
+	{
+		return std::tie(MagFilter, MinFilter, MipmapMode, AddressMode, MaxAnisotropy, MaxLod)
+			< std::tie(i_other.MagFilter, i_other.MinFilter, i_other.MipmapMode, i_other.AddressMode, i_other.MaxAnisotropy, i_other.MaxLod);
+	}
+
+	bool cSamplerCache::init(FMainDevice* iMainDevice)
+	{
+		pMainDevice = iMainDevice;
+		return true;
+	}
+
+	void cSamplerCache::cleanUp()
+	{
+		std::lock_guard<std::mutex> Lock(Mutex);
+		for (auto& Pair : Samplers)
+		{
+			vkDestroySampler(pMainDevice->LD, Pair.second, nullptr);
+		}
+		Samplers.clear();
+	}
+
+	VkSampler cSamplerCache::Get(const FSamplerDesc& iDesc)
+	{
+		std::lock_guard<std::mutex> Lock(Mutex);
+		auto It = Samplers.find(iDesc);
+		if (It != Samplers.end())
+		{
+			return It->second;
+		}
+
+		VkSamplerCreateInfo SamplerCreateInfo = {};
+		SamplerCreateInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+		SamplerCreateInfo.magFilter = iDesc.MagFilter;						// magnified filtering
+		SamplerCreateInfo.minFilter = iDesc.MinFilter;						// minified filtering
+		SamplerCreateInfo.addressModeU = iDesc.AddressMode;					// How to handle texture wrap in U (x) direction
+		SamplerCreateInfo.addressModeV = iDesc.AddressMode;					// How to handle texture wrap in V (y) direction
+		SamplerCreateInfo.addressModeW = iDesc.AddressMode;					// How to handle texture wrap in W (z) direction
+		SamplerCreateInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;	// Border is black
+		SamplerCreateInfo.unnormalizedCoordinates = VK_FALSE;				// Normalized coordinate, the value of the coordinate is (0, 1), if true, (0, image size)
+		SamplerCreateInfo.mipmapMode = iDesc.MipmapMode;					// Mipmap filtering
+		SamplerCreateInfo.mipLodBias = 0.0f;								// LOD Bias for mipmap
+		SamplerCreateInfo.minLod = 0.0f;									// Min / Max LOD to pick mip-level
+		SamplerCreateInfo.maxLod = iDesc.MaxLod;
+		SamplerCreateInfo.anisotropyEnable = iDesc.MaxAnisotropy > 1.0f ? VK_TRUE : VK_FALSE;	// Anisotropy filtering enable, anti-aliasing technique
+		SamplerCreateInfo.maxAnisotropy = iDesc.MaxAnisotropy;				// Anisotropy sample level
+
+		VkSampler Sampler = VK_NULL_HANDLE;
+		VkResult Result = vkCreateSampler(pMainDevice->LD, &SamplerCreateInfo, nullptr, &Sampler);
+		RESULT_CHECK(Result, "Fail to create sampler.");
+		if (Result != VK_SUCCESS)
+		{
+			return VK_NULL_HANDLE;
+		}
+		Samplers.insert({ iDesc, Sampler });
+		return Sampler;
+	}
+
+	uint32_t cSamplerCache::GetCount() const
+	{
+		std::lock_guard<std::mutex> Lock(Mutex);
+		return static_cast<uint32_t>(Samplers.size());
+	}
+}
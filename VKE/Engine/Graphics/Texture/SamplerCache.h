@@ -0,0 +1,52 @@
+/*
+	SamplerCache creates one VkSampler per unique sampler state and hands the same one to every texture asking for that state
+	Samplers live until cleanUp, textures never destroy the sampler they were given
+*/
+#pragma once
+#define GLFW_INCLUDE_VULKAN
+#include "GLFW/glfw3.h"
+
+#include <map>
+#include <mutex>
+#include <stdint.h>
+namespace VKE
+{
+	struct FMainDevice;
+
+	// Sampler state that tells samplers apart, the defaults are what textures have always used
+	struct FSamplerDesc
+	{
+		VkFilter MagFilter = VK_FILTER_LINEAR;
+		VkFilter MinFilter = VK_FILTER_LINEAR;
+		VkSamplerMipmapMode MipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+		VkSamplerAddressMode AddressMode = VK_SAMPLER_ADDRESS_MODE_REPEAT;		// Same mode for U, V and W
+		float MaxAnisotropy = 16.0f;											// Anisotropy is disabled at 1 or below
+		float MaxLod = 0.0f;
+
+		bool operator < (const FSamplerDesc& i_other) const;
+	};
+
+	class cSamplerCache
+	{
+	public:
+		/* Constructors and destructor*/
+		cSamplerCache() {}
+		~cSamplerCache() {}
+		cSamplerCache(const cSamplerCache& i_other) = delete;
+		cSamplerCache& operator = (const cSamplerCache& i_other) = delete;
+
+		bool init(FMainDevice* iMainDevice);
+		// Destroys every sampler, nothing may use them anymore
+		void cleanUp();
+
+		// Sampler of this state, created the first time it is asked for, VK_NULL_HANDLE when creation fails
+		VkSampler Get(const FSamplerDesc& iDesc);
+
+		uint32_t GetCount() const;
+	private:
+		FMainDevice* pMainDevice = nullptr;
+		std::map<FSamplerDesc, VkSampler> Samplers;
+		// Textures can be created from several threads
+		mutable std::mutex Mutex;
+	};
+}
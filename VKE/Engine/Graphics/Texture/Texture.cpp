@@ -1,5 +1,8 @@
 #include "Texture.h"
 #include "Buffer/Buffer.h"
+#include "Command/UploadContext.h"
+#include "TextureTable.h"
+#include "SamplerCache.h"
 
 #include <map>
 
@@ -9,12 +12,17 @@ namespace VKE
 	uint32_t cTexture::s_CreatedResourcesCount = 0;
 	std::vector<std::shared_ptr<VKE::cTexture>> s_TextureList;
 
-	std::shared_ptr<cTexture> cTexture::Load(const std::string& iTextureName, FMainDevice& iMainDevice, VkFormat Format)
+	std::shared_ptr<cTexture> cTexture::Load(const std::string& iTextureName, FMainDevice& iMainDevice, VkFormat Format, FileIO::FTextureData* ioDecoded)
 	{
 		// Not exist
 		if (s_TextureContainer.find(iTextureName) == s_TextureContainer.end())
 		{
-			auto newTexture = std::make_shared<cTexture>(iTextureName, iMainDevice, Format);
+			auto newTexture = std::make_shared<cTexture>(iTextureName, iMainDevice, Format, ioDecoded);
+			// Shaders sample it by ID from now on
+			if (newTexture->GetID() >= 0 && iMainDevice.TextureTable)
+			{
+				iMainDevice.TextureTable->Register(*newTexture);
+			}
 
 			s_TextureContainer.insert({ iTextureName, newTexture });
 			s_TextureList.push_back(newTexture);
@@ -22,10 +30,21 @@ namespace VKE
 		}
 		else
 		{
+			// Decoded data is not needed
+			if (ioDecoded && ioDecoded->Data)
+			{
+				FileIO::freeLoadedTextureData(ioDecoded->Data);
+				ioDecoded->Data = nullptr;
+			}
 			return s_TextureContainer.at(iTextureName);
 		}
 	}
 
+	bool cTexture::IsLoaded(const std::string& iTextureName)
+	{
+		return s_TextureContainer.find(iTextureName) != s_TextureContainer.end();
+	}
+
 	std::shared_ptr<cTexture> cTexture::Get(int ID)
 	{
 		if (s_TextureList.size() <= 0)
@@ -55,11 +74,11 @@ namespace VKE
 		s_TextureList.clear();
 	}
 
-	cTexture::cTexture(const std::string& iTextureName, FMainDevice& iMainDevice, VkFormat Format)
+	cTexture::cTexture(const std::string& iTextureName, FMainDevice& iMainDevice, VkFormat Format, FileIO::FTextureData* ioDecoded)
 	{
 		pMainDevice = &iMainDevice;
 		// Create vkImage, vkMemory
-		createTextureImage(iTextureName, Format);
+		createTextureImage(iTextureName, Format, ioDecoded);
 		createTextureSampler();
 	}
 
@@ -79,8 +98,8 @@ namespace VKE
 
 	void cTexture::cleanUp()
 	{
-		vkDestroySampler(pMainDevice->LD, Sampler, nullptr);
-
+		// The sampler belongs to the sampler cache
+		Sampler = VK_NULL_HANDLE;
 		Buffer.cleanUp();
 	}
 
@@ -94,55 +113,48 @@ namespace VKE
 		return Info;
 	}
 
-	int cTexture::createTextureImage(const std::string& fileName, VkFormat Format)
+	int cTexture::createTextureImage(const std::string& fileName, VkFormat Format, FileIO::FTextureData* ioDecoded)
 	{
-		// Load image file
+		// Load image file, unless it has been decoded already
 		VkDeviceSize ImageSize;
 
-		unsigned char* ImageData = FileIO::LoadTextureFile(fileName, Width, Height, ImageSize);
+		unsigned char* ImageData = nullptr;
+		if (ioDecoded && ioDecoded->Data)
+		{
+			ImageData = ioDecoded->Data;
+			Width = ioDecoded->Width;
+			Height = ioDecoded->Height;
+			ImageSize = ioDecoded->Size;
+			ioDecoded->Data = nullptr;
+		}
+		else
+		{
+			ImageData = FileIO::LoadTextureFile(fileName, Width, Height, ImageSize);
+		}
 		if (!ImageData)
 		{
 			return -1;
 		}
 
-		// Create staging buffer to hold loaded data, ready to copy to device
-		cBuffer StagingBuffer;
-		if (!StagingBuffer.CreateBufferAndAllocateMemory(pMainDevice->PD, pMainDevice->LD, ImageSize,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-			VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-		)) return false;
-
-		// Map memory to the staging buffer
-		void * pData = nullptr;
-		vkMapMemory(pMainDevice->LD, StagingBuffer.GetMemory(), 0, ImageSize, 0, &pData);
-		memcpy(pData, ImageData, static_cast<size_t>(ImageSize));
-		vkUnmapMemory(pMainDevice->LD, StagingBuffer.GetMemory());
-
-		// Free allocated memory for loading textures
-		FileIO::freeLoadedTextureData(ImageData);
-
 		// 1. Create image to hold final texture
 		if (!Buffer.init(pMainDevice, Width, Height, Format, VK_IMAGE_TILING_OPTIMAL,
 			VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,								// Destination of transfer, and also a texture sampler
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VK_IMAGE_ASPECT_COLOR_BIT
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VK_IMAGE_ASPECT_COLOR_BIT, EMemoryCategory::Texture
 			))
 		{
+			FileIO::freeLoadedTextureData(ImageData);
 			return -1;
 		}
 
-		// 2. COPY DATA TO THE IMAGE
-		// Transition image to be DST for copy operation
-		TransitionImageLayout(pMainDevice->LD, pMainDevice->graphicQueue, pMainDevice->GraphicsCommandPool, Buffer.GetImage(), VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-
-		// Actual copy command
-		CopyImageBuffer(pMainDevice->LD, pMainDevice->graphicQueue, pMainDevice->GraphicsCommandPool, StagingBuffer.GetvkBuffer(), Buffer.GetImage(), Width, Height);
-
-		// Transition image to be shader readable for shader usage
-		TransitionImageLayout(pMainDevice->LD, pMainDevice->graphicQueue, pMainDevice->GraphicsCommandPool, Buffer.GetImage(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		// 2. Stage the pixels, the upload context's next batch transitions the image to transfer dst, copies and makes it shader readable
+		const bool bStaged = pMainDevice->UploadContext->UploadImage(Buffer.GetImage(), ImageData, ImageSize, Width, Height);
 
-		// 3. Clean up staging buffer parts
-		StagingBuffer.cleanUp();
+		// 3. Free allocated memory for loading textures, the pixels have been copied to staging memory
+		FileIO::freeLoadedTextureData(ImageData);
+		if (!bStaged)
+		{
+			return -1;
+		}
 
 		TextureID = s_CreatedResourcesCount++;
 		return TextureID;
@@ -150,24 +162,8 @@ namespace VKE
 
 	void cTexture::createTextureSampler()
 	{
-		VkSamplerCreateInfo SamplerCreateInfo = {};
-		SamplerCreateInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
-		SamplerCreateInfo.magFilter = VK_FILTER_LINEAR;						// magnified filtering
-		SamplerCreateInfo.minFilter = VK_FILTER_LINEAR;						// minified filtering
-		SamplerCreateInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;	// How to handle texture wrap in U (x) direction
-		SamplerCreateInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;	// How to handle texture wrap in V (y) direction
-		SamplerCreateInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;	// How to handle texture wrap in W (z) direction
-		SamplerCreateInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;	// Border is black
-		SamplerCreateInfo.unnormalizedCoordinates = VK_FALSE;				// Normalized coordinate, the value of the coordinate is (0, 1), if true, (0, image size)
-		SamplerCreateInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;		// Mipmap filtering
-		SamplerCreateInfo.mipLodBias = 0.0f;								// LOD Bias for mipmap
-		SamplerCreateInfo.minLod = 0.0f;									// Min / Max LOD to pick mip-level
-		SamplerCreateInfo.maxLod = 0.0f;
-		SamplerCreateInfo.anisotropyEnable = VK_TRUE;						// Anisotropy filtering enable, anti-aliasing technique
-		SamplerCreateInfo.maxAnisotropy = 16;								// Anisotropy sample level
-
-		VkResult Result = vkCreateSampler(pMainDevice->LD, &SamplerCreateInfo, nullptr, &Sampler);
-		RESULT_CHECK(Result, "Fail to create sampler.");
+		// Every texture uses the default sampler state so far, they all share one sampler
+		Sampler = pMainDevice->SamplerCache->Get(FSamplerDesc());
 	}
 
 }
\ No newline at end of file
@@ -17,14 +17,17 @@ namespace VKE
 	{
 	public:
 		// Load asset
-		static std::shared_ptr<cTexture> Load(const std::string& iTextureName, FMainDevice& iMainDevice, VkFormat Format = VK_FORMAT_R8G8B8A8_UNORM);
+		// ioDecoded: pixels already decoded from the file (e.g. on a job thread), the texture takes them over and frees them
+		static std::shared_ptr<cTexture> Load(const std::string& iTextureName, FMainDevice& iMainDevice, VkFormat Format = VK_FORMAT_R8G8B8A8_UNORM, FileIO::FTextureData* ioDecoded = nullptr);
+		// Whether a texture with this name exists already, safe to call from several threads as long as no texture is being loaded
+		static bool IsLoaded(const std::string& iTextureName);
 		static std::shared_ptr<cTexture> Get(int ID);
 		// Free all assets
 		static void Free();
 		static uint32_t s_CreatedResourcesCount;
 
 		cTexture();
-		cTexture(const std::string& iTextureName, FMainDevice& iMainDevice, VkFormat Format = VK_FORMAT_R8G8B8A8_UNORM);
+		cTexture(const std::string& iTextureName, FMainDevice& iMainDevice, VkFormat Format = VK_FORMAT_R8G8B8A8_UNORM, FileIO::FTextureData* ioDecoded = nullptr);
 		cTexture(const cTexture& i_other) = delete;
 		cTexture(cTexture&& i_other) = delete;
 		cTexture& operator = (const cTexture& i_other) = delete;
@@ -43,12 +46,12 @@ namespace VKE
 		int Width, Height;
 
 		cImageBuffer Buffer;
-		VkSampler Sampler;
+		VkSampler Sampler = VK_NULL_HANDLE;		// Owned by the sampler cache
 
-		int createTextureImage(const std::string& fileName, VkFormat Format);
+		int createTextureImage(const std::string& fileName, VkFormat Format, FileIO::FTextureData* ioDecoded);
 		void createTextureSampler();
 
-		int TextureID;		// Ordered by the time created
+		int TextureID = -1;		// Ordered by the time created, slot in the texture table, -1 when loading failed
 	};
 
 }
\ No newline at end of file
@@ -0,0 +1,101 @@
+#include "TextureTable.h"
+#include "Texture.h"
+
+namespace VKE
+{
+	bool cTextureTable::init(FMainDevice* iMainDevice, uint32_t iCapacity)
+	{
+		pMainDevice = iMainDevice;
+		Capacity = iCapacity;
+		RegisteredCount = 0;
+
+		// 1. Descriptor set layout, one sampler array read by fragment shaders
+		VkDescriptorSetLayoutBinding Binding = {};
+		Binding.binding = 0;
+		Binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		Binding.descriptorCount = Capacity;
+		Binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+		// Slots without a texture are never sampled, slots are written while the set is bound
+		const VkDescriptorBindingFlags BindingFlags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT;
+		VkDescriptorSetLayoutBindingFlagsCreateInfo BindingFlagsCreateInfo = {};
+		BindingFlagsCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+		BindingFlagsCreateInfo.bindingCount = 1;
+		BindingFlagsCreateInfo.pBindingFlags = &BindingFlags;
+
+		VkDescriptorSetLayoutCreateInfo LayoutCreateInfo = {};
+		LayoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		LayoutCreateInfo.pNext = &BindingFlagsCreateInfo;
+		LayoutCreateInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+		LayoutCreateInfo.bindingCount = 1;
+		LayoutCreateInfo.pBindings = &Binding;
+		VkResult Result = vkCreateDescriptorSetLayout(pMainDevice->LD, &LayoutCreateInfo, nullptr, &DescriptorSetLayout);
+		RESULT_CHECK(Result, "Fail to create texture table descriptor set layout.");
+
+		// 2. Pool of the only set
+		VkDescriptorPoolSize PoolSize = {};
+		PoolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		PoolSize.descriptorCount = Capacity;
+
+		VkDescriptorPoolCreateInfo PoolCreateInfo = {};
+		PoolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		PoolCreateInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+		PoolCreateInfo.maxSets = 1;
+		PoolCreateInfo.poolSizeCount = 1;
+		PoolCreateInfo.pPoolSizes = &PoolSize;
+		Result = vkCreateDescriptorPool(pMainDevice->LD, &PoolCreateInfo, nullptr, &DescriptorPool);
+		RESULT_CHECK(Result, "Fail to create texture table descriptor pool.");
+
+		// 3. The set, nothing is written until textures register
+		VkDescriptorSetAllocateInfo SetAllocInfo = {};
+		SetAllocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		SetAllocInfo.descriptorPool = DescriptorPool;
+		SetAllocInfo.descriptorSetCount = 1;
+		SetAllocInfo.pSetLayouts = &DescriptorSetLayout;
+		Result = vkAllocateDescriptorSets(pMainDevice->LD, &SetAllocInfo, &DescriptorSet);
+		RESULT_CHECK(Result, "Fail to allocate texture table descriptor set.");
+
+		return Result == VK_SUCCESS;
+	}
+
+	void cTextureTable::cleanUp()
+	{
+		if (!pMainDevice)
+		{
+			return;
+		}
+		// The set goes with its pool
+		vkDestroyDescriptorPool(pMainDevice->LD, DescriptorPool, nullptr);
+		vkDestroyDescriptorSetLayout(pMainDevice->LD, DescriptorSetLayout, nullptr);
+		DescriptorPool = VK_NULL_HANDLE;
+		DescriptorSetLayout = VK_NULL_HANDLE;
+		DescriptorSet = VK_NULL_HANDLE;
+		RegisteredCount = 0;
+		pMainDevice = nullptr;
+	}
+
+	bool cTextureTable::Register(const cTexture& iTexture)
+	{
+		const int ID = iTexture.GetID();
+		if (ID < 0 || static_cast<uint32_t>(ID) >= Capacity)
+		{
+			printf("ERROR: Texture ID %d does not fit into the texture table (%d slots)\n", ID, Capacity);
+			return false;
+		}
+
+		const VkDescriptorImageInfo ImageInfo = iTexture.GetImageInfo();
+		VkWriteDescriptorSet SetWrite = {};
+		SetWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		SetWrite.dstSet = DescriptorSet;
+		SetWrite.dstBinding = 0;
+		SetWrite.dstArrayElement = static_cast<uint32_t>(ID);		// Slot of the texture
+		SetWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		SetWrite.descriptorCount = 1;
+		SetWrite.pImageInfo = &ImageInfo;
+
+		std::lock_guard<std::mutex> Lock(Mutex);
+		vkUpdateDescriptorSets(pMainDevice->LD, 1, &SetWrite, 0, nullptr);
+		++RegisteredCount;
+		return true;
+	}
+}
@@ -0,0 +1,49 @@
+/*
+	TextureTable is one descriptor set holding every loaded texture in a combined image sampler array, indexed by texture ID
+	Shaders sample Textures[TextureID], so it is bound once per command buffer instead of one sampler set per mesh / emitter
+	The binding is partially bound and update after bind (Vulkan 1.2 descriptor indexing):
+	only slots that have been registered may be sampled, and registering a new texture does not invalidate
+	recorded command buffers, in flight frames never read the slot that is being written
+	The set is not reset with the frame, its pool needs UPDATE_AFTER_BIND so it cannot come from the descriptor allocator
+*/
+#pragma once
+#define GLFW_INCLUDE_VULKAN
+#include "GLFW/glfw3.h"
+
+#include "Utilities.h"
+
+#include <mutex>
+namespace VKE
+{
+	class cTexture;
+	class cTextureTable
+	{
+	public:
+		/* Constructors and destructor*/
+		cTextureTable() {}
+		~cTextureTable() {}
+		cTextureTable(const cTextureTable& i_other) = delete;
+		cTextureTable& operator = (const cTextureTable& i_other) = delete;
+
+		bool init(FMainDevice* iMainDevice, uint32_t iCapacity = MAX_BINDLESS_TEXTURES);
+		void cleanUp();
+
+		// Write the texture to the slot of its ID, textures can be registered from several threads
+		bool Register(const cTexture& iTexture);
+
+		uint32_t GetCapacity() const { return Capacity; }
+		uint32_t GetRegisteredCount() const { return RegisteredCount; }
+		VkDescriptorSetLayout GetDescriptorSetLayout() const { return DescriptorSetLayout; }
+		const VkDescriptorSet& GetDescriptorSet() const { return DescriptorSet; }
+	private:
+		FMainDevice* pMainDevice = nullptr;
+		uint32_t Capacity = 0;
+		uint32_t RegisteredCount = 0;
+
+		VkDescriptorSetLayout DescriptorSetLayout = VK_NULL_HANDLE;
+		VkDescriptorPool DescriptorPool = VK_NULL_HANDLE;
+		VkDescriptorSet DescriptorSet = VK_NULL_HANDLE;
+		// Descriptor updates of the same set need external synchronization
+		std::mutex Mutex;
+	};
+}
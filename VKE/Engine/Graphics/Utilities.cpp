@@ -37,7 +37,7 @@ namespace VKE
 	{
 		for (const auto& mode : PresentationModes)
 		{
-			if (mode == VK_PRESENT_MODE_MAILBOX_KHR)
+			if (mode == PreferredPresentMode)
 			{
 				return mode;
 			}
@@ -108,7 +108,7 @@ namespace VKE
 		Valid = true;
 		return true;
 	}
-	bool CreateBufferAndAllocateMemory(FMainDevice MainDevice, VkDeviceSize BufferSize, VkBufferUsageFlags Flags, VkMemoryPropertyFlags Properties, VkBuffer& oBuffer, VkDeviceMemory& oBufferMemory)
+	bool CreateBufferAndAllocateMemory(FMainDevice MainDevice, VkDeviceSize BufferSize, VkBufferUsageFlags Flags, VkMemoryPropertyFlags Properties, EMemoryCategory Category, VkBuffer& oBuffer, FMemoryAllocation& oBufferMemory)
 	{
 		// info to create vertex buffer, not assigning memory
 		VkBufferCreateInfo BufferCreateInfo = {};
@@ -124,31 +124,14 @@ namespace VKE
 			return false;
 		}
 
-		// Get buffer memory requirements
-		VkMemoryRequirements MemRequirements;
-		vkGetBufferMemoryRequirements(MainDevice.LD, oBuffer, &MemRequirements);
-
-		// Allocate memory to buffer
-		VkMemoryAllocateInfo MemAllocInfo = {};
-		MemAllocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		MemAllocInfo.allocationSize = MemRequirements.size;
-		MemAllocInfo.memoryTypeIndex = FindMemoryTypeIndex(
-			MainDevice.PD,
-			MemRequirements.memoryTypeBits,				// Index of memory type on Physical Device that has required bit flags
-			Properties									// Memory property, is this local_bit or host_bit or others
-		);
-
-		// Allocate memory to VKDevieMemory
-		Result = vkAllocateMemory(MainDevice.LD, &MemAllocInfo, nullptr, &oBufferMemory);
-		RESULT_CHECK(Result, "Fail to allocate memory for buffer.");
-		if (Result != VK_SUCCESS)
+		// Sub-allocate memory and bind it with the buffer, need to free memory
+		if (!MainDevice.MemoryAllocator->AllocateForBuffer(oBuffer, Properties, EMemoryStrategy::Buddy, Category, oBufferMemory))
 		{
+			vkDestroyBuffer(MainDevice.LD, oBuffer, nullptr);
+			oBuffer = VK_NULL_HANDLE;
 			return false;
 		}
 
-		// Bind memory with given vertex buffer, need to free memory
-		vkBindBufferMemory(MainDevice.LD, oBuffer, oBufferMemory, 0);
-
 		return true;
 	}
 
@@ -229,47 +212,6 @@ namespace VKE
 		vkFreeCommandBuffers(LD, CommandPool, 1, &CommandBuffer);
 	}
 
-	void CopyBuffer(VkDevice LD, VkQueue TransferQueue, VkCommandPool TransferCommandPool, VkBuffer SrcBuffer, VkBuffer DstBuffer, VkDeviceSize BufferSize)
-	{
-		// Allocate the transfer command buffer
-		VkCommandBuffer TransferCommandBuffer = BeginCommandBuffer(LD, TransferCommandPool);
-
-		// Region of data to copy from and to, allows copy multiple regions of data
-		VkBufferCopy BufferCopyRegion = {};
-		BufferCopyRegion.srcOffset = 0;
-		BufferCopyRegion.dstOffset = 0;
-		BufferCopyRegion.size = BufferSize;
-
-		// Command to copy src buffer to dst buffer
-		vkCmdCopyBuffer(TransferCommandBuffer, SrcBuffer, DstBuffer, 1, &BufferCopyRegion);
-
-		// Stop the command and submit it to the queue, wait until it finish execution
-		EndCommandBuffer(TransferCommandBuffer, LD, TransferQueue, TransferCommandPool);
-	}
-
-	void CopyImageBuffer(VkDevice LD, VkQueue TransferQueue, VkCommandPool TransferCommandPool, VkBuffer SrcBuffer, VkImage DstImage, uint32_t Width, uint32_t Height)
-	{
-		VkCommandBuffer TransferCommandBuffer = BeginCommandBuffer(LD, TransferCommandPool);
-
-		// Region of data to copy from and to, allows copy multiple regions of data
-		VkBufferImageCopy ImageCopyRegion = {};
-		ImageCopyRegion.bufferOffset = 0;
-		ImageCopyRegion.bufferRowLength = 0;										// for calculating data spacing, like calculating i, j for loop
-		ImageCopyRegion.bufferImageHeight = 0;										// the same calculating data spacing, means don't want to skip any pixel while reading
-		ImageCopyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;	// Which aspect of image to copy
-		ImageCopyRegion.imageSubresource.mipLevel = 0;								// Mipmap level to copy
-		ImageCopyRegion.imageSubresource.baseArrayLayer = 0;						// Starting array layer
-		ImageCopyRegion.imageSubresource.layerCount = 1;							// Number of layers to copy starting at baseArrayLayer
-		ImageCopyRegion.imageOffset = { 0,0,0 };									// Offset into image (as opposed to raw data in buffer offset), start at the beginning
-		ImageCopyRegion.imageExtent = { Width, Height, 1 };							// Size of region to copy as (x,y,z) values
-
-
-		// Command to copy src buffer to dst buffer
-		vkCmdCopyBufferToImage(TransferCommandBuffer, SrcBuffer, DstImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &ImageCopyRegion);
-
-		EndCommandBuffer(TransferCommandBuffer, LD, TransferQueue, TransferCommandPool);
-	}
-
 	void SetMinUniformOffsetAlignment(VkDeviceSize Size)
 	{
 		MinUniformBufferOffset = Size;
@@ -307,7 +249,7 @@ namespace VKE
 		return ImageView;
 	}
 
-	bool CreateImage(FMainDevice* iMainDevice, uint32_t Width, uint32_t Height, VkFormat Format, VkImageTiling Tiling, VkImageUsageFlags UseFlags, VkMemoryPropertyFlags PropFlags, VkImage& oImage, VkDeviceMemory& oImageMemory)
+	bool CreateImage(FMainDevice* iMainDevice, uint32_t Width, uint32_t Height, VkFormat Format, VkImageTiling Tiling, VkImageUsageFlags UseFlags, VkMemoryPropertyFlags PropFlags, EMemoryCategory Category, VkImage& oImage, FMemoryAllocation& oImageMemory)
 	{
 		// CREATE IMAGE
 		VkImageCreateInfo ImgCreateInfo = {};
@@ -331,87 +273,17 @@ namespace VKE
 		{
 			return false;
 		}
-		// Get memory requirements for a type of image
-		VkMemoryRequirements MemoryRequireMents;
-		vkGetImageMemoryRequirements(iMainDevice->LD, oImage, &MemoryRequireMents);
-
 		// CREATE MEMORY FOR IMAGE
-		// Allocate memory to buffer
-		VkMemoryAllocateInfo MemAllocInfo = {};
-		MemAllocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		MemAllocInfo.allocationSize = MemoryRequireMents.size;
-		MemAllocInfo.memoryTypeIndex = FindMemoryTypeIndex(iMainDevice->PD,
-			MemoryRequireMents.memoryTypeBits,				// Index of memory type on Physical Device that has required bit flags
-			PropFlags										// Memory property, is this local_bit or host_bit or others
-		);
-
-		// Allocate memory to VKDevieMemory
-		Result = vkAllocateMemory(iMainDevice->LD, &MemAllocInfo, nullptr, &oImageMemory);
-		RESULT_CHECK(Result, "Fail to allocate memory for image.");
-		if (Result != VK_SUCCESS)
-		{
-			return false;
-		}
-
-		Result = vkBindImageMemory(iMainDevice->LD, oImage, oImageMemory, 0);
-		RESULT_CHECK(Result, "Fail to bind image with memory.");
-		if (Result != VK_SUCCESS)
+		// Sub-allocate memory and bind it with the image
+		if (!iMainDevice->MemoryAllocator->AllocateForImage(oImage, PropFlags, Category, oImageMemory))
 		{
+			vkDestroyImage(iMainDevice->LD, oImage, nullptr);
+			oImage = VK_NULL_HANDLE;
 			return false;
 		}
 		return true;
 	}
 
-	void TransitionImageLayout(VkDevice LD, VkQueue Queue, VkCommandPool CommandPool, VkImage Image, VkImageLayout CurrentLayout, VkImageLayout NewLayout)
-	{
-		VkCommandBuffer CommandBuffer = BeginCommandBuffer(LD, CommandPool);
-
-		// Pipeline barrier - Image memory barrier
-		VkImageMemoryBarrier ImageMemoryBarrier = {};
-		ImageMemoryBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-		ImageMemoryBarrier.oldLayout = CurrentLayout;
-		ImageMemoryBarrier.newLayout = NewLayout;
-		ImageMemoryBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;			// Don't bother transferring between queues
-		ImageMemoryBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-		ImageMemoryBarrier.image = Image;											// Image being accessed and modified as part of barrier
-		ImageMemoryBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;	// Aspect of image being altered
-		ImageMemoryBarrier.subresourceRange.baseMipLevel = 0;
-		ImageMemoryBarrier.subresourceRange.levelCount = 1;							// Number of mip-map levels to alter starting from base level
-		ImageMemoryBarrier.subresourceRange.baseArrayLayer = 0;						// Number of layers to alter starting from baseArrayLayer
-		ImageMemoryBarrier.subresourceRange.layerCount = 1;
-
-		VkPipelineStageFlags SrcStage = 0, DstStage = 0;
-
-
-		// If transitioning from new image ready to receive data...
-		if (CurrentLayout == VK_IMAGE_LAYOUT_UNDEFINED && NewLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL)
-		{
-			ImageMemoryBarrier.srcAccessMask = 0;									// Memory access stage transition must happen after: From the very start
-			ImageMemoryBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;		// Memory access stage transition must happen before: transfer write stage
-
-			SrcStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;							// On top of any stage
-			DstStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-		}
-		// If transitioning from transfer destination to shader readable...
-		else if (CurrentLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL && NewLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
-		{
-			ImageMemoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;		// Memory access stage transition must happen after: Finish doing the transfer (from host_visible to local_bit)
-			ImageMemoryBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;			// Memory access stage transition must happen before: the shader starts to read it
-
-			SrcStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-			DstStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;						// Should be ready before fragment shader reading the texture
-		}
-		vkCmdPipelineBarrier(CommandBuffer,
-			SrcStage, DstStage,		// Pipeline stages (match to src and dst access masks)
-			0, 						// Dependency flags
-			0, nullptr,				// Global Memory Barrier count + data
-			0, nullptr,				// Buffer Memory barrier count + data
-			1, &ImageMemoryBarrier	// Image Memory Barrier count + data
-		);
-
-		EndCommandBuffer(CommandBuffer, LD, Queue, CommandPool);
-	}
-
 	int RandRangeInt(int min, int max)
 	{
 		int result = static_cast<int>(RandRange(static_cast<float>(min), static_cast<float>(max) + 1.0f));
@@ -3,6 +3,7 @@
 #define GLFW_INCLUDE_VULKAN
 #include "GLFW/glfw3.h"
 #include "glm/glm.hpp"
+#include "Memory/MemoryAllocator.h"
 
 #ifdef _DEBUG
 #define RESULT_CHECK(Result, Message)					\
@@ -46,6 +47,12 @@
 	ClassName* Get##PropertyName() { return PropertyName; }
 namespace VKE
 {
+	class cUploadContext;
+	class cDescriptorAllocator;
+	class cTextureTable;
+	class cSamplerCache;
+	class cGeometryArena;
+
 	// ================================================
 	// =============== Global Variables =============== 
 	// ================================================
@@ -68,8 +75,23 @@ namespace VKE
 
 	// Maximum 3 image on the queue
 	const int MAX_FRAME_DRAWS = 3;
-	// Max objects are allowed in the scene
-	const int MAX_OBJECTS = 20;
+	// Objects the object table has room for before it first grows
+	const uint32_t OBJECT_TABLE_INITIAL_CAPACITY = 1024;
+	// Instances every frame slot's instance buffer has room for before it first grows
+	const uint32_t INSTANCE_BUFFER_INITIAL_CAPACITY = 1024;
+	// Vertices / indices of one geometry arena block, bigger meshes get a block of their own
+	const uint32_t GEOMETRY_BLOCK_VERTEX_COUNT = 1u << 20;
+	const uint32_t GEOMETRY_BLOCK_INDEX_COUNT = 3u << 20;
+	// Model vertex shader reads vertices from the geometry arena by gl_VertexIndex instead of through vertex input
+	const bool USE_VERTEX_PULLING = false;
+	// Most batches drawn by one vkCmdDrawIndexedIndirect, the device limit has to allow it
+	const uint32_t MAX_MULTI_DRAW_COUNT = 1024;
+	// Slots of the texture table, texture IDs have to be below it
+	const uint32_t MAX_BINDLESS_TEXTURES = 1024;
+	// A recording task gets at least this many draws, fewer are recorded by one thread
+	const size_t MIN_DRAWS_PER_RECORD_TASK = 64;
+	// A job updating objects (transforms, uniform data) handles at least this many of them
+	const size_t MIN_OBJECTS_PER_JOB = 256;
 	
 	extern uint64_t ElapsedFrame;
 	// =======================================
@@ -90,6 +112,7 @@ namespace VKE
 		int graphicFamily = -1;			// Location of Graphics Queue Family
 		int presentationFamily = -1;	// Location of Presentation Queue Family
 		int computeFamily = -1;			// Location of compute queue family
+		int transferFamily = -1;		// Location of a transfer only queue family, the graphic family when there is none
 		bool IsValid() const;
 	};
 
@@ -97,12 +120,39 @@ namespace VKE
 	{
 		VkPhysicalDevice PD;					// Physical Device
 		VkDevice LD;							// Logical Device
-		VkQueue graphicQueue;					// Graphic Queue,also transfer queue
+		VkQueue graphicQueue;					// Graphic Queue
 		VkQueue presentationQueue;				// Presentation Queue
+		VkQueue transferQueue;					// Transfer Queue of asset uploads, the graphic queue when there is no transfer only family
 		FQueueFamilyIndices QueueFamilyIndices;		// Queue families
-		VkCommandPool GraphicsCommandPool;		// Command Pool only used for graphic command
+		VkCommandPool UploadCommandPool;		// Command Pool on the graphic queue family for one-off commands (imgui fonts), assets go through UploadContext, per-frame recording uses cCommandAllocator
+		cMemoryAllocator* MemoryAllocator = nullptr;	// Device memory of every buffer and image comes from here
+		cUploadContext* UploadContext = nullptr;		// Staged, batched copies into device local buffers and images
+		cDescriptorAllocator* DescriptorAllocator = nullptr;	// Every engine descriptor set but the texture table comes from here
+		cTextureTable* TextureTable = nullptr;					// Loaded textures register their slot here
+		cSamplerCache* SamplerCache = nullptr;					// One sampler per unique sampler state, shared by textures
+		cGeometryArena* GeometryArena = nullptr;				// Vertices and indices of every mesh, sub-allocated from shared buffers
 
 		bool NeedSynchronization() const{ return QueueFamilyIndices.computeFamily != QueueFamilyIndices.graphicFamily; }
+		// Uploads run on a queue family of their own, exclusive resources change ownership to the graphic family after the copy
+		bool HasTransferQueue() const { return QueueFamilyIndices.transferFamily != QueueFamilyIndices.graphicFamily; }
+		// Queue families a resource used by both graphic and compute queues should be shared with, empty when they are the same family
+		std::vector<uint32_t> GraphicComputeSharingFamilies() const
+		{
+			if (!NeedSynchronization())
+			{
+				return {};
+			}
+			return { static_cast<uint32_t>(QueueFamilyIndices.graphicFamily), static_cast<uint32_t>(QueueFamilyIndices.computeFamily) };
+		}
+		// Queue families a resource uploaded in place while the graphic queue uses it should be shared with, empty when they are the same family
+		std::vector<uint32_t> GraphicTransferSharingFamilies() const
+		{
+			if (!HasTransferQueue())
+			{
+				return {};
+			}
+			return { static_cast<uint32_t>(QueueFamilyIndices.graphicFamily), static_cast<uint32_t>(QueueFamilyIndices.transferFamily) };
+		}
 	};
 
 	struct FSwapChainDetail
@@ -110,7 +160,7 @@ namespace VKE
 		VkSurfaceCapabilitiesKHR SurfaceCapabilities;			// Surface properties, e.g. image size / extents
 		std::vector< VkSurfaceFormatKHR> ImgFormats;			// Image formats, e.g. rgb, rgba, r16g16b16a16
 		std::vector<VkPresentModeKHR> PresentationModes;		// How image should be presented to screen
-
+		VkPresentModeKHR PreferredPresentMode = VK_PRESENT_MODE_MAILBOX_KHR;	// Used when supported, otherwise falls back to FIFO
 
 		bool IsValid() const { return ImgFormats.size() > 0 && PresentationModes.size() > 0; }
 		VkSurfaceFormatKHR getSurfaceFormat() const;
@@ -163,36 +213,35 @@ namespace VKE
 	// ================================================
 
 	// Create buffer and allocate memory for any specific usage type of buffer
-	bool CreateBufferAndAllocateMemory(FMainDevice MainDevice, VkDeviceSize BufferSize, VkBufferUsageFlags Flags, VkMemoryPropertyFlags Properties, VkBuffer& oBuffer, VkDeviceMemory& oBufferMemory);
+	bool CreateBufferAndAllocateMemory(FMainDevice MainDevice, VkDeviceSize BufferSize, VkBufferUsageFlags Flags, VkMemoryPropertyFlags Properties, EMemoryCategory Category, VkBuffer& oBuffer, FMemoryAllocation& oBufferMemory);
 	// Find a valid memory type index
 	uint32_t FindMemoryTypeIndex(VkPhysicalDevice PD, uint32_t AllowedTypes, VkMemoryPropertyFlags Properties);
 	
 	VkCommandBuffer BeginCommandBuffer(VkDevice LD, VkCommandPool CommandPool);
 	void EndCommandBuffer(VkCommandBuffer CommandBuffer, VkDevice LD, VkQueue Queue, VkCommandPool CommandPool);
 
-	// Copy data from src buffer to dst buffer
-	void CopyBuffer(VkDevice LD, VkQueue TransferQueue, VkCommandPool TransferCommandPool,
-		VkBuffer SrcBuffer, VkBuffer DstBuffer, VkDeviceSize BufferSize);
-
-	// Copy Image buffer
-	void CopyImageBuffer(VkDevice LD, VkQueue TransferQueue, VkCommandPool TransferCommandPool,
-		VkBuffer SrcBuffer, VkImage DstImage, uint32_t Width, uint32_t Height);
-
 	// Getter and setter for MinUniformOffsetAlignment
 	void SetMinUniformOffsetAlignment(VkDeviceSize Size);
 	VkDeviceSize GetMinUniformOffsetAlignment();
 
 	// Image creation related
 	VkImageView CreateImageViewFromImage(FMainDevice* iMainDevice, const VkImage& iImage, const VkFormat& iFormat, const VkImageAspectFlags& iAspectFlags);
-	bool CreateImage(FMainDevice* iMainDevice, uint32_t Width, uint32_t Height, VkFormat Format, VkImageTiling Tiling, VkImageUsageFlags UseFlags, VkMemoryPropertyFlags PropFlags, VkImage& oImage, VkDeviceMemory& oImageMemory);
-
-	void TransitionImageLayout(VkDevice LD, VkQueue Queue, VkCommandPool CommandPool, VkImage Image, VkImageLayout CurrentLayout, VkImageLayout NewLayout);
+	bool CreateImage(FMainDevice* iMainDevice, uint32_t Width, uint32_t Height, VkFormat Format, VkImageTiling Tiling, VkImageUsageFlags UseFlags, VkMemoryPropertyFlags PropFlags, EMemoryCategory Category, VkImage& oImage, FMemoryAllocation& oImageMemory);
 
 	namespace FileIO
 	{
 		std::vector<char> ReadFile(const std::string& filename);
 		std::string RelativePathToAbsolutePath(const std::string& iReleative);
 
+		// Decoded RGBA8 pixels of a texture file, Data is freed with freeLoadedTextureData
+		struct FTextureData
+		{
+			unsigned char* Data = nullptr;
+			int Width = 0;
+			int Height = 0;
+			VkDeviceSize Size = 0;
+		};
+
 		unsigned char* LoadTextureFile(const std::string& fileName, int& oWidth, int& oHeight, VkDeviceSize& oImageSize);
 		void freeLoadedTextureData(unsigned char* Data);
 	}
@@ -5,16 +5,19 @@
 #include "Camera.h"
 #include "Mesh/Mesh.h"
 #include "Texture/Texture.h"
+#include "Material/Material.h"
 #include "Transform/Transform.h"
 #include "Model/Model.h"
 #include "Descriptors/Descriptor_Buffer.h"
-#include "Descriptors/Descriptor_Dynamic.h"
 #include "Descriptors/Descriptor_Image.h"
 #include "Editor/Editor.h"
+#include "Time.h"
+#include "Job/JobSystem.h"
 // system
 #include <stdexcept>
 #include "stdlib.h"
 #include <set>
+#include <algorithm>
 #include "assert.h"
 
 // glm
@@ -38,10 +41,15 @@ namespace VKE
 	int VKRenderer::init(GLFWwindow* iWindow)
 	{
 		window = iWindow;
+		// No window, render into offscreen targets instead of a swap chain
+		bHeadless = (window == nullptr);
 		try
 		{
 			createInstance();
-			createSurface();
+			if (!bHeadless)
+			{
+				createSurface();
+			}
 			getPhysicalDevice();
 			createLogicalDevice();
 			createSwapChain();
@@ -56,6 +64,7 @@ namespace VKE
 			{		
 				// Create Texture
 				cTexture::Load("DefaultWhite.png", MainDevice);	// ID = 0, default white texture
+				cMaterial::Init();									// ID = 0, default white material
 				cTexture::Load("fireParticles/TXT_Sparks_01.tga", MainDevice);
 				cTexture::Load("fireParticles/TXT_Fire_01.tga", MainDevice);
 				CreateDescriptorSets();
@@ -68,6 +77,9 @@ namespace VKE
 			{
 				pCompute->init(&MainDevice);
 			}
+			// Everything loaded above goes to the GPU in one batch, startup waits for it so the first frame has all of it
+			ReadyUploadToken = UploadContext.Submit();
+			UploadContext.Wait(ReadyUploadToken);
 			createGraphicsPipeline();
 
 		}
@@ -81,11 +93,39 @@ namespace VKE
 		return EXIT_SUCCESS;
 	}
 
-	void VKRenderer::tick(float dt)
+	void VKRenderer::SetPreferredPresentMode(EPresentMode iMode)
+	{
+		switch (iMode)
+		{
+		case EPresentMode::Mailbox:		SwapChainDetail.PreferredPresentMode = VK_PRESENT_MODE_MAILBOX_KHR; break;
+		case EPresentMode::Fifo:		SwapChainDetail.PreferredPresentMode = VK_PRESENT_MODE_FIFO_KHR; break;
+		case EPresentMode::FifoRelaxed:	SwapChainDetail.PreferredPresentMode = VK_PRESENT_MODE_FIFO_RELAXED_KHR; break;
+		case EPresentMode::Immediate:	SwapChainDetail.PreferredPresentMode = VK_PRESENT_MODE_IMMEDIATE_KHR; break;
+		default: break;
+		}
+	}
+
+	void VKRenderer::fixedTick(float FixedDT)
 	{
+		// Every simulated object blends from its state before this step, whoever moves it during the step
+		JobSystem::ParallelFor(RenderList.size(), MIN_OBJECTS_PER_JOB, [&](size_t Begin, size_t End)
+		{
+			for (size_t i = Begin; i < End; ++i)
+			{
+				RenderList[i]->Transform.SavePrevious();
+			}
+		});
+		if (pCompute)
+		{
+			for (size_t i = 0; i < pCompute->Emitters.size(); ++i)
+			{
+				pCompute->Emitters[i].Transform.SavePrevious();
+			}
+		}
+
 		if (RenderList.size() > 0 && RenderList[0])
 		{
-			RenderList[0]->Transform.gRotate(cTransform::WorldUp, dt);
+			RenderList[0]->Transform.gRotate(cTransform::WorldUp, FixedDT);
 			RenderList[0]->Transform.Update();
 		}
 
@@ -93,26 +133,65 @@ namespace VKE
 		{
 			for (size_t i = 0; i < pCompute->Emitters.size(); ++i)
 			{
-				pCompute->Emitters[i].ParticleSupportData.dt = dt;
-				pCompute->Emitters[i].ParticleSupportData.EmitTimer += dt;
+				pCompute->Emitters[i].ParticleSupportData.EmitTimer += FixedDT;
 			}
 			//pCompute->Emitter.Transform.gRotate(cTransform::WorldRight, dt);
 			//pCompute->Emitter.Transform.Update();
 		}
+		FrameSimulatedTime += FixedDT;
+	}
+
+	void VKRenderer::tick(float dt)
+	{
+		if (pCompute && pCompute->bNeedComputePass)
+		{
+			// Particles are dispatched once per rendered frame, integrate the time the fixed steps covered (0 when no step ran)
+			for (size_t i = 0; i < pCompute->Emitters.size(); ++i)
+			{
+				pCompute->Emitters[i].ParticleSupportData.dt = FrameSimulatedTime;
+			}
+		}
+		FrameSimulatedTime = 0.0f;
 	}
 
 
 	VkResult VKRenderer::prepareForDraw()
 	{
 		int CurrentFrame = ElapsedFrame % MAX_FRAME_DRAWS;
-		// Wait for given fence to be opened from last draw before continuing
-		vkWaitForFences(MainDevice.LD, 1, &DrawFences[CurrentFrame],
-			VK_TRUE,													// Must wait for all fences to be opened(signaled) to pass this wait
-			std::numeric_limits<uint64_t>::max());						// No time-out
-		vkResetFences(MainDevice.LD, 1, &DrawFences[CurrentFrame]);		// Need to close(reset) this fence manually
-
-		/** get the next available image to draw to and signal(semaphore1) when we're finished with the image */
-		return SwapChain.acquireNextImage(MainDevice, OnImageAvailables[CurrentFrame]);
+		// Only block on the work this frame slot submitted last time (graphics and compute timeline values), the other slots keep running on the GPU
+		const double WaitStart = Time::Now();
+		FrameScheduler.WaitFrameSlot(CurrentFrame);
+		FenceWaitTime = Time::Now() - WaitStart;
+		// Transient CPU data of the slot's previous frame is no longer referenced either
+		FrameArena.BeginFrame(CurrentFrame);
+
+		VkResult Result = VK_SUCCESS;
+		if (bHeadless)
+		{
+			// Offscreen targets are used in turn, nothing to acquire
+			SwapChain.ImageIndex = CurrentFrame % static_cast<uint32_t>(SwapChain.Images.size());
+		}
+		else
+		{
+			/** get the next available image to draw to and signal(semaphore1) when we're finished with the image */
+			Result = SwapChain.acquireNextImage(MainDevice, OnImageAvailables[CurrentFrame]);
+		}
+		if (Result != VK_SUCCESS && Result != VK_SUBOPTIMAL_KHR)
+		{
+			// Nothing will be submitted for this slot, its timeline values stay as they are
+			return Result;
+		}
+
+		// Swap chain image count can differ from MAX_FRAME_DRAWS, the acquired image may still be in use by an older frame slot
+		const double ImageWaitStart = Time::Now();
+		FrameScheduler.Wait(ETimeline::Graphics, ImageGraphicsValues[SwapChain.ImageIndex]);
+		FenceWaitTime += Time::Now() - ImageWaitStart;
+
+		// GPU is done with this frame slot, all of its command buffers can be recycled in one go
+		CommandAllocator.ResetFrame(CurrentFrame);
+		DescriptorAllocator.ResetFrame(CurrentFrame);
+		GpuCulling.ReadStats(CurrentFrame);
+		return Result;
 	}
 
 	VkResult VKRenderer::presentFrame()
@@ -126,21 +205,15 @@ namespace VKE
 		PresentInfo.pSwapchains = &SwapChain.SwapChain;					// Swap chains to present image to
 		PresentInfo.pImageIndices = &SwapChain.ImageIndex;				// Index of images in swap chains to present
 
+		// No queue wait idle here, the frame slot fence protects resources of this frame when the slot comes around again
 		VkResult Result = vkQueuePresentKHR(MainDevice.presentationQueue, &PresentInfo);
-		if (!((Result == VK_SUCCESS) || (Result == VK_SUBOPTIMAL_KHR))) {
-			if (Result == VK_ERROR_OUT_OF_DATE_KHR) {
-				// Swap chain is no longer compatible with the surface and needs to be recreated
-				recreateSwapChain();
-				return Result;
-			}
-			else {
-				RESULT_CHECK(Result, "failed to present swap chain image!");
-				return Result;
-			}
+		if (Result == VK_ERROR_OUT_OF_DATE_KHR || Result == VK_SUBOPTIMAL_KHR)
+		{
+			// Swap chain is no longer compatible with the surface and needs to be recreated
+			recreateSwapChain();
+			return Result;
 		}
-
-		Result = vkQueueWaitIdle(MainDevice.presentationQueue);
-		RESULT_CHECK(Result, "Fail to wait for queue");
+		RESULT_CHECK(Result, "failed to present swap chain image!");
 		return Result;
 	}
 
@@ -149,32 +222,29 @@ namespace VKE
 		int CurrentFrame = ElapsedFrame % MAX_FRAME_DRAWS;
 		if (pCompute && pCompute->bNeedComputePass)
 		{
-			// re-record commands
-			pCompute->recordComputeCommands();
-			// Wait for rendering finished
-			VkPipelineStageFlags ComputeWaitStageMask = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
-
-			// Submit compute commands
-			VkSubmitInfo ComputeSubmitInfo = {};
-			ComputeSubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-			ComputeSubmitInfo.commandBufferCount = 1;
-			ComputeSubmitInfo.pCommandBuffers = &pCompute->CommandBuffer;
-			ComputeSubmitInfo.waitSemaphoreCount = 1;
-			ComputeSubmitInfo.pWaitSemaphores = &OnGraphicFinished[CurrentFrame];
-			ComputeSubmitInfo.pWaitDstStageMask = &ComputeWaitStageMask;
-			ComputeSubmitInfo.signalSemaphoreCount = 1;
-			ComputeSubmitInfo.pSignalSemaphores = &pCompute->OnComputeFinished;
-			VkResult Result = vkQueueSubmit(pCompute->ComputeQueue, 1, &ComputeSubmitInfo, DrawFences[CurrentFrame]);
-			RESULT_CHECK(Result, "Fail to submit compute command buffers to compute queue");
+			// Pick the cached dispatches of this frame slot, re-recorded only when out of date; the slot's compute value has been waited in prepareForDraw
+			pCompute->recordComputeCommands(CurrentFrame);
+
+			// Submit compute commands, the compute shader only waits for the older frame that drew the buffer it is going to write,
+			// so it overlaps with this frame's graphics work, which draws the buffer being read
+			const uint32_t WriteBufferIndex = (pCompute->ReadBufferIndex + 1) % cEmitter::ParticleBufferCount;
+			FSubmitDesc ComputeSubmit(FrameArena);
+			ComputeSubmit.CommandBuffers.push_back(pCompute->CommandBuffers[CurrentFrame]);
+			ComputeSubmit.WaitTimeline(ETimeline::Graphics, pCompute->BufferGraphicsValues[WriteBufferIndex], VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+			// Initial particles of the emitters come from the upload context, the token has been reached already
+			ComputeSubmit.WaitExternalTimeline(UploadContext.GetSemaphore(), ReadyUploadToken, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+			FrameScheduler.Submit(ETimeline::Compute, pCompute->ComputeQueue, ComputeSubmit, CurrentFrame);
+			pCompute->swapParticleBuffers();
 		}
 	}
 
 	void VKRenderer::draw()
 	{
+		const double DrawStart = Time::Now();
 		int CurrentFrame = ElapsedFrame % MAX_FRAME_DRAWS;
 		VkResult PrepareResult = prepareForDraw();
 		// Swap chain is out of date
-		if ((PrepareResult == VK_ERROR_OUT_OF_DATE_KHR) || (PrepareResult == VK_SUBOPTIMAL_KHR))
+		if (PrepareResult == VK_ERROR_OUT_OF_DATE_KHR)
 		{
 			recreateSwapChain();
 			return;
@@ -182,46 +252,54 @@ namespace VKE
 		else if (PrepareResult != VK_SUCCESS && PrepareResult != VK_SUBOPTIMAL_KHR) {
 			throw std::runtime_error("failed to acquire swap chain image!");
 		}
+		// Buffers / images staged since the last frame (e.g. models created at runtime) go to the transfer queue as one batch,
+		// they upload while frames keep rendering and their models join the recording once done
+		UploadContext.Submit();
+		updateUploadedModels();
+		// Update uniform buffer, before recording since growing the object table rewrites descriptor sets the recording binds
+		updateUniformBuffers();
 		// Record graphic commands
 		recordCommands();
-		// Update uniform buffer
-		updateUniformBuffers();
-
-		const uint32_t GraphicWaitSemaphoreCount = 2;
-		VkSemaphore GraphicsWaitSemaphores[] = { pCompute->OnComputeFinished, OnImageAvailables[CurrentFrame] };
-		const uint32_t GraphicSignalSemaphoreCount = 2;
-		VkSemaphore GraphicsSignalSemaphores[] = { OnGraphicFinished[CurrentFrame], OnRenderFinisheds[CurrentFrame] };
 
 		/** II. submit command buffer to queue (graphic queue) for execution, make sure it waits for the image to be signaled as available before drawing,
 		 and signals (semaphore2) when it has finished rendering.*/
-		 // Queue Submission information
-		VkSubmitInfo SubmitInfo = {};
-		SubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-		SubmitInfo.waitSemaphoreCount = GraphicWaitSemaphoreCount;							// Number of semaphores to wait on
-		SubmitInfo.pWaitSemaphores = GraphicsWaitSemaphores;								// It can start the command buffers all the way before it can draw to the screen.
-		VkPipelineStageFlags WaitStages[] =
-		{
-			VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT		// Seen this in subpass dependency, command buffers will run until this stage
-		};
-		SubmitInfo.pWaitDstStageMask = WaitStages;											// Stages to check semaphores at
-		SubmitInfo.commandBufferCount = 1;													// Number of command buffers to submit, only submit to one frame once
-		SubmitInfo.pCommandBuffers = &CommandBuffers[SwapChain.ImageIndex];					// Command buffer to submit
-		SubmitInfo.signalSemaphoreCount = GraphicSignalSemaphoreCount;						// Number of Semaphores to signal before the command buffer has finished
-		SubmitInfo.pSignalSemaphores = GraphicsSignalSemaphores;							// When the command buffer is finished, these semaphores will be signaled
+		FSubmitDesc GraphicsSubmit(FrameArena);
+		GraphicsSubmit.CommandBuffers.push_back(CommandBuffers[CurrentFrame]);
+		if (!bHeadless)
+		{
+			GraphicsSubmit.WaitBinary(OnImageAvailables[CurrentFrame], VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);	// Seen this in subpass dependency, command buffers will run until this stage
+			GraphicsSubmit.SignalBinary(OnRenderFinisheds[CurrentFrame]);
+		}
+		// Particles written by the latest compute submit, skipped when compute has never been submitted; a disabled compute pass is already complete
+		GraphicsSubmit.WaitTimeline(ETimeline::Compute, FrameScheduler.GetSubmittedValue(ETimeline::Compute), VK_PIPELINE_STAGE_VERTEX_INPUT_BIT);
+		// Only uploads that are known to be complete are drawn, so this never stalls; it orders the ownership acquire before the draws
+		// Vertex shader is included as pulled vertices are read from the arena as a storage buffer rather than through vertex input
+		GraphicsSubmit.WaitExternalTimeline(UploadContext.GetSemaphore(), ReadyUploadToken, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
 
 		// This is the execute function also because the queue will execute commands automatically
-		// When finish those commands, open(signal) this fence
-		VkResult Result = vkQueueSubmit(MainDevice.graphicQueue, 1, &SubmitInfo, VK_NULL_HANDLE);
-		RESULT_CHECK(Result, "Fail to submit command buffers to graphic queue");
+		// When finish those commands, the graphics timeline reaches the returned value
+		const uint64_t GraphicsValue = FrameScheduler.Submit(ETimeline::Graphics, MainDevice.graphicQueue, GraphicsSubmit, CurrentFrame);
+		Time::FramePacer.MarkSubmit();
+		ImageGraphicsValues[SwapChain.ImageIndex] = GraphicsValue;
+		if (pCompute)
+		{
+			pCompute->BufferGraphicsValues[pCompute->ReadBufferIndex] = GraphicsValue;
+		}
 
 		/** III. present image to screen when it has signaled finished rendering */
-		Result = presentFrame();
+		if (!bHeadless)
+		{
+			presentFrame();
+			Time::FramePacer.MarkPresent();
+		}
 
 		/** IV. Submit compute queue*/
 		postPresentationStage();
 
 		// Increment Elapsed Frame
 		++ElapsedFrame;
+
+		Time::FrameTimeCounter.Update(Time::DT, Time::Now() - DrawStart, FenceWaitTime);
 	}
 
 	void VKRenderer::cleanUp()
@@ -237,6 +315,7 @@ namespace VKE
 		}
 		
 		cTexture::Free();
+		cMaterial::Free();
 		// Clean up render list
 		for (auto Model : RenderList)
 		{
@@ -249,13 +328,20 @@ namespace VKE
 		// Clear all mesh assets
 		cMesh::Free();
 
+		for (auto& Cache : SecondaryCaches)
+		{
+			Cache.cleanUp();
+		}
+		CommandAllocator.cleanUp();
+		CommandBuffers.clear();
+
 		for (size_t i = 0; i < MAX_FRAME_DRAWS; ++i)
 		{
-			vkDestroySemaphore(MainDevice.LD, OnGraphicFinished[i], nullptr);
 			vkDestroySemaphore(MainDevice.LD, OnRenderFinisheds[i], nullptr);
 			vkDestroySemaphore(MainDevice.LD, OnImageAvailables[i], nullptr);
-			vkDestroyFence(MainDevice.LD, DrawFences[i], nullptr);
 		}
+		FrameScheduler.cleanUp();
+		FrameArena.cleanUp();
 
 		// clean up depth buffer
 		{
@@ -271,22 +357,45 @@ namespace VKE
 		// Descriptor related
 		{
 			vkDestroyDescriptorPool(MainDevice.LD, DescriptorPool, nullptr);
-			vkDestroyDescriptorPool(MainDevice.LD, SamplerDescriptorPool, nullptr);
-			for (size_t i = 0; i < SwapChain.Images.size(); ++i)
+			for (size_t i = 0; i < DescriptorSets.size(); ++i)
 			{
 				DescriptorSets[i].cleanUp();
-				
+			}
+			for (size_t i = 0; i < InputDescriptorSets.size(); ++i)
+			{
 				InputDescriptorSets[i].cleanUp();
 			}
 			
 			cDescriptorSet::CleanupDescriptorSetLayout(&MainDevice);
+			ObjectTable.cleanUp();
+			InstanceBatcher.cleanUp();
+			GpuCulling.cleanUp();
+			// Meshes have freed their ranges with cMesh::Free
+			GeometryArena.cleanUp();
+			MainDevice.GeometryArena = nullptr;
+			// Every set above came from here, nothing may allocate after this
+			DescriptorAllocator.cleanUp();
+			MainDevice.DescriptorAllocator = nullptr;
+			TextureTable.cleanUp();
+			MainDevice.TextureTable = nullptr;
+			SamplerCache.cleanUp();
+			MainDevice.SamplerCache = nullptr;
 		}
 
 		cleanupSwapChain();
 
-		vkDestroyCommandPool(MainDevice.LD, MainDevice.GraphicsCommandPool, nullptr);
+		vkDestroyCommandPool(MainDevice.LD, MainDevice.UploadCommandPool, nullptr);
+		UploadContext.cleanUp();
+		MainDevice.UploadContext = nullptr;
+
+		// All buffers and images are gone by now
+		MemoryAllocator.cleanUp();
+		MainDevice.MemoryAllocator = nullptr;
 
-		vkDestroySurfaceKHR(vkInstance, Surface, nullptr);
+		if (Surface != VK_NULL_HANDLE)
+		{
+			vkDestroySurfaceKHR(vkInstance, Surface, nullptr);
+		}
 		vkDestroyDevice(MainDevice.LD, nullptr);
 		vkDestroyInstance(vkInstance, nullptr);
 	}
@@ -312,9 +421,16 @@ namespace VKE
 
 	void VKRenderer::createInstance()
 	{
+		bool bUseValidationLayers = EnableValidationLayers;
 		if (EnableValidationLayers && !checkValidationLayerSupport())
 		{
-			throw std::runtime_error("validation layers requested, but not available!");
+			if (!bHeadless)
+			{
+				throw std::runtime_error("validation layers requested, but not available!");
+			}
+			// Build / benchmark hosts may only have a software ICD installed
+			printf("Warning: validation layers requested, but not available, continue without them.\n");
+			bUseValidationLayers = false;
 		}
 		// Create a application info
 		// Most data here doesn't affect the program and is for developer convenience
@@ -337,10 +453,13 @@ namespace VKE
 
 		// Create list to hold instance extensions
 		uint32_t glfwExtensionCount = 0;							// GLFW may require multiple extensions;
-		const char** glfwExtensions;								// Extensions passed as array of c-strings, so need the array to pointer
+		const char** glfwExtensions = nullptr;						// Extensions passed as array of c-strings, so need the array to pointer
 
-		// Get glfw extensions
-		glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+		// Get glfw extensions, headless mode has no surface and needs none
+		if (!bHeadless)
+		{
+			glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+		}
 
 		// Check instance Extensions supported
 		if (!checkInstanceExtensionSupport(glfwExtensions, glfwExtensionCount))
@@ -351,7 +470,7 @@ namespace VKE
 		CreateInfo.enabledExtensionCount = glfwExtensionCount;
 		CreateInfo.ppEnabledExtensionNames = glfwExtensions;
 
-		if (EnableValidationLayers)
+		if (bUseValidationLayers)
 		{
 			CreateInfo.enabledLayerCount = static_cast<uint32_t>(ValidationLayers.size());
 			CreateInfo.ppEnabledLayerNames = ValidationLayers.data();
@@ -409,7 +528,7 @@ namespace VKE
 		// vector for queue create information
 		std::vector< VkDeviceQueueCreateInfo> queueCreateInfos;
 		// set of queue family indices, prevent duplication
-		std::set<int> queueFamilyIndices = { MainDevice.QueueFamilyIndices.graphicFamily, MainDevice.QueueFamilyIndices.presentationFamily, MainDevice.QueueFamilyIndices.computeFamily };
+		std::set<int> queueFamilyIndices = { MainDevice.QueueFamilyIndices.graphicFamily, MainDevice.QueueFamilyIndices.presentationFamily, MainDevice.QueueFamilyIndices.computeFamily, MainDevice.QueueFamilyIndices.transferFamily };
 		const float DefaultPriority = 0.0f;
 		for (auto& queueFamilyIdx : queueFamilyIndices)
 		{
@@ -421,21 +540,60 @@ namespace VKE
 			queueCreateInfos.push_back(queueCreateInfo);
 		}
 
+		// Required extensions, no swap chain in headless mode
+		std::vector<const char*> EnabledExtensions;
+		if (!bHeadless)
+		{
+			EnabledExtensions = DeviceExtensions;
+		}
+		// Optional: heap budgets for the memory allocator's statistics
+		bool bMemoryBudget = false;
+		{
+			uint32_t ExtensionCount = 0;
+			vkEnumerateDeviceExtensionProperties(MainDevice.PD, nullptr, &ExtensionCount, nullptr);
+			std::vector<VkExtensionProperties> Extensions(ExtensionCount);
+			vkEnumerateDeviceExtensionProperties(MainDevice.PD, nullptr, &ExtensionCount, Extensions.data());
+			for (const auto& extension : Extensions)
+			{
+				if (strcmp(extension.extensionName, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME) == 0)
+				{
+					bMemoryBudget = true;
+					EnabledExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+					break;
+				}
+			}
+		}
+
 		// Info to create a (logical) device
 		VkDeviceCreateInfo DeviceCreateInfo = {};
 		DeviceCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
 		DeviceCreateInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());			// Number of queues in this device.
 		DeviceCreateInfo.pQueueCreateInfos = queueCreateInfos.data();									// list of queue create infos so that the devices will create required queues.
-		DeviceCreateInfo.enabledExtensionCount = static_cast<uint32_t>(DeviceExtensions.size());		// Number of enabled logical device extensions
-		DeviceCreateInfo.ppEnabledExtensionNames = DeviceExtensions.data();								// List of logical device extensions
+		DeviceCreateInfo.enabledExtensionCount = static_cast<uint32_t>(EnabledExtensions.size());		// Number of enabled logical device extensions
+		DeviceCreateInfo.ppEnabledExtensionNames = EnabledExtensions.empty() ? nullptr : EnabledExtensions.data();	// List of logical device extensions
 
 		// Physical Device Features the Logical Device will use
 		VkPhysicalDeviceFeatures PDFeatures = {};
 		PDFeatures.depthClamp = VK_TRUE;
 		PDFeatures.samplerAnisotropy = VK_TRUE;
+		PDFeatures.drawIndirectFirstInstance = VK_TRUE;						// Culled draws start at their batch's instances
+		PDFeatures.multiDrawIndirect = VK_TRUE;								// Batches of one geometry arena block are drawn with one call
 
 		DeviceCreateInfo.pEnabledFeatures = &PDFeatures;
 
+		// Vulkan 1.2 features, timeline semaphores drive all queue synchronization
+		VkPhysicalDeviceVulkan12Features PDFeatures12 = {};
+		PDFeatures12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+		PDFeatures12.timelineSemaphore = VK_TRUE;
+		// Descriptor indexing for the texture table, a runtime sized sampler array indexed per draw, written while bound
+		PDFeatures12.descriptorIndexing = VK_TRUE;
+		PDFeatures12.runtimeDescriptorArray = VK_TRUE;
+		PDFeatures12.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+		PDFeatures12.descriptorBindingPartiallyBound = VK_TRUE;
+		PDFeatures12.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+
+		DeviceCreateInfo.pNext = &PDFeatures12;
+
 		VkResult Result = vkCreateDevice(MainDevice.PD, &DeviceCreateInfo, nullptr, &MainDevice.LD);
 		RESULT_CHECK(Result, "Fail to Create VKLogical Device");
 
@@ -446,6 +604,22 @@ namespace VKE
 			/*given queue index(0 only one queue)*/ 0,
 			/*Out queue*/ &MainDevice.graphicQueue);
 		vkGetDeviceQueue(MainDevice.LD, MainDevice.QueueFamilyIndices.presentationFamily, 0, &MainDevice.presentationQueue);
+		vkGetDeviceQueue(MainDevice.LD, MainDevice.QueueFamilyIndices.transferFamily, 0, &MainDevice.transferQueue);
+
+		// Every buffer and image allocates its memory from here, so it has to exist before the first one is created
+		MemoryAllocator.init(MainDevice.PD, MainDevice.LD, bMemoryBudget);
+		MainDevice.MemoryAllocator = &MemoryAllocator;
+		// Same for descriptor sets, the pools grow with the scene instead of being sized up front
+		DescriptorAllocator.init(&MainDevice, MAX_FRAME_DRAWS);
+		MainDevice.DescriptorAllocator = &DescriptorAllocator;
+		// Textures register themselves when loaded and share samplers of the same state
+		TextureTable.init(&MainDevice);
+		MainDevice.TextureTable = &TextureTable;
+		SamplerCache.init(&MainDevice);
+		MainDevice.SamplerCache = &SamplerCache;
+		// Meshes sub-allocate their vertices and indices from shared buffers
+		GeometryArena.init(&MainDevice);
+		MainDevice.GeometryArena = &GeometryArena;
 	}
 
 	void VKRenderer::createSurface()
@@ -465,10 +639,15 @@ namespace VKE
 
 	void VKRenderer::createSwapChain()
 	{
+		if (bHeadless)
+		{
+			createOffscreenTargets();
+			return;
+		}
 		getSwapChainDetail(MainDevice.PD);
 		// Get Parameters for SwapChain
 		VkSurfaceFormatKHR SurfaceFormat = SwapChainDetail.getSurfaceFormat();
-		VkPresentModeKHR PresentMode = SwapChainDetail.getPresentationMode();
+		PresentMode = SwapChainDetail.getPresentationMode();
 		VkExtent2D Resolution = SwapChainDetail.getSwapExtent();
 
 		VkSwapchainCreateInfoKHR SwapChainCreateInfo = {};
@@ -545,10 +724,39 @@ namespace VKE
 
 			SwapChain.Images[i] = SwapChainImage;
 		}
-		assert(MAX_FRAME_DRAWS <= Images.size());
+		// No frame slot is using any image of the new swap chain yet
+		ImageGraphicsValues.assign(SwapChainImageCount, 0);
 		printf("%d Image view has been created\n", SwapChainImageCount);
 	}
 
+	void VKRenderer::createOffscreenTargets()
+	{
+		// One target per frame in flight, they take the place of swap chain images
+		const uint32_t TargetCount = MAX_FRAME_DRAWS;
+		SwapChain.SwapChain = VK_NULL_HANDLE;
+		SwapChain.ImageFormat = VK_FORMAT_R8G8B8A8_UNORM;
+		SwapChain.Extent = { WIDTH, HEIGHT };
+		SwapChain.ImageIndex = 0;
+
+		OffscreenTargets.resize(TargetCount);
+		SwapChain.Images.resize(TargetCount);
+		for (uint32_t i = 0; i < TargetCount; ++i)
+		{
+			if (!OffscreenTargets[i].init(&MainDevice, SwapChain.Extent.width, SwapChain.Extent.height, SwapChain.ImageFormat,
+				VK_IMAGE_TILING_OPTIMAL,
+				VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT |		// Final color output of the third sub-pass
+				VK_IMAGE_USAGE_TRANSFER_SRC_BIT				// Allow reading the result back
+				, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VK_IMAGE_ASPECT_COLOR_BIT, EMemoryCategory::Attachment))
+			{
+				throw std::runtime_error("Fail to create offscreen render target");
+			}
+			SwapChain.Images[i].Image = OffscreenTargets[i].GetImage();
+			SwapChain.Images[i].ImgView = OffscreenTargets[i].GetImageView();
+		}
+		ImageGraphicsValues.assign(TargetCount, 0);
+		printf("%d offscreen render targets have been created\n", TargetCount);
+	}
+
 	void VKRenderer::createRenderPass()
 	{
 		// Array of sub-passes
@@ -617,6 +825,11 @@ namespace VKE
 		// Initial layout -> subpasses1 layout -> ... -> subpassN layout -> final layout
 		SwapChainColorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;					// Image data layout before render pass starts
 		SwapChainColorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;				// Image data layout after render pass (to change to) for final purpose
+		if (bHeadless)
+		{
+			// Present layout needs the swap chain extension, offscreen targets are ready to be copied out instead
+			SwapChainColorAttachment.finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		}
 
 		// Attachment reference uses an attachment index that refers to index in the attachment list passed to renderPassCreateInfo
 		VkAttachmentReference SwapChainColorAttachmentReference = {};
@@ -705,37 +918,43 @@ namespace VKE
 	void VKRenderer::CreateDescriptorSets()
 	{
 		// 1. Prepare DescriptorSet Info
+		// Uniform data is written by the CPU every frame, so each frame in flight owns a copy
+		DescriptorSets.resize(MAX_FRAME_DRAWS, cDescriptorSet(&MainDevice));
+		// Input attachments belong to the swap chain image's frame buffer
 		size_t Count = SwapChain.Images.size();
-		DescriptorSets.resize(Count, cDescriptorSet(&MainDevice));
 		InputDescriptorSets.resize(Count, cDescriptorSet(&MainDevice));
 		// Create Buffers
-		for (size_t i = 0; i < Count; ++i)
+		for (size_t i = 0; i < DescriptorSets.size(); ++i)
 		{
 			DescriptorSets[i].CreateBufferDescriptor(sizeof(BufferFormats::FFrame), 1, VK_SHADER_STAGE_VERTEX_BIT);
-			DescriptorSets[i].CreateDynamicBufferDescriptor(sizeof(BufferFormats::FDrawCall), MAX_OBJECTS, VK_SHADER_STAGE_VERTEX_BIT);
-
+		}
+		// Per-object data lives in its own storage buffer set, it grows with the scene
+		ObjectTable.init(&MainDevice);
+		InstanceBatcher.init(&MainDevice);
+		GpuCulling.init(&MainDevice, ObjectTable.GetDescriptorSetLayout());
+		for (size_t i = 0; i < Count; ++i)
+		{
 			InputDescriptorSets[i].CreateImageBufferDescriptor(&ColorBuffers[i], VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, VK_SHADER_STAGE_FRAGMENT_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 			InputDescriptorSets[i].CreateImageBufferDescriptor(&DepthBuffers[i], VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, VK_SHADER_STAGE_FRAGMENT_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 		}
 
-		// 2. Create Descriptor Pool
+		// 2. Create Descriptor Pool, imgui only
 		createDescriptorPool();
-		// 3. Create Descriptor Set Layout
 		for (size_t i = 0; i < DescriptorSets.size(); ++i)
 		{
-			// UNIFORM DESCRIPTOR SET LAYOUT
+			// 3. Create Descriptor Set Layout, UNIFORM DESCRIPTOR SET LAYOUT
 			DescriptorSets[i].CreateDescriptorSetLayout(FirstPass_vert);
-			// INPUT DESCRIPTOR LAYOUT
-			InputDescriptorSets[i].CreateDescriptorSetLayout(ThirdPass_frag);
+			// 4. Allocate Descriptor sets
+			DescriptorSets[i].AllocateDescriptorSet();
+			// 5. Update set write info
+			DescriptorSets[i].BindDescriptorWithSet();
 		}
 
 		for (size_t i = 0; i < Count; ++i)
 		{
-			// 4. Allocate Descriptor sets
-			DescriptorSets[i].AllocateDescriptorSet(DescriptorPool);
-			InputDescriptorSets[i].AllocateDescriptorSet(DescriptorPool);
-			// 5. Update set write info
-			DescriptorSets[i].BindDescriptorWithSet();
+			// INPUT DESCRIPTOR LAYOUT
+			InputDescriptorSets[i].CreateDescriptorSetLayout(ThirdPass_frag);
+			InputDescriptorSets[i].AllocateDescriptorSet();
 			InputDescriptorSets[i].BindDescriptorWithSet();
 		}
 	}
@@ -745,7 +964,7 @@ namespace VKE
 		// Define push constant range, no need to create
 		PushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
 		PushConstantRange.offset = 0;
-		PushConstantRange.size = sizeof(glm::mat4);		// Size of data being pass
+		PushConstantRange.size = sizeof(BufferFormats::FDrawConstants);		// Object index into the object table, texture index into the texture table
 	}
 
 	void VKRenderer::createGraphicsPipeline()
@@ -754,7 +973,7 @@ namespace VKE
 		VkGraphicsPipelineCreateInfo PieplineCreateInfo = {};
 
 		// === Read in SPIR-V code of shaders === 
-		auto VertexShaderCode = FileIO::ReadFile("Content/Shaders/vert.spv");
+		auto VertexShaderCode = FileIO::ReadFile(USE_VERTEX_PULLING ? "Content/Shaders/vert_pull.spv" : "Content/Shaders/vert.spv");
 		auto FragShaderCode = FileIO::ReadFile("Content/Shaders/frag.spv");
 
 		// Build Shader Module to link to Graphics Pipeline
@@ -784,8 +1003,14 @@ namespace VKE
 		VertexBindDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;			// Define how to move between data after each vertex, 
 																				// VK_VERTEX_INPUT_RATE_VERTEX : move to the next vertex
 																				// VK_VERTEX_INPUT_RATE_INSTANCE : Move to a vertex for the next instance
+		// Object and texture index of every visible instance, one instanced draw covers all objects sharing a mesh and a material
+		VkVertexInputBindingDescription InstanceBindDescription = {};
+		InstanceBindDescription.binding = INSTANCE_BUFFER_BIND_ID;
+		InstanceBindDescription.stride = sizeof(BufferFormats::FInstanceData);
+		InstanceBindDescription.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+
 		// How the data for an attribute is defined within a vertex
-		const uint32_t AttrubuteDescriptionCount = 3;
+		const uint32_t AttrubuteDescriptionCount = 5;
 		VkVertexInputAttributeDescription VertexInputAttributeDescriptions[AttrubuteDescriptionCount];
 
 		// Position attribute
@@ -803,12 +1028,27 @@ namespace VKE
 		VertexInputAttributeDescriptions[2].location = 2;
 		VertexInputAttributeDescriptions[2].format = VK_FORMAT_R32G32_SFLOAT;
 		VertexInputAttributeDescriptions[2].offset = offsetof(FVertex, TexCoord);
+		// object index attribute, per instance
+		VertexInputAttributeDescriptions[3].binding = INSTANCE_BUFFER_BIND_ID;
+		VertexInputAttributeDescriptions[3].location = 3;
+		VertexInputAttributeDescriptions[3].format = VK_FORMAT_R32_UINT;
+		VertexInputAttributeDescriptions[3].offset = offsetof(BufferFormats::FInstanceData, ObjectIndex);
+		// texture index attribute, per instance
+		VertexInputAttributeDescriptions[4].binding = INSTANCE_BUFFER_BIND_ID;
+		VertexInputAttributeDescriptions[4].location = 4;
+		VertexInputAttributeDescriptions[4].format = VK_FORMAT_R32_UINT;
+		VertexInputAttributeDescriptions[4].offset = offsetof(BufferFormats::FInstanceData, TextureID);
+
+		const uint32_t VertexBindDescriptionCount = 2;
+		VkVertexInputBindingDescription VertexBindDescriptions[VertexBindDescriptionCount] = { VertexBindDescription, InstanceBindDescription };
+		// Vertex pulling reads the vertices from set 3, only the per-instance binding and attributes are left
+		const uint32_t PulledAttributeOffset = 3;
 
 		VertexInputCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-		VertexInputCreateInfo.vertexBindingDescriptionCount = 1;
-		VertexInputCreateInfo.pVertexBindingDescriptions = &VertexBindDescription;				// list of vertex binding description data spacing, stride info
-		VertexInputCreateInfo.vertexAttributeDescriptionCount = AttrubuteDescriptionCount;
-		VertexInputCreateInfo.pVertexAttributeDescriptions = VertexInputAttributeDescriptions;				// data format where to bind in shader
+		VertexInputCreateInfo.vertexBindingDescriptionCount = USE_VERTEX_PULLING ? 1 : VertexBindDescriptionCount;
+		VertexInputCreateInfo.pVertexBindingDescriptions = USE_VERTEX_PULLING ? &InstanceBindDescription : VertexBindDescriptions;	// list of vertex binding description data spacing, stride info
+		VertexInputCreateInfo.vertexAttributeDescriptionCount = USE_VERTEX_PULLING ? AttrubuteDescriptionCount - PulledAttributeOffset : AttrubuteDescriptionCount;
+		VertexInputCreateInfo.pVertexAttributeDescriptions = USE_VERTEX_PULLING ? &VertexInputAttributeDescriptions[PulledAttributeOffset] : VertexInputAttributeDescriptions;	// data format where to bind in shader
 
 
 		// === Input Assembly ===
@@ -914,8 +1154,9 @@ namespace VKE
 		// === Pipeline layout ===
 		VkPipelineLayoutCreateInfo PipelineLayoutCreateInfo = {};
 
-		const uint32_t SetLayoutCount = 2;
-		VkDescriptorSetLayout Layouts[SetLayoutCount] = { DescriptorSets[0].GetDescriptorSetLayout(), cDescriptorSet::GetDescriptorSetLayout(FirstPass_frag) };
+		// Set 3 is only bound with vertex pulling
+		const uint32_t SetLayoutCount = 4;
+		VkDescriptorSetLayout Layouts[SetLayoutCount] = { DescriptorSets[0].GetDescriptorSetLayout(), TextureTable.GetDescriptorSetLayout(), ObjectTable.GetDescriptorSetLayout(), GeometryArena.GetDescriptorSetLayout() };
 
 		PipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
 		PipelineLayoutCreateInfo.setLayoutCount = SetLayoutCount;
@@ -1055,15 +1296,15 @@ namespace VKE
 			ParticleColorBlendStateCreateInfo.pAttachments = &ParticleColorStateAttachments;
 
 			// Create Another pipeline layout
-			const uint32_t ParticleSetLayoutCount = 2;
-			VkDescriptorSetLayout ParticlePassLayouts[ParticleSetLayoutCount] = { cDescriptorSet::GetDescriptorSetLayout(EDescriptorSetType::FirstPass_vert), cDescriptorSet::GetDescriptorSetLayout(EDescriptorSetType::ParticlePass_frag) };
+			const uint32_t ParticleSetLayoutCount = 3;
+			VkDescriptorSetLayout ParticlePassLayouts[ParticleSetLayoutCount] = { cDescriptorSet::GetDescriptorSetLayout(EDescriptorSetType::FirstPass_vert), TextureTable.GetDescriptorSetLayout(), ObjectTable.GetDescriptorSetLayout() };
 
 			VkPipelineLayoutCreateInfo PipelineLayoutCreateInfo1 = {};
 			PipelineLayoutCreateInfo1.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
 			PipelineLayoutCreateInfo1.setLayoutCount = ParticleSetLayoutCount;
 			PipelineLayoutCreateInfo1.pSetLayouts = ParticlePassLayouts;
-			PipelineLayoutCreateInfo1.pushConstantRangeCount = 0;
-			PipelineLayoutCreateInfo1.pPushConstantRanges = nullptr;
+			PipelineLayoutCreateInfo1.pushConstantRangeCount = 1;
+			PipelineLayoutCreateInfo1.pPushConstantRanges = &PushConstantRange;		// Emitter's object index and texture
 
 			Result = vkCreatePipelineLayout(MainDevice.LD, &PipelineLayoutCreateInfo1, nullptr, &RenderParticlePipelineLayout);
 			RESULT_CHECK(Result, "Fail to create the second pipeline layout");
@@ -1143,7 +1384,11 @@ namespace VKE
 		createRenderPass();
 		createGraphicsPipeline();
 		createFrameBuffer();
-		createCommandBuffers();
+
+		// Render pass, pipelines and images are new, cached command buffers point to destroyed objects
+		SecondaryCaches[2].cleanUp();
+		SecondaryCaches[2].init(&MainDevice, MainDevice.QueueFamilyIndices.graphicFamily, static_cast<uint32_t>(SwapChain.Images.size()), JobSystem::GetThreadCount());
+		MarkCommandsDirty();
 	}
 
 	void VKRenderer::cleanupSwapChain()
@@ -1153,8 +1398,6 @@ namespace VKE
 			vkDestroyFramebuffer(MainDevice.LD, FrameBuffer, nullptr);
 		}
 
-		vkFreeCommandBuffers(MainDevice.LD, MainDevice.GraphicsCommandPool, static_cast<uint32_t>(CommandBuffers.size()), CommandBuffers.data());
-
 		// Destroy pipelines first and then destroy render pass
 		vkDestroyPipeline(MainDevice.LD, PostProcessPipeline, nullptr);
 		vkDestroyPipelineLayout(MainDevice.LD, PostProcessPipelineLayout, nullptr);
@@ -1167,6 +1410,16 @@ namespace VKE
 
 		vkDestroyRenderPass(MainDevice.LD, RenderPass, nullptr);
 
+		if (bHeadless)
+		{
+			// Offscreen targets own their images and views
+			for (auto& Target : OffscreenTargets)
+			{
+				Target.cleanUp();
+			}
+			OffscreenTargets.clear();
+			return;
+		}
 		for (auto & Image : SwapChain.Images)
 		{
 			vkDestroyImageView(MainDevice.LD, Image.ImgView, nullptr);
@@ -1202,7 +1455,7 @@ namespace VKE
 				VK_IMAGE_TILING_OPTIMAL,
 				VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT |	// Use as depth / stencil attachment output
 				VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT			// Also use as input in the next sub-pass
-				, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VK_IMAGE_ASPECT_DEPTH_BIT))
+				, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VK_IMAGE_ASPECT_DEPTH_BIT, EMemoryCategory::Attachment))
 			{
 				throw std::runtime_error("Fail to create depth buffer image");
 				return;
@@ -1212,7 +1465,7 @@ namespace VKE
 				VK_IMAGE_TILING_OPTIMAL,
 				VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT |		// Use as color attachment output
 				VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT			// Also use as input in the next sub-pass
-				, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VK_IMAGE_ASPECT_COLOR_BIT))
+				, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VK_IMAGE_ASPECT_COLOR_BIT, EMemoryCategory::Attachment))
 			{
 				throw std::runtime_error("Fail to create color buffer image");
 				return;
@@ -1257,140 +1510,124 @@ namespace VKE
 		CommandPoolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
 		CommandPoolCreateInfo.pNext = nullptr;
 		CommandPoolCreateInfo.queueFamilyIndex = MainDevice.QueueFamilyIndices.graphicFamily;					// Queue family type that buffers from this command pool will use
-		CommandPoolCreateInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;	// Allow reset so that we can re-record in run-time
-																						// VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT makes vkBeginCommandBuffer(...) dump all previous commands
+		CommandPoolCreateInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;			// Upload command buffers are allocated, submitted once and freed
 
-		// Create a Graphics Queue Family Command Pool
-		VkResult Result = vkCreateCommandPool(MainDevice.LD, &CommandPoolCreateInfo, nullptr, &MainDevice.GraphicsCommandPool);
+		// Create a Graphics Queue Family Command Pool for uploads, kept apart from the per-frame pools
+		VkResult Result = vkCreateCommandPool(MainDevice.LD, &CommandPoolCreateInfo, nullptr, &MainDevice.UploadCommandPool);
 		RESULT_CHECK(Result, "Fail to create a command pool.");
+
+		// Asset uploads are staged and submitted in batches on the transfer queue, the graphic family owns the results
+		if (!UploadContext.init(&MainDevice, MainDevice.QueueFamilyIndices.transferFamily, MainDevice.transferQueue, MainDevice.QueueFamilyIndices.graphicFamily, MainDevice.graphicQueue))
+		{
+			throw std::runtime_error("Fail to create upload context");
+		}
+		MainDevice.UploadContext = &UploadContext;
+
+		// Create transient per-frame-slot command pools for recording
+		// Secondary command buffers are recorded by job system threads, every thread gets its own pools (thread index 0 is the main thread)
+		// Primary command buffers are transient, they only stitch cached secondaries together
+		if (!CommandAllocator.init(&MainDevice, MainDevice.QueueFamilyIndices.graphicFamily, MAX_FRAME_DRAWS, JobSystem::GetThreadCount()))
+		{
+			throw std::runtime_error("Fail to create command allocator");
+		}
+		// Cached secondaries, entries match SecondaryCacheEntries
+		const uint32_t CacheEntryCounts[SUBPASS_COUNT] = { MAX_FRAME_DRAWS, MAX_FRAME_DRAWS * cEmitter::ParticleBufferCount, static_cast<uint32_t>(SwapChain.Images.size()) };
+		for (uint32_t i = 0; i < SUBPASS_COUNT; ++i)
+		{
+			if (!SecondaryCaches[i].init(&MainDevice, MainDevice.QueueFamilyIndices.graphicFamily, CacheEntryCounts[i], JobSystem::GetThreadCount()))
+			{
+				throw std::runtime_error("Fail to create secondary command cache");
+			}
+		}
 	}
 
 	void VKRenderer::createCommandBuffers()
 	{
-		//Resize command buffer count to have one for each framebuffer
-		CommandBuffers.resize(SwapChainFramebuffers.size());
-
-		VkCommandBufferAllocateInfo cbAllocInfo = {};										// Memory exists already, only get it from the pool
-		cbAllocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-		cbAllocInfo.commandPool = MainDevice.GraphicsCommandPool;							// Only works for graphics command pool
-		cbAllocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;								// VK_COMMAND_BUFFER_LEVEL_PRIMARY: Submitted directly to queue, can not be called by another command buffer
-																							// VK_COMMAND_BUFFER_LEVEL_SECONDARY: Command buffer within a command buffer e.g. VkCmdExecuteCommands(another command buffer)
-		cbAllocInfo.commandBufferCount = static_cast<uint32_t>(CommandBuffers.size());		// Allows allocating multiple command buffers at the same time
-
-		VkResult Result = vkAllocateCommandBuffers(MainDevice.LD, &cbAllocInfo, CommandBuffers.data());		// Don't need a custom allocation function
-		RESULT_CHECK(Result, "Fail to allocate command buffers.");
-
-		// Record the command buffer and call this buffer once and once again.
+		// Resize command buffer count to have one for each frame in flight,
+		// the actual command buffers are handed out by the command allocator every frame after the frame slot is reset
+		CommandBuffers.resize(MAX_FRAME_DRAWS, VK_NULL_HANDLE);
 	}
 
 	void VKRenderer::createSynchronization()
 	{
-		OnGraphicFinished.resize(MAX_FRAME_DRAWS);
+		// Binary semaphores are only used by swap chain acquire / present
 		OnImageAvailables.resize(MAX_FRAME_DRAWS);
 		OnRenderFinisheds.resize(MAX_FRAME_DRAWS);
-		DrawFences.resize(MAX_FRAME_DRAWS);
 
 		// Semaphore creation information
 		VkSemaphoreCreateInfo SemaphoreCreateInfo = {};
 		SemaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
-		// Fence creation information
-		VkFenceCreateInfo FenceCreateInfo = {};
-		FenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-		FenceCreateInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
-
 		for (size_t i = 0; i < MAX_FRAME_DRAWS; ++i)
 		{
-			VkResult Result = vkCreateSemaphore(MainDevice.LD, &SemaphoreCreateInfo, nullptr, &OnGraphicFinished[i]);
-			RESULT_CHECK_ARGS(Result, "Fail to create OnGraphicFinished[%d] Semaphore", i);
-
-			Result = vkCreateSemaphore(MainDevice.LD, &SemaphoreCreateInfo, nullptr, &OnImageAvailables[i]);
+			VkResult Result = vkCreateSemaphore(MainDevice.LD, &SemaphoreCreateInfo, nullptr, &OnImageAvailables[i]);
 			RESULT_CHECK_ARGS(Result, "Fail to create OnImageAvailables[%d] Semaphore", i);
 
 			Result = vkCreateSemaphore(MainDevice.LD, &SemaphoreCreateInfo, nullptr, &OnRenderFinisheds[i]);
 			RESULT_CHECK_ARGS(Result, "Fail to create OnRenderFinisheds[%d] Semaphore", i);
+		}
 
-			Result = vkCreateFence(MainDevice.LD, &FenceCreateInfo, nullptr, &DrawFences[i]);
-			RESULT_CHECK_ARGS(Result, "Fail to create DrawFences[%d] Fence", i);
+		// Timeline semaphores for everything submitted to graphics / compute / transfer queues
+		if (!FrameScheduler.init(&MainDevice, MAX_FRAME_DRAWS))
+		{
+			throw std::runtime_error("Fail to create frame scheduler");
 		}
+		// Transient CPU data of every frame slot, rewound together with the slot's command buffers
+		FrameArena.init(MAX_FRAME_DRAWS);
 	}
 
 	void VKRenderer::createDescriptorPool()
 	{
-		// Type of descriptors + how many DESCRIPTORS, not DESCRIPTOR Sets (combined makes the pool size)
-		// in order to enable imgui, needs a larger descriptor pool
-		const uint32_t DescriptorTypeCount = 11;
-		const uint32_t MaxDescriptorsPerType = 1000;
-		VkDescriptorPoolSize PoolSize[] =
-		{
-			{ VK_DESCRIPTOR_TYPE_SAMPLER, MaxDescriptorsPerType },
-			{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, MaxDescriptorsPerType },
-			{ VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, MaxDescriptorsPerType },
-			{ VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, MaxDescriptorsPerType },
-			{ VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER, MaxDescriptorsPerType },
-			{ VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER, MaxDescriptorsPerType },
-			{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, MaxDescriptorsPerType },
-			{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, MaxDescriptorsPerType },
-			{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, MaxDescriptorsPerType },
-			{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, MaxDescriptorsPerType },
-			{ VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, MaxDescriptorsPerType }
-		};
+		// Engine sets come from DescriptorAllocator, this pool only serves imgui, which allocates its font texture set from it
+		const uint32_t MaxImGuiSets = 16;
+		VkDescriptorPoolSize PoolSize = {};
+		PoolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		PoolSize.descriptorCount = MaxImGuiSets;
 
 		VkDescriptorPoolCreateInfo PoolCreateInfo = {};
 		PoolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-		PoolCreateInfo.maxSets = DescriptorTypeCount * MaxDescriptorsPerType;
-		PoolCreateInfo.poolSizeCount = DescriptorTypeCount;
-		PoolCreateInfo.pPoolSizes = PoolSize;
+		PoolCreateInfo.maxSets = MaxImGuiSets;
+		PoolCreateInfo.poolSizeCount = 1;
+		PoolCreateInfo.pPoolSizes = &PoolSize;
 
 		VkResult Result = vkCreateDescriptorPool(MainDevice.LD, &PoolCreateInfo, nullptr, &DescriptorPool);
 		RESULT_CHECK(Result, "Failed to create a Descriptor Pool");
-
-		// CREATE SAMPLER DESCRIPTOR POOL
-		{
-			VkDescriptorPoolSize SamplerPoolSize = {};
-			SamplerPoolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-			SamplerPoolSize.descriptorCount = MAX_OBJECTS * 2;		// Not optimal setup, one image binds to one descriptor
-
-			VkDescriptorPoolCreateInfo SamplerPoolCreateInfo = {};
-			SamplerPoolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-			SamplerPoolCreateInfo.maxSets = MAX_OBJECTS;			// One object binds to one descriptor sets
-			SamplerPoolCreateInfo.poolSizeCount = 1;
-			SamplerPoolCreateInfo.pPoolSizes = &SamplerPoolSize;
-
-			Result = vkCreateDescriptorPool(MainDevice.LD, &SamplerPoolCreateInfo, nullptr, &SamplerDescriptorPool);
-			RESULT_CHECK(Result, "Failed to create a Sampler Descriptor Pool");
-		}
 	}
 
 	void VKRenderer::updateUniformBuffers()
 	{
-		int idx = SwapChain.ImageIndex;
+		int idx = ElapsedFrame % MAX_FRAME_DRAWS;
+		// Particle simulation and emitter data, read by this frame slot's dispatch
+		for (size_t i = 0; i < pCompute->Emitters.size(); ++i)
+		{
+			pCompute->Emitters[i].UpdateUniformBuffers(static_cast<uint32_t>(idx));
+		}
 		// Copy Frame data
 		if (cDescriptor_Buffer* Buffer = DescriptorSets[idx].GetDescriptorAt<cDescriptor_Buffer>(0))
 		{
 			Buffer->UpdateBufferData(&GetCurrentCamera()->GetFrameData());
 		}
 
-		if (cDescriptor_DynamicBuffer* DBuffer = DescriptorSets[idx].GetDescriptorAt<cDescriptor_DynamicBuffer>(1))
+		// Object table: models first, then emitters
+		ObjectTable.Resize(static_cast<uint32_t>(RenderList.size() + pCompute->Emitters.size()));
+		// Interpolating transforms of many objects is spread over the job system
+		const float Alpha = static_cast<float>(Time::SimulationClock.Alpha);
+		JobSystem::ParallelFor(RenderList.size(), MIN_OBJECTS_PER_JOB, [&](size_t Begin, size_t End)
 		{
-			using namespace BufferFormats;
-			// Update model data to pDrawcallTransferSpace
-			for (size_t i = 0; i < RenderList.size(); ++i)
-			{
-				FDrawCall* Drawcall = reinterpret_cast<FDrawCall*>(reinterpret_cast<uint64_t>(DBuffer->GetAllocatedMemory()) + (i *DBuffer->GetSlotSize()));
-				*Drawcall = RenderList[i]->Transform.M();
-			}
-			for (size_t i = 0; i < pCompute->Emitters.size(); ++i)
+			for (size_t i = Begin; i < End; ++i)
 			{
-				// Particle is drawn after all render objects
-				FDrawCall* ParticleDrawcall = reinterpret_cast<FDrawCall*>(reinterpret_cast<uint64_t>(DBuffer->GetAllocatedMemory()) + ((RenderList.size() + i) * DBuffer->GetSlotSize()));
-				*ParticleDrawcall = pCompute->Emitters[i].Transform.M();
+				const uint32_t MaterialID = RenderList[i]->GetMeshCount() > 0 ? static_cast<uint32_t>(RenderList[i]->GetMesh(0)->GetMaterialID()) : 0;
+				ObjectTable.Set(static_cast<uint32_t>(i), RenderList[i]->Transform.Interpolate(Alpha), MaterialID);
 			}
-			
-			// Copy Model data RenderList.Size() + Emitter.Size()
-			// Reuse void* Data
-			size_t DBufferSize = static_cast<size_t>(DBuffer->GetSlotSize()) * (RenderList.size() + pCompute->Emitters.size());
-			DBuffer->UpdatePartialData(DBuffer->GetAllocatedMemory(), 0, DBufferSize);
+		});
+		for (size_t i = 0; i < pCompute->Emitters.size(); ++i)
+		{
+			ObjectTable.Set(static_cast<uint32_t>(RenderList.size() + i), pCompute->Emitters[i].Transform.Interpolate(Alpha), pCompute->Emitters[i].MaterialID);
+		}
+		// Only changed objects are written, a grown table replaced the slot's descriptor set so cached commands are stale
+		if (ObjectTable.Upload(static_cast<uint32_t>(idx)))
+		{
+			MarkCommandsDirty();
 		}
 
 	}
@@ -1500,10 +1737,49 @@ namespace VKE
 		{
 			return false;
 		}
-		if (!deviceFeatures.samplerAnisotropy)
+		if (!deviceFeatures.samplerAnisotropy || !deviceFeatures.drawIndirectFirstInstance || !deviceFeatures.multiDrawIndirect)
 		{
 			return false;
 		}
+		// Timeline semaphore is core in 1.2 but still an optional feature
+		VkPhysicalDeviceVulkan12Features deviceFeatures12 = {};
+		deviceFeatures12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+		VkPhysicalDeviceFeatures2 deviceFeatures2 = {};
+		deviceFeatures2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		deviceFeatures2.pNext = &deviceFeatures12;
+		vkGetPhysicalDeviceFeatures2(device, &deviceFeatures2);
+		if (!deviceFeatures12.timelineSemaphore)
+		{
+			return false;
+		}
+		// Texture table
+		if (!deviceFeatures12.descriptorIndexing || !deviceFeatures12.runtimeDescriptorArray || !deviceFeatures12.shaderSampledImageArrayNonUniformIndexing
+			|| !deviceFeatures12.descriptorBindingPartiallyBound || !deviceFeatures12.descriptorBindingSampledImageUpdateAfterBind)
+		{
+			return false;
+		}
+		VkPhysicalDeviceVulkan12Properties deviceProperties12 = {};
+		deviceProperties12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES;
+		VkPhysicalDeviceProperties2 deviceProperties2 = {};
+		deviceProperties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+		deviceProperties2.pNext = &deviceProperties12;
+		vkGetPhysicalDeviceProperties2(device, &deviceProperties2);
+		if (deviceProperties12.maxPerStageDescriptorUpdateAfterBindSamplers < MAX_BINDLESS_TEXTURES
+			|| deviceProperties12.maxPerStageDescriptorUpdateAfterBindSampledImages < MAX_BINDLESS_TEXTURES
+			|| deviceProperties12.maxDescriptorSetUpdateAfterBindSamplers < MAX_BINDLESS_TEXTURES
+			|| deviceProperties12.maxDescriptorSetUpdateAfterBindSampledImages < MAX_BINDLESS_TEXTURES)
+		{
+			return false;
+		}
+		if (deviceProperties2.properties.limits.maxDrawIndirectCount < MAX_MULTI_DRAW_COUNT)
+		{
+			return false;
+		}
+		// No swap chain in headless mode, so the device doesn't need to present
+		if (bHeadless)
+		{
+			return true;
+		}
 		if (!checkDeviceExtensionSupport(device))
 		{
 			return false;
@@ -1560,46 +1836,379 @@ namespace VKE
 		// get vector of all materials with 1:1 ID placement
 		std::vector<std::string> TextureNames = cModel::LoadMaterials(scene);
 
-		// Conversion from the materials list IDs to our Descriptor Array IDs
-		std::vector<int> MatToTex(TextureNames.size(), 0);
+		// Conversion from the materials list IDs to material IDs, assimp materials with the same texture share one material
+		std::vector<uint32_t> MatToMaterial(TextureNames.size(), 0);
+
+		// Decode texture files on the job system, the images are created and staged on this thread below
+		std::vector<FileIO::FTextureData> DecodedTextures(TextureNames.size());
+		JobSystem::ParallelFor(TextureNames.size(), 1, [&](size_t Begin, size_t End)
+		{
+			for (size_t i = Begin; i < End; ++i)
+			{
+				if (TextureNames[i].empty() || cTexture::IsLoaded(TextureNames[i]))
+				{
+					continue;
+				}
+				FileIO::FTextureData& Decoded = DecodedTextures[i];
+				try
+				{
+					Decoded.Data = FileIO::LoadTextureFile(TextureNames[i], Decoded.Width, Decoded.Height, Decoded.Size);
+				}
+				catch (const std::runtime_error&)
+				{
+					// Loaded again on this thread below, which reports the error
+					Decoded.Data = nullptr;
+				}
+			}
+		});
 
-		// Loop over texture names and create texture for them
-		for (size_t i = 0; i < MatToTex.size(); ++i)
+		// Loop over texture names and create texture and material for them
+		for (size_t i = 0; i < MatToMaterial.size(); ++i)
 		{
-			// texture 0 will be reserved for default texture
+			// material 0 will be reserved for default material
 			if (TextureNames[i].empty())
 			{
-				MatToTex[i] = 0;
+				MatToMaterial[i] = 0;
 			}
 			else
 			{
-				auto newTex = cTexture::Load(TextureNames[i], MainDevice, VK_FORMAT_R8G8B8A8_UNORM);
-				// Set value to index of new texture
-				MatToTex[i] = newTex->GetID();
+				auto newTex = cTexture::Load(TextureNames[i], MainDevice, VK_FORMAT_R8G8B8A8_UNORM, &DecodedTextures[i]);
+				// A texture that failed to load has no slot in the texture table
+				FMaterialDesc MaterialDesc;
+				MaterialDesc.AlbedoTextureID = newTex->GetID() >= 0 ? newTex->GetID() : EDefaultTextureID::White;
+				MatToMaterial[i] = cMaterial::Load(MaterialDesc)->GetID();
 			}
 		}
 
-		std::vector<std::shared_ptr<cMesh>> Meshes = cModel::LoadNode(ifileName, MainDevice, MainDevice.graphicQueue, MainDevice.GraphicsCommandPool, scene->mRootNode, scene, MatToTex);
-		for (auto& Mesh : Meshes)
+		// Meshes sample their material's textures from the texture table, they need no descriptor set of their own
+		std::vector<std::shared_ptr<cMesh>> Meshes = cModel::LoadNode(ifileName, MainDevice, scene->mRootNode, scene, MatToMaterial);
+		oModel = std::make_shared<cModel>(Meshes);
+		// Textures and meshes above are in the pending batch, submit it now so the copies start right away
+		oModel->SetUploadToken(UploadContext.Submit());
+
+		return true;
+	}
+
+	void VKRenderer::recordSecondaryCommands(int CurrentFrame)
+	{
+		const size_t ModelCount = RenderList.size();
+		const size_t EmitterCount = pCompute->Emitters.size();
+		const uint32_t ThreadCount = JobSystem::GetThreadCount();
+
+		// 0. Pick the cache entry of each subpass from what its recording depends on
+		// Subpass 0 uses the frame slot's descriptor set, subpass 1 also binds the particle buffer to draw, subpass 2 reads the image's input attachments
+		SecondaryCacheEntries[0] = CurrentFrame;
+		SecondaryCacheEntries[1] = CurrentFrame * cEmitter::ParticleBufferCount + pCompute->ReadBufferIndex;
+		SecondaryCacheEntries[2] = SwapChain.ImageIndex;
+
+		// Adding to the render list is a structural change even without MarkCommandsDirty()
+		if (ModelCount != CachedModelCount || EmitterCount != CachedEmitterCount)
+		{
+			MarkCommandsDirty();
+			CachedModelCount = ModelCount;
+			CachedEmitterCount = EmitterCount;
+		}
+		// Meshes entering or leaving the view change the batches, only the model draws are recorded again
+		if (cullModels())
+		{
+			SecondaryCaches[0].Invalidate();
+		}
+
+		// 1. Split draws of out of date subpasses into tasks, contiguous ranges keep each secondary command buffer in the original draw order
+		struct FRecordTask
+		{
+			uint32_t Subpass;
+			size_t Begin, End;
+			VkCommandBuffer* pOutput;
+		};
+		auto Split = [ThreadCount](size_t Count) -> size_t
+		{
+			// At least MIN_DRAWS_PER_RECORD_TASK draws per task, not worth a secondary command buffer otherwise
+			const size_t PerThread = (Count + ThreadCount - 1) / ThreadCount;
+			return PerThread > MIN_DRAWS_PER_RECORD_TASK ? PerThread : MIN_DRAWS_PER_RECORD_TASK;
+		};
+		// Batches only change with what is recorded, rebuild them when the frame slot's model draws are recorded again
+		if (!SecondaryCaches[0].IsValid(SecondaryCacheEntries[0]))
+		{
+			buildInstanceBatches(CurrentFrame);
+			ModelBindCount = 0;
+			SkippedModelBindCount = 0;
+		}
+		const size_t DrawCounts[SUBPASS_COUNT] = { InstanceBatcher.GetBatches(CurrentFrame).size(), EmitterCount, 1 };
+
+		// Only needed until the cache has copied them, so the lists live in the frame arena
+		VkCommandBuffer* Recorded[SUBPASS_COUNT] = {};
+		uint32_t RecordedCounts[SUBPASS_COUNT] = {};
+		FrameVector<FRecordTask> Tasks(FrameArena);
+		for (uint32_t Subpass = 0; Subpass < SUBPASS_COUNT; ++Subpass)
 		{
-			if (Mesh.get())
+			cCommandCache& Cache = SecondaryCaches[Subpass];
+			const uint32_t Entry = SecondaryCacheEntries[Subpass];
+			if (Cache.IsValid(Entry))
 			{
-				Mesh->CreateDescriptorSet(SamplerDescriptorPool);
+				continue;
+			}
+			// The entry was last executed by this frame slot / image, which has been waited for in prepareForDraw
+			Cache.BeginRecord(Entry);
+			const size_t Chunk = Split(DrawCounts[Subpass]);
+			const size_t TaskCount = (DrawCounts[Subpass] + Chunk - 1) / Chunk;
+			Recorded[Subpass] = FrameArena.AllocateArray<VkCommandBuffer>(TaskCount);
+			RecordedCounts[Subpass] = static_cast<uint32_t>(TaskCount);
+			for (size_t i = 0; i < TaskCount; ++i)
+			{
+				Tasks.push_back({ Subpass, i * Chunk, std::min((i + 1) * Chunk, DrawCounts[Subpass]), &Recorded[Subpass][i] });
 			}
 		}
-		oModel = std::make_shared<cModel>(Meshes);
+		if (Tasks.empty())
+		{
+			return;
+		}
 
-		return true;
+		// 2. Record on the job system, every thread allocates from its own pool of the cache entry
+		JobSystem::ParallelFor(Tasks.size(), 1, [&](size_t Begin, size_t End)
+		{
+			const uint32_t ThreadIndex = JobSystem::GetThreadIndex();
+			for (size_t TaskIndex = Begin; TaskIndex < End; ++TaskIndex)
+			{
+				const FRecordTask& Task = Tasks[TaskIndex];
+				VkCommandBuffer SecondaryCB = beginSecondaryCommandBuffer(ThreadIndex, Task.Subpass);
+				switch (Task.Subpass)
+				{
+				case 0: recordModelDraws(SecondaryCB, CurrentFrame, Task.Begin, Task.End); break;
+				case 1: recordParticleDraws(SecondaryCB, CurrentFrame, Task.Begin, Task.End); break;
+				default: recordPostProcess(SecondaryCB); break;
+				}
+				VkResult Result = vkEndCommandBuffer(SecondaryCB);
+				RESULT_CHECK_ARGS(Result, "Fail to stop recording a secondary command buffer of subpass %d", Task.Subpass);
+				*Task.pOutput = SecondaryCB;
+			}
+		});
+
+		// 3. Keep them until the next structural change
+		for (uint32_t Subpass = 0; Subpass < SUBPASS_COUNT; ++Subpass)
+		{
+			if (RecordedCounts[Subpass] > 0)
+			{
+				SecondaryCaches[Subpass].EndRecord(SecondaryCacheEntries[Subpass], Recorded[Subpass], RecordedCounts[Subpass]);
+			}
+		}
+	}
+
+	VkCommandBuffer VKRenderer::beginSecondaryCommandBuffer(uint32_t ThreadIndex, uint32_t Subpass)
+	{
+		VkCommandBuffer SecondaryCB = SecondaryCaches[Subpass].Allocate(SecondaryCacheEntries[Subpass], ThreadIndex, VK_COMMAND_BUFFER_LEVEL_SECONDARY);
+
+		// Secondary command buffers inherit the render pass and subpass they are executed in,
+		// frame buffer is left unknown since a cached command buffer may be executed with any swap chain image
+		VkCommandBufferInheritanceInfo InheritanceInfo = {};
+		InheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+		InheritanceInfo.renderPass = RenderPass;
+		InheritanceInfo.subpass = Subpass;
+		InheritanceInfo.framebuffer = VK_NULL_HANDLE;
+
+		VkCommandBufferBeginInfo BeginInfo = {};
+		BeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		BeginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;		// Entirely inside a render pass, submitted many times
+		BeginInfo.pInheritanceInfo = &InheritanceInfo;
+
+		VkResult Result = vkBeginCommandBuffer(SecondaryCB, &BeginInfo);
+		RESULT_CHECK_ARGS(Result, "Fail to start recording a secondary command buffer of subpass %d", Subpass);
+		return SecondaryCB;
+	}
+
+	uint64_t VKRenderer::GetCommandRecordCount() const
+	{
+		uint64_t Count = 0;
+		for (const auto& Cache : SecondaryCaches)
+		{
+			Count += Cache.GetRecordCount();
+		}
+		return Count + (pCompute ? pCompute->CommandCache.GetRecordCount() : 0);
+	}
+
+	void VKRenderer::MarkCommandsDirty()
+	{
+		for (auto& Cache : SecondaryCaches)
+		{
+			Cache.Invalidate();
+		}
+		if (pCompute)
+		{
+			pCompute->CommandCache.Invalidate();
+		}
+	}
+
+	void VKRenderer::updateUploadedModels()
+	{
+		const uint64_t CompletedToken = UploadContext.GetCompletedToken();
+		if (CompletedToken == ReadyUploadToken)
+		{
+			return;
+		}
+		// Cached command buffers skip models that were not ready, re-record only when one of them is ready now
+		for (const auto& Model : RenderList)
+		{
+			if (Model->GetUploadToken() > ReadyUploadToken && Model->GetUploadToken() <= CompletedToken)
+			{
+				MarkCommandsDirty();
+				break;
+			}
+		}
+		ReadyUploadToken = CompletedToken;
+	}
+
+	bool VKRenderer::cullModels()
+	{
+		FrustumCuller.Clear();
+		CullCandidates.clear();
+		// Same interpolated matrices as the object table
+		const float Alpha = static_cast<float>(Time::SimulationClock.Alpha);
+		for (size_t j = 0; j < RenderList.size(); ++j)
+		{
+			// Still uploading, picked up by updateUploadedModels once its token is reached
+			if (RenderList[j]->GetUploadToken() > ReadyUploadToken)
+			{
+				continue;
+			}
+			const glm::mat4 ModelMatrix = RenderList[j]->Transform.Interpolate(Alpha);
+			for (size_t k = 0; k < RenderList[j]->GetMeshCount(); ++k)
+			{
+				const cMesh* Mesh = RenderList[j]->GetMesh(k).get();
+				FrustumCuller.Add(ModelMatrix, Mesh->GetBoundsCenter(), Mesh->GetBoundsExtent());
+				// The model matrix is looked up in the object table with the instance's object index
+				CullCandidates.push_back({ Mesh, static_cast<uint32_t>(Mesh->GetMaterialID()), static_cast<uint32_t>(j), 0.0f });
+			}
+		}
+		FrustumCuller.Cull(GetCurrentCamera()->GetFrameData().PVMatrix);
+		return FrustumCuller.GetVisible() != BatchedVisible;
+	}
+
+	void VKRenderer::buildInstanceBatches(int CurrentFrame)
+	{
+		// Only needed until the batcher has written the instance buffer, so the list lives in the frame arena
+		const std::vector<uint32_t>& Visible = FrustumCuller.GetVisible();
+		FInstanceDraw* Draws = FrameArena.AllocateArray<FInstanceDraw>(Visible.size());
+		// Draws of a batch are listed front to back for early-Z, the depth only has to keep the order so the distance stays squared
+		const glm::vec3 ViewPosition = GetCurrentCamera()->GetFrameData().GetViewPosition();
+		for (size_t i = 0; i < Visible.size(); ++i)
+		{
+			Draws[i] = CullCandidates[Visible[i]];
+			const glm::vec3 ToModel = RenderList[Draws[i].ObjectIndex]->Transform.Position() - ViewPosition;
+			Draws[i].Depth = glm::dot(ToModel, ToModel);
+		}
+		BatchedVisible = Visible;
+		InstanceBatcher.Build(static_cast<uint32_t>(CurrentFrame), Draws, Visible.size());
+		// Culling output has to fit the new batches before draws referencing it are recorded
+		GpuCulling.Prepare(static_cast<uint32_t>(CurrentFrame), InstanceBatcher);
+	}
+
+	void VKRenderer::recordModelDraws(VkCommandBuffer CB, int CurrentFrame, size_t Begin, size_t End)
+	{
+		// No state is inherited from the primary command buffer, bind pipeline per secondary command buffer
+		vkCmdBindPipeline(CB, VK_PIPELINE_BIND_POINT_GRAPHICS, GraphicPipeline);
+
+		// Frame data, texture table and object table stay bound for all draws, texture indices come with the instances
+		const VkDescriptorSet DescriptorSetGroup[] = { DescriptorSets[CurrentFrame].GetDescriptorSet(), TextureTable.GetDescriptorSet(), ObjectTable.GetDescriptorSet(CurrentFrame) };
+		vkCmdBindDescriptorSets(CB, VK_PIPELINE_BIND_POINT_GRAPHICS, PipelineLayout, 0, 3, DescriptorSetGroup, 0, nullptr);
+
+		// Visible instances, packed per batch by the culling pass, a batch's draw starts at its firstInstance
+		VkDeviceSize Offsets[] = { 0 };												// Offsets into buffers being bound
+		vkCmdBindVertexBuffers(CB, INSTANCE_BUFFER_BIND_ID, 1, &GpuCulling.GetVisibleInstanceBuffer(static_cast<uint32_t>(CurrentFrame)), Offsets);
+
+		// Batches are sorted by geometry arena block, every run of one block is drawn with one multi draw and
+		// binds its buffers only when the block differs from the previous run's,
+		// batch j reads draw j of the culling pass, instance counts of culled batches are zero
+		const std::vector<FDrawBatch>& Batches = InstanceBatcher.GetBatches(static_cast<uint32_t>(CurrentFrame));
+		const VkBuffer& DrawBuffer = GpuCulling.GetDrawBuffer(static_cast<uint32_t>(CurrentFrame));
+		uint32_t BoundBlock = FGeometryRange::INVALID_BLOCK;
+		uint32_t BindCount = 0;
+		size_t RunBegin = Begin;
+		while (RunBegin < End)
+		{
+			const uint32_t Block = Batches[RunBegin].Mesh->GetGeometry().Block;
+			size_t RunEnd = RunBegin + 1;
+			while (RunEnd < End && RunEnd - RunBegin < MAX_MULTI_DRAW_COUNT && Batches[RunEnd].Mesh->GetGeometry().Block == Block)
+			{
+				++RunEnd;
+			}
+
+			if (Block != BoundBlock)
+			{
+				// Bind vertex data, pulled from set 3 instead when the shader reads the vertices itself
+				if (USE_VERTEX_PULLING)
+				{
+					vkCmdBindDescriptorSets(CB, VK_PIPELINE_BIND_POINT_GRAPHICS, PipelineLayout, 3, 1, &GeometryArena.GetDescriptorSet(Block), 0, nullptr);
+				}
+				else
+				{
+					vkCmdBindVertexBuffers(CB, VERTEX_BUFFER_BIND_ID, 1, &GeometryArena.GetVertexBuffer(Block), Offsets);
+				}
+				// Only one index buffer is allowed, it holds the indices of every mesh in the block, uint32 type is more than enough for the index count
+				vkCmdBindIndexBuffer(CB, GeometryArena.GetIndexBuffer(Block), 0, VK_INDEX_TYPE_UINT32);
+				BoundBlock = Block;
+				BindCount += 2;
+			}
+
+			// Execute pipeline, the culled instanced index draws of the run
+			vkCmdDrawIndexedIndirect(CB, DrawBuffer, sizeof(VkDrawIndexedIndirectCommand) * RunBegin, static_cast<uint32_t>(RunEnd - RunBegin), sizeof(VkDrawIndexedIndirectCommand));
+			RunBegin = RunEnd;
+		}
+		// Binding the vertex and index buffer for every batch would take two binds each
+		ModelBindCount += BindCount;
+		SkippedModelBindCount += static_cast<uint32_t>(End - Begin) * 2 - BindCount;
+	}
+
+	void VKRenderer::recordParticleDraws(VkCommandBuffer CB, int CurrentFrame, size_t Begin, size_t End)
+	{
+		vkCmdBindPipeline(CB, VK_PIPELINE_BIND_POINT_GRAPHICS, RenderParticlePipeline);
+
+		std::shared_ptr<cMesh> QuadMesh = GQuadModel->GetMesh(0);
+		VkDeviceSize Offsets[] = { 0 };
+		// Bind vertex buffer, the quad is a range of its geometry arena block
+		vkCmdBindVertexBuffers(CB, VERTEX_BUFFER_BIND_ID, 1, &QuadMesh->GetVertexBuffer(), Offsets);
+		// Bind index buffer
+		vkCmdBindIndexBuffer(CB, QuadMesh->GetIndexBuffer(), 0, VK_INDEX_TYPE_UINT32);
+		// Same sets as the models, bound once for all emitters
+		const VkDescriptorSet DescriptorSetGroup[] = { DescriptorSets[CurrentFrame].GetDescriptorSet(), TextureTable.GetDescriptorSet(), ObjectTable.GetDescriptorSet(CurrentFrame) };
+		vkCmdBindDescriptorSets(CB, VK_PIPELINE_BIND_POINT_GRAPHICS, RenderParticlePipelineLayout, 0, 3, DescriptorSetGroup, 0, nullptr);
+		for (size_t i = Begin; i < End; ++i)
+		{
+			// Bind instance data buffer as a vertex buffer, the compute queue may be writing the other one meanwhile
+			vkCmdBindVertexBuffers(CB, INSTANCE_BUFFER_BIND_ID, 1, &pCompute->Emitters[i].GetStorageBuffer(pCompute->ReadBufferIndex).GetvkBuffer(), Offsets);
+
+			// Emitters are stored after all models in the object table
+			BufferFormats::FDrawConstants DrawConstants;
+			DrawConstants.ObjectIndex = static_cast<uint32_t>(RenderList.size() + i);
+			DrawConstants.TextureID = cMaterial::Get(pCompute->Emitters[i].MaterialID)->GetAlbedoTextureID();
+			vkCmdPushConstants(CB, RenderParticlePipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(DrawConstants), &DrawConstants);
+
+			// draw the quad with multiple instance
+			vkCmdDrawIndexed(CB, QuadMesh->GetIndexCount(), Particle_Count, QuadMesh->GetFirstIndex(), QuadMesh->GetVertexOffset(), 0);
+		}
+	}
+
+	void VKRenderer::recordPostProcess(VkCommandBuffer CB)
+	{
+		vkCmdBindPipeline(CB, VK_PIPELINE_BIND_POINT_GRAPHICS, PostProcessPipeline);
+
+		// No need to bind vertex buffer or index buffer
+		vkCmdBindDescriptorSets(CB, VK_PIPELINE_BIND_POINT_GRAPHICS, PostProcessPipelineLayout,
+			0, 1, &InputDescriptorSets[SwapChain.ImageIndex].GetDescriptorSet(),
+			0, nullptr);	// no dynamic offset
+		// Draw 3 vertex (1 triangle) only 
+		vkCmdDraw(CB, 3, 1, 0, 0);
 	}
 
 	void VKRenderer::recordCommands()
 	{
-		const uint32_t EmitterCount = pCompute->Emitters.size();
-		VkCommandBuffer& CB = CommandBuffers[SwapChain.ImageIndex];
+		const int CurrentFrame = ElapsedFrame % MAX_FRAME_DRAWS;
+		// Primary command buffer from this frame slot's transient pool, already in initial state
+		CommandBuffers[CurrentFrame] = CommandAllocator.Allocate(CurrentFrame);
+		VkCommandBuffer& CB = CommandBuffers[CurrentFrame];
 		// Begin info can be the same
 		VkCommandBufferBeginInfo BufferBeginInfo = {};
 		BufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-		//BufferBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;		// Buffer can be resubmitted when it has already been submitted and is awaiting execution.
+		BufferBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;		// Recorded every frame, submitted once before its pool is reset
 
 		// Information about how to begin a render pass (only needed for graphical applications)
 		VkRenderPassBeginInfo RenderPassBeginInfo = {};
@@ -1621,181 +2230,63 @@ namespace VKE
 
 		// Start recording commands to command buffer
 		VkResult Result = vkBeginCommandBuffer(CB, &BufferBeginInfo);
-		RESULT_CHECK_ARGS(Result, "Fail to start recording a command buffer[%d]", SwapChain.ImageIndex);
+		RESULT_CHECK_ARGS(Result, "Fail to start recording a command buffer[%d]", CurrentFrame);
 
 		/** Record part */
-		// Acquire barrier
-		if (pCompute->needSynchronization())
-		{
-			std::vector<VkBufferMemoryBarrier> BufferBarriers(EmitterCount);
-			
-			// Let graphic queue own the buffers
-			for (uint32_t i = 0; i < EmitterCount; ++i)
-			{
-				BufferBarriers[i] = pCompute->Emitters[i].GraphicOwnBarrier(0, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT);
-			}
-
-			// Block the vertex input stage until compute shader has finished
-			vkCmdPipelineBarrier(CB,
-				VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-				VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
-				0,										// No Dependency flag
-				0, nullptr,								// Not a Memory barrier
-				EmitterCount, BufferBarriers.data(),	// A Buffer memory Barrier
-				0, nullptr);							// Not a Image memory barrier
-		}
+		// No acquire barrier for particle buffers, they are shared concurrently with the compute queue family
 
-		// Begin first Render Pass
-		vkCmdBeginRenderPass(CB, &RenderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+		// Draw calls live in cached secondary command buffers, out of date ones are recorded in parallel; the primary one only executes them in subpass order
+		recordSecondaryCommands(CurrentFrame);
 
-		// Start the first sub-pass
-		// Bind Pipeline to be used in render pass
-		vkCmdBindPipeline(CB, VK_PIPELINE_BIND_POINT_GRAPHICS, GraphicPipeline);
+		// Cull this frame's model instances with this frame's camera, the cached model draws read the result indirectly
+		GpuCulling.Record(CB, static_cast<uint32_t>(CurrentFrame), GetCurrentCamera()->GetFrameData().PVMatrix, ObjectTable.GetDescriptorSet(CurrentFrame));
 
-		// Draw all models in the render list
-		for (size_t j = 0; j < RenderList.size(); ++j)
+		// Begin first Render Pass
+		vkCmdBeginRenderPass(CB, &RenderPassBeginInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+		for (uint32_t Subpass = 0; Subpass < SUBPASS_COUNT; ++Subpass)
 		{
-
-			// Push constant to given shader stage directly (No Buffer)
-			glm::mat4 MVP = GetCurrentCamera()->GetFrameData().PVMatrix * RenderList[j]->Transform.M();
-			vkCmdPushConstants(CB, PipelineLayout, VK_SHADER_STAGE_VERTEX_BIT,
-				0,
-				sizeof(glm::mat4),					// Size of data being pushed
-				&MVP);								// Actual data being pushed
-
-			// Draw all meshes in one model
-			for (size_t k = 0; k < RenderList[j]->GetMeshCount(); ++k)
+			if (Subpass > 0)
 			{
-				auto Mesh = RenderList[j]->GetMesh(k);
-				VkBuffer VertexBuffers[] = { Mesh->GetVertexBuffer() };			// Buffers to bind
-				VkDeviceSize Offsets[] = { 0 };												// Offsets into buffers being bound
-
-				// Bind vertex data
-				vkCmdBindVertexBuffers(CB, VERTEX_BUFFER_BIND_ID, 1, VertexBuffers, Offsets);	// Command to bind vertex buffer for drawing with
-
-				// Only one index buffer is allowed, it handles all vertex buffer's index, uint32 type is more than enough for the index count
-				vkCmdBindIndexBuffer(CB, Mesh->GetIndexBuffer(), 0, VK_INDEX_TYPE_UINT32);
-
-				// Dynamic Offset Amount
-				uint32_t DynamicOffset = static_cast<uint32_t>(DescriptorSets[SwapChain.ImageIndex].GetDescriptorAt<cDescriptor_DynamicBuffer>(1)->GetSlotSize()) * j;
-
-				const uint32_t DescriptorSetCount = 2;
-				// Two descriptor sets
-				VkDescriptorSet DescriptorSetGroup[] = { DescriptorSets[SwapChain.ImageIndex].GetDescriptorSet(), Mesh->GetDescriptorSet() };
-
-				// Bind Descriptor sets for Projection / View / Model matrix
-				vkCmdBindDescriptorSets(CB, VK_PIPELINE_BIND_POINT_GRAPHICS, PipelineLayout,
-					0, DescriptorSetCount,						// One descriptor for each draw
-					DescriptorSetGroup,
-					1, &DynamicOffset							// Dynamic offsets
-				);
-				/*
-				vkCmdDraw(CB[i],
-					Mesh->GetVertexCount(),	// vertexCount, indicates how many times the pipeline will call
-					1,						// For drawing same object multiple times
-					0, 0);*/
-
-					// Execute pipeline, Index draw
-				vkCmdDrawIndexed(CB, Mesh->GetIndexCount(), 1, 0, 0, 0);
+				vkCmdNextSubpass(CB, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
 			}
-
-		}
-		// Start the second sub-pass
-		{
-			vkCmdNextSubpass(CB, VK_SUBPASS_CONTENTS_INLINE);
-			vkCmdBindPipeline(CB, VK_PIPELINE_BIND_POINT_GRAPHICS, RenderParticlePipeline);
-
-			std::shared_ptr<cMesh> QuadMesh = GQuadModel->GetMesh(0);
-			VkDeviceSize Offsets[] = { 0 };
-			// Bind vertex buffer
-			vkCmdBindVertexBuffers(CB, VERTEX_BUFFER_BIND_ID, 1, &QuadMesh->GetVertexBuffer(), Offsets);
-			// Bind index buffer
-			vkCmdBindIndexBuffer(CB, QuadMesh->GetIndexBuffer(), 0, VK_INDEX_TYPE_UINT32);
-			for (size_t i = 0; i < EmitterCount; ++i)
+			const std::vector<VkCommandBuffer>& Secondaries = SecondaryCaches[Subpass].Get(SecondaryCacheEntries[Subpass]);
+			if (Secondaries.size() > 0)
 			{
-				// Update descriptor data
-				pCompute->Emitters[i].ComputeDescriptorSet.GetDescriptorAt<cDescriptor_Buffer>(1)->UpdateBufferData(&pCompute->Emitters[i].ParticleSupportData);
-
-				// Bind instance data buffer as a vertex buffer
-				vkCmdBindVertexBuffers(CB, INSTANCE_BUFFER_BIND_ID, 1, &pCompute->Emitters[i].GetStorageBuffer().GetvkBuffer(), Offsets);
-
-				// Particle is drawn after all Model, so the offset should be RenderList.size() * Length
-				uint32_t ParticleDynamicOffset = static_cast<uint32_t>(DescriptorSets[SwapChain.ImageIndex].GetDescriptorAt<cDescriptor_DynamicBuffer>(1)->GetSlotSize()) * (RenderList.size() + i);
-
-				const uint32_t DescriptorSetCount = 2;
-				// Two descriptor sets
-				VkDescriptorSet DescriptorSetGroup[] = { DescriptorSets[SwapChain.ImageIndex].GetDescriptorSet(), pCompute->Emitters[i].RenderDescriptorSet.GetDescriptorSet() };
-	
-				vkCmdBindDescriptorSets(CB, VK_PIPELINE_BIND_POINT_GRAPHICS, RenderParticlePipelineLayout,
-					0, DescriptorSetCount, DescriptorSetGroup,
-					1, &ParticleDynamicOffset);
-
-				// draw the quad with multiple instance
-				vkCmdDrawIndexed(CB, QuadMesh->GetIndexCount(), Particle_Count, 0, 0, 0);
+				vkCmdExecuteCommands(CB, static_cast<uint32_t>(Secondaries.size()), Secondaries.data());
 			}
 		}
-		// Start the third sub-pass
-		{
-			vkCmdNextSubpass(CB, VK_SUBPASS_CONTENTS_INLINE);
-			vkCmdBindPipeline(CB, VK_PIPELINE_BIND_POINT_GRAPHICS, PostProcessPipeline);
-
-			// No need to bind vertex buffer or index buffer
-			vkCmdBindDescriptorSets(CB, VK_PIPELINE_BIND_POINT_GRAPHICS, PostProcessPipelineLayout,
-				0, 1, &InputDescriptorSets[SwapChain.ImageIndex].GetDescriptorSet(),
-				0, nullptr);	// no dynamic offset
-			// Draw 3 vertex (1 triangle) only 
-			vkCmdDraw(CB, 3, 1, 0, 0);
-		}
 		// End Render Pass
 		vkCmdEndRenderPass(CB);
 		
-		// Begin second (imgui) render pass
-		// Rendering
-		ImGui::Render();
-		ImDrawData* draw_data = ImGui::GetDrawData();
-		ImGui_ImplVulkanH_Window* wd = Editor::GetMainWindowData();
-		wd->FrameIndex = SwapChain.ImageIndex;
-		ImGui_ImplVulkanH_Frame* fd = &wd->Frames[wd->FrameIndex];
-		{
-			VkRenderPassBeginInfo info = {};
-			info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-			info.renderPass = wd->RenderPass;
-			info.framebuffer = fd->Framebuffer;
-			info.renderArea.extent.width = wd->Width;
-			info.renderArea.extent.height = wd->Height;
-			info.clearValueCount = 1;
-			info.pClearValues = &wd->ClearValue;
-			vkCmdBeginRenderPass(fd->CommandBuffer, &info, VK_SUBPASS_CONTENTS_INLINE);
-		}
-
-		// Record dear imgui primitives into command buffer
-		ImGui_ImplVulkan_RenderDrawData(draw_data, fd->CommandBuffer);
-		// End imgui render pass
-		vkCmdEndRenderPass(fd->CommandBuffer);
-
-		// Release barrier
-		if (pCompute->needSynchronization())
-		{
-			std::vector<VkBufferMemoryBarrier> BufferBarriers(EmitterCount);
-
-			// Let compute queue own the buffers
-			for (uint32_t i = 0; i < EmitterCount; ++i)
+		// Begin second (imgui) render pass, there is no editor in headless mode
+		if (!bHeadless)
+		{
+			// Rendering
+			ImGui::Render();
+			ImDrawData* draw_data = ImGui::GetDrawData();
+			ImGui_ImplVulkanH_Window* wd = Editor::GetMainWindowData();
+			wd->FrameIndex = SwapChain.ImageIndex;
+			ImGui_ImplVulkanH_Frame* fd = &wd->Frames[wd->FrameIndex];
 			{
-				BufferBarriers[i] = pCompute->Emitters[i].ComputeOwnBarrier(VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT, 0);
+				VkRenderPassBeginInfo info = {};
+				info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+				info.renderPass = wd->RenderPass;
+				info.framebuffer = fd->Framebuffer;
+				info.renderArea.extent.width = wd->Width;
+				info.renderArea.extent.height = wd->Height;
+				info.clearValueCount = 1;
+				info.pClearValues = &wd->ClearValue;
+				vkCmdBeginRenderPass(CB, &info, VK_SUBPASS_CONTENTS_INLINE);
 			}
 
-			// Block the compute shader until vertex shader finished reading the storage buffer
-			vkCmdPipelineBarrier(CB,
-				VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
-				VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-				0,										// No Dependency flag
-				0, nullptr,								// Not a Memory barrier
-				EmitterCount, BufferBarriers.data(),	// A Buffer memory Barrier
-				0, nullptr);							// Not a Image memory barrier
+			// Record dear imgui primitives into this frame slot's command buffer, frame buffer still belongs to the swap chain image
+			ImGui_ImplVulkan_RenderDrawData(draw_data, CB);
+			// End imgui render pass
+			vkCmdEndRenderPass(CB);
 		}
 
 		Result = vkEndCommandBuffer(CB);
-		RESULT_CHECK_ARGS(Result, "Fail to stop recording a command buffer[%d]", SwapChain.ImageIndex);
+		RESULT_CHECK_ARGS(Result, "Fail to stop recording a command buffer[%d]", CurrentFrame);
 	}
 
 
@@ -1819,7 +2310,10 @@ namespace VKE
 					MainDevice.QueueFamilyIndices.graphicFamily = i;
 				}
 				VkBool32 presentationSuppot = false;
-				vkGetPhysicalDeviceSurfaceSupportKHR(device, i, Surface, &presentationSuppot);
+				if (!bHeadless)
+				{
+					vkGetPhysicalDeviceSurfaceSupportKHR(device, i, Surface, &presentationSuppot);
+				}
 				// Check if queue is presentation type (can be both graphics and presentations)
 				if (presentationSuppot && MainDevice.QueueFamilyIndices.presentationFamily == -1)
 				{
@@ -1831,10 +2325,34 @@ namespace VKE
 				{
 					MainDevice.QueueFamilyIndices.computeFamily = i;
 				}
+
+				// Transfer only family (usually the DMA engines), uploads there run alongside rendering
+				if ((queueFamily.queueFlags & VK_QUEUE_TRANSFER_BIT) && (queueFamily.queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)) == 0 && MainDevice.QueueFamilyIndices.transferFamily == -1)
+				{
+					MainDevice.QueueFamilyIndices.transferFamily = i;
+				}
 			}
 			++i;
 		}
 
+		// Nothing is presented in headless mode, let the presentation family alias the graphic family
+		if (bHeadless && MainDevice.QueueFamilyIndices.presentationFamily == -1)
+		{
+			MainDevice.QueueFamilyIndices.presentationFamily = MainDevice.QueueFamilyIndices.graphicFamily;
+		}
+
+		// No dedicated compute family, dispatch on the graphic family instead (a graphic family always supports compute)
+		if (MainDevice.QueueFamilyIndices.computeFamily == -1 && MainDevice.QueueFamilyIndices.graphicFamily != -1)
+		{
+			MainDevice.QueueFamilyIndices.computeFamily = MainDevice.QueueFamilyIndices.graphicFamily;
+		}
+
+		// No transfer only family, upload on the graphic family (it always supports transfer)
+		if (MainDevice.QueueFamilyIndices.transferFamily == -1)
+		{
+			MainDevice.QueueFamilyIndices.transferFamily = MainDevice.QueueFamilyIndices.graphicFamily;
+		}
+
 	}
 
 	void VKRenderer::getSwapChainDetail(const VkPhysicalDevice& device)
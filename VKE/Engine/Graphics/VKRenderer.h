@@ -10,8 +10,20 @@
 #include "Descriptors/DescriptorSet.h"
 #include "Mesh/Mesh.h"
 #include "Buffer/ImageBuffer.h"
+#include "Command/CommandAllocator.h"
+#include "Command/FrameScheduler.h"
+#include "Command/CommandCache.h"
+#include "Command/UploadContext.h"
+#include "Scene/ObjectTable.h"
+#include "Scene/InstanceBatcher.h"
+#include "Scene/FrustumCuller.h"
+#include "Scene/GpuCulling.h"
+#include "Descriptors/DescriptorAllocator.h"
+#include "Texture/TextureTable.h"
+#include "Texture/SamplerCache.h"
 
 #include <vector>
+#include <atomic>
 namespace VKE
 {
 	class cModel;
@@ -25,7 +37,13 @@ namespace VKE
 		VKRenderer(const VKRenderer& other) = delete;
 		VKRenderer& operator =(const VKRenderer& other) = delete;
 
+		// Pass a null window to render headless into offscreen targets, no surface or swap chain is created
 		int init(GLFWwindow* iWindow);
+		// Present mode to use when the surface supports it, FIFO otherwise; set before init
+		void SetPreferredPresentMode(EPresentMode iMode);
+		// Advance the simulation by one fixed step, runs 0..N times per rendered frame
+		void fixedTick(float FixedDT);
+		// Once per rendered frame after the fixed steps
 		void tick(float dt);
 		void draw();
 		void cleanUp();
@@ -33,6 +51,9 @@ namespace VKE
 		void LoadAssets();
 
 		bool CreateModel(const std::string& ifileName, std::shared_ptr<cModel>& oModel);
+		// Re-record cached command buffers before the next use, call after changing meshes / descriptor sets of objects in the render list
+		// Changing the number of models or emitters is detected automatically
+		void MarkCommandsDirty();
 		// Scene Objects
 		std::vector<std::shared_ptr<cModel>> RenderList;
 	
@@ -49,8 +70,23 @@ namespace VKE
 		ACCESSOR_INLINE(std::vector<VkCommandBuffer>, CommandBuffers);
 		ACCESSOR_INLINE(std::vector<VkSemaphore>, OnImageAvailables);
 		ACCESSOR_INLINE(std::vector <VkSemaphore>, OnRenderFinisheds);
-		ACCESSOR_INLINE(std::vector<VkFence>, DrawFences);
 		ACCESSOR_INLINE(std::vector <cImageBuffer>, ColorBuffers);
+		ACCESSOR_INLINE(std::vector <cImageBuffer>, OffscreenTargets);
+		ACCESSOR_INLINE(VkPresentModeKHR, PresentMode);
+		ACCESSOR_INLINE(cObjectTable, ObjectTable);
+		ACCESSOR_INLINE(cInstanceBatcher, InstanceBatcher);
+		ACCESSOR_INLINE(cGpuCulling, GpuCulling);
+		ACCESSOR_INLINE(cFrustumCuller, FrustumCuller);
+		ACCESSOR_INLINE(cFrameArena, FrameArena);
+		ACCESSOR_INLINE(cDescriptorAllocator, DescriptorAllocator);
+		ACCESSOR_INLINE(cTextureTable, TextureTable);
+		ACCESSOR_INLINE(cSamplerCache, SamplerCache);
+		ACCESSOR_INLINE(cGeometryArena, GeometryArena);
+		uint64_t GetCommandRecordCount() const;
+		// Vertex / index buffer binds of the last recorded model draws, and the ones a bind per batch would have issued on top
+		uint32_t GetModelBindCount() const { return ModelBindCount; }
+		uint32_t GetSkippedModelBindCount() const { return SkippedModelBindCount; }
+		bool IsHeadless() const { return bHeadless; }
 
 		// Compute pass
 		FComputePass* pCompute = nullptr;
@@ -64,14 +100,40 @@ namespace VKE
 		// Vulkan Components
 		// - Main Components
 		FMainDevice MainDevice;
+		cMemoryAllocator MemoryAllocator;								// Owned here, reached through MainDevice.MemoryAllocator
+		cUploadContext UploadContext;									// Owned here, reached through MainDevice.UploadContext
+		cDescriptorAllocator DescriptorAllocator;						// Owned here, reached through MainDevice.DescriptorAllocator
+		cTextureTable TextureTable;										// Owned here, reached through MainDevice.TextureTable, set 1 of the model and particle pipelines
+		cSamplerCache SamplerCache;										// Owned here, reached through MainDevice.SamplerCache
+		cGeometryArena GeometryArena;									// Owned here, reached through MainDevice.GeometryArena, set 3 of the model pipeline
+		uint64_t ReadyUploadToken = 0;									// Latest upload token seen reached, models with a later token are not drawn yet
+		cObjectTable ObjectTable;										// Models first, then emitters, indexed by the instance's / pushed object index
+		cInstanceBatcher InstanceBatcher;								// Model meshes grouped into instanced draws, per frame slot
+		cGpuCulling GpuCulling;											// Frustum culls the batches' instances into indirect draws, per frame slot
+		cFrustumCuller FrustumCuller;									// World bounds of the ready models' meshes against the camera, every frame
+		std::vector<FInstanceDraw> CullCandidates;						// Draw of every box in the frustum culler
+		std::vector<uint32_t> BatchedVisible;							// Visible boxes the cached batches were built from
 		VkInstance vkInstance;
-		VkSurfaceKHR Surface;								// KHR extension required
+		VkSurfaceKHR Surface = VK_NULL_HANDLE;				// KHR extension required, stays null in headless mode
 
-		// SwapChainImages, SwapChainFramebuffers, CommandBuffers are all 1 to 1 correspondent
+		// SwapChainImages, SwapChainFramebuffers, Depth / Color buffers are all 1 to 1 correspondent
 		FSwapChainDetail SwapChainDetail;
 		FSwapChainData SwapChain;							// SwapChain data group
+		VkPresentModeKHR PresentMode = VK_PRESENT_MODE_FIFO_KHR;	// Present mode of the current swap chain
 		std::vector<VkFramebuffer> SwapChainFramebuffers;
-		std::vector<VkCommandBuffer> CommandBuffers;
+		std::vector <cImageBuffer> OffscreenTargets;		// Headless mode only, stand in for swap chain images
+		// CommandBuffers, synchronization objects and DescriptorSets are 1 to 1 correspondent to frames in flight (MAX_FRAME_DRAWS)
+		cCommandAllocator CommandAllocator;								// Transient command pools per frame slot
+		cFrameArena FrameArena;											// Transient CPU allocations per frame slot, rewound with the command pools
+		std::vector<VkCommandBuffer> CommandBuffers;						// Primary command buffer recorded for each frame slot
+		// Secondary command buffers per subpass, recorded once and executed in order by the primary command buffer every frame
+		static const uint32_t SUBPASS_COUNT = 3;
+		cCommandCache SecondaryCaches[SUBPASS_COUNT];
+		uint32_t SecondaryCacheEntries[SUBPASS_COUNT] = {};				// Cache entry of each subpass used by the current frame
+		size_t CachedModelCount = 0;
+		size_t CachedEmitterCount = 0;
+		std::atomic<uint32_t> ModelBindCount{ 0 };						// Summed by the recording jobs
+		std::atomic<uint32_t> SkippedModelBindCount{ 0 };
 
 		std::vector <cImageBuffer> DepthBuffers;
 		std::vector <cImageBuffer> ColorBuffers;			
@@ -93,26 +155,27 @@ namespace VKE
 		VkPipelineLayout PostProcessPipelineLayout;
 
 		// -Synchronization
-		std::vector<VkSemaphore> OnGraphicFinished;						// Used for graphic/compute sync
+		cFrameScheduler FrameScheduler;									// Timeline semaphores for graphic / compute / transfer queues, replaces fences
 		std::vector<VkSemaphore> OnImageAvailables;						// If this image is locked by other usage
 		std::vector <VkSemaphore> OnRenderFinisheds;					// If this image finishes rendering
-		std::vector<VkFence> DrawFences;								// Fence allow to block the program by ourself
+		std::vector<uint64_t> ImageGraphicsValues;						// Graphics timeline value of the last frame rendering to each swap chain image
 
 		// - Descriptors
 		// First pass
-		VkDescriptorPool DescriptorPool;
-		std::vector<cDescriptorSet> DescriptorSets;
+		VkDescriptorPool DescriptorPool;							// imgui only, every engine set comes from DescriptorAllocator
+		std::vector<cDescriptorSet> DescriptorSets;					// Per frame slot, frame and draw call uniform data
 
 		// -- Push Constant
 		VkPushConstantRange PushConstantRange;
-		// -- Sampler Descriptor Set
-		VkDescriptorPool SamplerDescriptorPool;
 
 		// -- Input Descriptor Set
 		// Third pass
 		std::vector<cDescriptorSet> InputDescriptorSets;
 
 		bool bMinimizing = false;
+		bool bHeadless = false;											// No window, nothing is presented
+		float FrameSimulatedTime = 0.0f;								// Time simulated by the fixed steps of the current frame
+		double FenceWaitTime = 0.0;										// Seconds blocked on the current frame slot's fences
 
 		/** Create functions */
 		void createInstance();
@@ -121,6 +184,7 @@ namespace VKE
 
 		void createSurface();
 		void createSwapChain();
+		void createOffscreenTargets();
 		void createRenderPass();
 
 		void CreateDescriptorSets();
@@ -141,7 +205,20 @@ namespace VKE
 		/** intermediate functions */
 		VkResult prepareForDraw();
 		void recordCommands();
+		// Record draws of all subpasses into secondary command buffers on the worker threads
+		void recordSecondaryCommands(int CurrentFrame);
+		VkCommandBuffer beginSecondaryCommandBuffer(uint32_t ThreadIndex, uint32_t Subpass);
+		// Test the meshes of every ready model against the camera, true when the visible set differs from the batched one
+		bool cullModels();
+		// Group the visible meshes by mesh and material, when the frame slot's model draws are recorded again
+		void buildInstanceBatches(int CurrentFrame);
+		// Begin / End are batches of the frame slot
+		void recordModelDraws(VkCommandBuffer CB, int CurrentFrame, size_t Begin, size_t End);
+		void recordParticleDraws(VkCommandBuffer CB, int CurrentFrame, size_t Begin, size_t End);
+		void recordPostProcess(VkCommandBuffer CB);
 		void updateUniformBuffers();
+		// Models of the render list whose uploads have completed become drawable
+		void updateUploadedModels();
 		VkResult presentFrame();
 		void postPresentationStage();
 		/** Support functions */
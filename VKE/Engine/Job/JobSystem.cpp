@@ -0,0 +1,287 @@
+#include "JobSystem.h"
+
+#include <thread>
+#include <condition_variable>
+#include <memory>
+#include <stdio.h>
+#include "assert.h"
+
+namespace VKE
+{
+	namespace JobSystem
+	{
+		//=================== Parameters ===================
+		const uint32_t JOB_QUEUE_CAPACITY = 1024;				// Power of two, jobs of one thread waiting to run
+		struct FJobQueue
+		{
+			std::mutex Mutex;
+			FJob Jobs[JOB_QUEUE_CAPACITY];
+			uint32_t Front = 0;									// Oldest job, both only grow and wrap through the mask
+			uint32_t Back = 0;									// One past the newest job
+
+			bool IsEmpty() const { return Front == Back; }
+			bool IsFull() const { return Back - Front == JOB_QUEUE_CAPACITY; }
+			FJob& At(uint32_t Index) { return Jobs[Index & (JOB_QUEUE_CAPACITY - 1)]; }
+		};
+
+		std::vector<std::unique_ptr<FJobQueue>> g_Queues;		// One per thread, index 0 belongs to the main thread
+		std::vector<std::thread> g_Workers;
+		std::atomic<uint32_t> g_QueuedJobs{ 0 };				// Jobs sitting in any ring, workers sleep when it is zero
+		std::mutex g_SleepMutex;
+		std::condition_variable g_WakeUp;
+		bool g_bQuit = false;
+		thread_local uint32_t t_ThreadIndex = 0;
+
+		//=================== Function declarations ===================
+		void workerLoop(uint32_t ThreadIndex);
+		void push(const FJob& Job);
+		bool tryGetJob(uint32_t ThreadIndex, FJob& oJob);
+		void execute(FJob& Job);
+
+		void Init(uint32_t iWorkerCount)
+		{
+			assert(g_Workers.empty());
+			if (iWorkerCount == 0)
+			{
+				const uint32_t HardwareThreads = std::thread::hardware_concurrency();
+				iWorkerCount = HardwareThreads > 1 ? HardwareThreads - 1 : 1;
+			}
+			g_bQuit = false;
+			g_Queues.clear();
+			for (uint32_t i = 0; i < iWorkerCount + 1; ++i)
+			{
+				g_Queues.push_back(std::make_unique<FJobQueue>());
+			}
+			for (uint32_t i = 0; i < iWorkerCount; ++i)
+			{
+				g_Workers.emplace_back(workerLoop, i + 1);
+			}
+			printf("Job system started with %d workers\n", iWorkerCount);
+		}
+
+		void CleanUp()
+		{
+			{
+				std::lock_guard<std::mutex> Lock(g_SleepMutex);
+				g_bQuit = true;
+			}
+			g_WakeUp.notify_all();
+			for (auto& Worker : g_Workers)
+			{
+				Worker.join();
+			}
+			g_Workers.clear();
+			g_Queues.clear();
+		}
+
+		uint32_t GetThreadCount()
+		{
+			return static_cast<uint32_t>(g_Workers.size()) + 1;
+		}
+
+		uint32_t GetThreadIndex()
+		{
+			return t_ThreadIndex;
+		}
+
+		void Run(FJobFunction Function, void* pData, size_t Begin, size_t End, FCounter* pCounter)
+		{
+			if (pCounter)
+			{
+				pCounter->Pending.fetch_add(1);
+			}
+			FJob NewJob;
+			NewJob.Function = Function;
+			NewJob.pData = pData;
+			NewJob.Begin = Begin;
+			NewJob.End = End;
+			NewJob.pCounter = pCounter;
+			// Not initialized, nobody would pick it up
+			if (g_Queues.empty())
+			{
+				execute(NewJob);
+				return;
+			}
+			push(NewJob);
+		}
+
+		void RunAfter(FCounter& Dependency, FJobFunction Function, void* pData, size_t Begin, size_t End, FCounter* pCounter)
+		{
+			if (pCounter)
+			{
+				pCounter->Pending.fetch_add(1);
+			}
+			FJob NewJob;
+			NewJob.Function = Function;
+			NewJob.pData = pData;
+			NewJob.Begin = Begin;
+			NewJob.End = End;
+			NewJob.pCounter = pCounter;
+			{
+				std::lock_guard<std::mutex> Lock(Dependency.Mutex);
+				// Zero is only reached while holding the mutex, so the dependency can't finish between this check and push_back
+				if (Dependency.Pending.load() > 0)
+				{
+					Dependency.Continuations.push_back(NewJob);
+					return;
+				}
+			}
+			if (g_Queues.empty())
+			{
+				execute(NewJob);
+				return;
+			}
+			push(NewJob);
+		}
+
+		void Wait(FCounter& Counter)
+		{
+			const uint32_t ThreadIndex = t_ThreadIndex;
+			while (Counter.Pending.load() > 0)
+			{
+				FJob Job;
+				if (!g_Queues.empty() && tryGetJob(ThreadIndex, Job))
+				{
+					execute(Job);
+				}
+				else
+				{
+					std::this_thread::yield();
+				}
+			}
+			// The thread that took the counter to zero may still hold the mutex, let it leave before the counter can be destroyed
+			std::lock_guard<std::mutex> Lock(Counter.Mutex);
+		}
+
+		void ParallelFor(size_t Count, size_t MinBatchSize, FJobFunction Function, void* pData)
+		{
+			if (Count == 0)
+			{
+				return;
+			}
+			MinBatchSize = MinBatchSize > 0 ? MinBatchSize : 1;
+			// A few batches per thread so stealing can balance uneven ranges
+			const size_t TargetBatchCount = static_cast<size_t>(GetThreadCount()) * 4;
+			size_t BatchSize = (Count + TargetBatchCount - 1) / TargetBatchCount;
+			BatchSize = BatchSize > MinBatchSize ? BatchSize : MinBatchSize;
+			if (BatchSize >= Count || GetThreadCount() == 1)
+			{
+				Function(pData, 0, Count);
+				return;
+			}
+
+			FCounter Counter;
+			for (size_t Begin = BatchSize; Begin < Count; Begin += BatchSize)
+			{
+				const size_t End = Begin + BatchSize < Count ? Begin + BatchSize : Count;
+				Run(Function, pData, Begin, End, &Counter);
+			}
+			// First range on the calling thread
+			Function(pData, 0, BatchSize);
+			Wait(Counter);
+		}
+
+		void push(const FJob& Job)
+		{
+			FJobQueue& Queue = *g_Queues[t_ThreadIndex < g_Queues.size() ? t_ThreadIndex : 0];
+			{
+				std::unique_lock<std::mutex> Lock(Queue.Mutex);
+				// No room, run it here rather than grow the ring
+				if (Queue.IsFull())
+				{
+					Lock.unlock();
+					FJob InlineJob = Job;
+					execute(InlineJob);
+					return;
+				}
+				Queue.At(Queue.Back++) = Job;
+			}
+			g_QueuedJobs.fetch_add(1);
+			// Touch the sleep mutex so a worker between its check and wait() can't miss the notification
+			{
+				std::lock_guard<std::mutex> Lock(g_SleepMutex);
+			}
+			g_WakeUp.notify_one();
+		}
+
+		bool tryGetJob(uint32_t ThreadIndex, FJob& oJob)
+		{
+			const uint32_t QueueCount = static_cast<uint32_t>(g_Queues.size());
+			// 1. Own ring, newest first, its data is most likely still in cache
+			{
+				FJobQueue& Queue = *g_Queues[ThreadIndex];
+				std::lock_guard<std::mutex> Lock(Queue.Mutex);
+				if (!Queue.IsEmpty())
+				{
+					oJob = Queue.At(--Queue.Back);
+					g_QueuedJobs.fetch_sub(1);
+					return true;
+				}
+			}
+			// 2. Steal the oldest job of another thread, usually the largest remaining piece of work
+			for (uint32_t i = 1; i < QueueCount; ++i)
+			{
+				FJobQueue& Victim = *g_Queues[(ThreadIndex + i) % QueueCount];
+				std::lock_guard<std::mutex> Lock(Victim.Mutex);
+				if (!Victim.IsEmpty())
+				{
+					oJob = Victim.At(Victim.Front++);
+					g_QueuedJobs.fetch_sub(1);
+					return true;
+				}
+			}
+			return false;
+		}
+
+		void execute(FJob& Job)
+		{
+			Job.Function(Job.pData, Job.Begin, Job.End);
+			FCounter* pCounter = Job.pCounter;
+			if (!pCounter)
+			{
+				return;
+			}
+			std::vector<FJob> ReadyJobs;
+			{
+				std::lock_guard<std::mutex> Lock(pCounter->Mutex);
+				if (pCounter->Pending.fetch_sub(1) == 1)
+				{
+					ReadyJobs.swap(pCounter->Continuations);
+				}
+			}
+			// pCounter may be gone from here on
+			for (FJob& Ready : ReadyJobs)
+			{
+				if (g_Queues.empty())
+				{
+					execute(Ready);
+				}
+				else
+				{
+					push(Ready);
+				}
+			}
+		}
+
+		void workerLoop(uint32_t ThreadIndex)
+		{
+			t_ThreadIndex = ThreadIndex;
+			while (true)
+			{
+				FJob Job;
+				if (tryGetJob(ThreadIndex, Job))
+				{
+					execute(Job);
+					continue;
+				}
+
+				std::unique_lock<std::mutex> Lock(g_SleepMutex);
+				g_WakeUp.wait(Lock, []() { return g_bQuit || g_QueuedJobs.load() > 0; });
+				if (g_bQuit)
+				{
+					return;
+				}
+			}
+		}
+	}
+}
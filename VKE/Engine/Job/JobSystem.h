@@ -0,0 +1,79 @@
+/*
+	JobSystem runs small jobs on a fixed set of worker threads
+	Every thread (main thread included) owns a fixed-capacity ring of jobs, a thread pushes and pops its own jobs at the back,
+	idle threads steal the oldest jobs from the front of other rings
+	A job is a function pointer, a context pointer and a range, queuing one never allocates; the context must outlive the job
+	Counters track unfinished jobs: a thread can wait for a counter (running other jobs meanwhile) or schedule a job to start once it reaches zero
+	Thread index 0 is the main thread, workers are 1..WorkerCount, per-thread resources (e.g. command pools) can be indexed by GetThreadIndex()
+*/
+#pragma once
+
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <stdint.h>
+#include <stddef.h>
+namespace VKE
+{
+	namespace JobSystem
+	{
+		typedef void(*FJobFunction)(void* pData, size_t Begin, size_t End);
+		struct FCounter;
+
+		struct FJob
+		{
+			FJobFunction Function = nullptr;
+			void* pData = nullptr;							// Owned by the caller
+			size_t Begin = 0;
+			size_t End = 0;
+			FCounter* pCounter = nullptr;					// Decreased when the job has finished
+		};
+
+		// Number of unfinished jobs of a batch, do not destroy it before it reaches zero
+		struct FCounter
+		{
+			FCounter() {}
+			FCounter(const FCounter& i_other) = delete;
+			FCounter& operator = (const FCounter& i_other) = delete;
+
+			bool IsDone() const { return Pending.load() == 0; }
+
+			std::atomic<uint32_t> Pending{ 0 };
+			std::mutex Mutex;								// Guards Continuations and the step to zero
+			std::vector<FJob> Continuations;				// Jobs waiting for this counter to reach zero
+		};
+
+		// WorkerCount 0 means one worker for every hardware thread except the main thread
+		void Init(uint32_t iWorkerCount = 0);
+		void CleanUp();
+
+		// Workers + main thread, 1 before Init
+		uint32_t GetThreadCount();
+		// Index of the calling thread, 0 for the main thread and any thread not owned by the job system
+		uint32_t GetThreadIndex();
+
+		// Push Function(pData, Begin, End) to the calling thread's ring, pCounter is increased now and decreased once the job finished
+		// Runs it right away when the ring is full
+		void Run(FJobFunction Function, void* pData, size_t Begin, size_t End, FCounter* pCounter = nullptr);
+		// Run the job once Dependency reaches zero, pCounter is increased now so waiting on it covers the deferred job
+		void RunAfter(FCounter& Dependency, FJobFunction Function, void* pData, size_t Begin, size_t End, FCounter* pCounter = nullptr);
+		// Run other jobs until Counter reaches zero
+		void Wait(FCounter& Counter);
+
+		// Split [0, Count) into ranges of at least MinBatchSize and run Function(pData, Begin, End) on them, returns when all ranges are done
+		void ParallelFor(size_t Count, size_t MinBatchSize, FJobFunction Function, void* pData);
+
+		template<typename TFunction>
+		void invokeRange(void* pData, size_t Begin, size_t End)
+		{
+			(*static_cast<const TFunction*>(pData))(Begin, End);
+		}
+
+		// Same as above for any callable taking (Begin, End), it lives on the caller's stack until every range is done
+		template<typename TFunction>
+		void ParallelFor(size_t Count, size_t MinBatchSize, const TFunction& Function)
+		{
+			ParallelFor(Count, MinBatchSize, &invokeRange<TFunction>, const_cast<void*>(static_cast<const void*>(&Function)));
+		}
+	}
+}
@@ -1,7 +1,9 @@
 #include "Emitter.h"
 #include "Utilities.h"
 #include "Texture/Texture.h"
+#include "Material/Material.h"
 #include "Descriptors/Descriptor_Buffer.h"
+#include "Command/UploadContext.h"
 
 namespace VKE
 {
@@ -19,7 +21,6 @@ namespace VKE
 	void cEmitter::init(FMainDevice* const iMainDevice)
 	{
 		ComputeDescriptorSet.pMainDevice = iMainDevice;
-		RenderDescriptorSet.pMainDevice = iMainDevice;
 		// Create storage buffer
 		// Initialize the particle data
 		for (size_t i = 0; i < Particle_Count; ++i)
@@ -28,98 +29,69 @@ namespace VKE
 		}
 		// Create storage buffer
 		VkDeviceSize StorageBufferSize = sizeof(BufferFormats::FParticle) * Particle_Count;
-		cBuffer StagingBuffer;
 
-		if (!StagingBuffer.CreateBufferAndAllocateMemory(iMainDevice->PD, iMainDevice->LD, StorageBufferSize,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT))
+		// Create storage buffers, Binding = 0 and Binding = 3 (created after the uniform buffers)
+		// 1. As transfer destination from staging buffer, 2. As storage buffer storing particle data in compute shader, 3. As vertex data in vertex shader
+		const VkBufferUsageFlags StorageBufferUsage = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+		// Graphic and compute queues read the same buffer at the same time, so no exclusive ownership
+		// A concurrent buffer can't change owner after its upload, the transfer family joins the sharing instead
+		std::vector<uint32_t> SharingQueueFamilies = iMainDevice->GraphicComputeSharingFamilies();
+		const bool bConcurrent = !SharingQueueFamilies.empty();
+		if (bConcurrent && iMainDevice->HasTransferQueue())
 		{
-			return;
+			SharingQueueFamilies.push_back(static_cast<uint32_t>(iMainDevice->QueueFamilyIndices.transferFamily));
 		}
-
-		// Map particle data to the staging buffer
-		void * pData = nullptr;
-		vkMapMemory(iMainDevice->LD, StagingBuffer.GetMemory(), 0, StorageBufferSize, 0, &pData);
-		memcpy(pData, Particles, static_cast<size_t>(StorageBufferSize));
-		vkUnmapMemory(iMainDevice->LD, StagingBuffer.GetMemory());
-
-		// Create storage buffer, Binding = 0
-		ComputeDescriptorSet.CreateStorageBufferDescriptor(StorageBufferSize, 1, VK_SHADER_STAGE_COMPUTE_BIT,
-			// 1. As transfer destination from staging buffer, 2. As storage buffer storing particle data in compute shader, 3. As vertex data in vertex shader
-			VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+		ComputeDescriptorSet.CreateStorageBufferDescriptor(StorageBufferSize, 1, VK_SHADER_STAGE_COMPUTE_BIT, StorageBufferUsage,
 			// Local hosted buffer, need get data from staging buffer 
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, EMemoryCategory::Particle, SharingQueueFamilies
 		);
 
-		// Allocate the transfer command buffer
-		VkCommandBuffer TransferCommandBuffer = BeginCommandBuffer(iMainDevice->LD, iMainDevice->GraphicsCommandPool);
-
-		// Region of data to copy from and to, allows copy multiple regions of data
-		VkBufferCopy BufferCopyRegion = {};
-		BufferCopyRegion.srcOffset = 0;
-		BufferCopyRegion.dstOffset = 0;
-		BufferCopyRegion.size = StorageBufferSize;
-
-		// Command to copy src buffer to dst buffer
-		const cBuffer& StorageBuffer = ComputeDescriptorSet.GetDescriptorAt<cDescriptor_Buffer>(0)->GetBuffer();
-		vkCmdCopyBuffer(TransferCommandBuffer, StagingBuffer.GetvkBuffer(), StorageBuffer.GetvkBuffer(), 1, &BufferCopyRegion);
-		// Setup a barrier when compute queue is not the same as the graphic queue
-		if (iMainDevice->NeedSynchronization())
-		{
-			VkBufferMemoryBarrier Barrier = {};
-			Barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
-			Barrier.srcAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
-			Barrier.dstAccessMask = 0;
-			Barrier.srcQueueFamilyIndex = iMainDevice->QueueFamilyIndices.graphicFamily;
-			Barrier.dstQueueFamilyIndex = iMainDevice->QueueFamilyIndices.computeFamily;
-			Barrier.buffer = StorageBuffer.GetvkBuffer();
-			Barrier.offset = 0;
-			Barrier.size = StorageBufferSize;
-
-			vkCmdPipelineBarrier(TransferCommandBuffer,
-				VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,			// source stage
-				VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,	// destination stage
-				0, nullptr,			// memory
-				1, &Barrier,		// Buffer
-				0, nullptr);		// Image
-		}
-		// Stop the command and submit it to the queue, wait until it finish execution
-		EndCommandBuffer(TransferCommandBuffer, iMainDevice->LD, iMainDevice->graphicQueue, iMainDevice->GraphicsCommandPool);
-
-		// Clean up staging buffer parts
-		StagingBuffer.cleanUp();
-
 		// Create uniform buffer
+		// Both are dynamic with one slot per frame in flight, the CPU writes the slot of the frame it prepares while older frames still read theirs
 
 		// Binding = 1, dt, gravity
-		ComputeDescriptorSet.CreateBufferDescriptor(sizeof(BufferFormats::FParticleSupportData), 1, VK_SHADER_STAGE_COMPUTE_BIT);
+		ComputeDescriptorSet.CreateDynamicBufferDescriptor(sizeof(BufferFormats::FParticleSupportData), MAX_FRAME_DRAWS, VK_SHADER_STAGE_COMPUTE_BIT);
 
 		// Setup initial data
 		ParticleSupportData.dt = 0.0005f;
 		ParticleSupportData.useGravity = false;
-		ComputeDescriptorSet.GetDescriptorAt<cDescriptor_Buffer>(1)->UpdateBufferData(&ParticleSupportData);
 
 		// Binding = 2, emitter data
-		ComputeDescriptorSet.CreateBufferDescriptor(sizeof(BufferFormats::FConeEmitter), 1, VK_SHADER_STAGE_COMPUTE_BIT);
+		ComputeDescriptorSet.CreateDynamicBufferDescriptor(sizeof(BufferFormats::FConeEmitter), MAX_FRAME_DRAWS, VK_SHADER_STAGE_COMPUTE_BIT);
+
+		// Nothing is in flight yet, fill every slot
+		for (uint32_t i = 0; i < MAX_FRAME_DRAWS; ++i)
+		{
+			UpdateUniformBuffers(i);
+		}
+
+		// Binding = 3, second particle buffer
+		ComputeDescriptorSet.CreateStorageBufferDescriptor(StorageBufferSize, 1, VK_SHADER_STAGE_COMPUTE_BIT, StorageBufferUsage,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, EMemoryCategory::Particle, SharingQueueFamilies
+		);
 
-		// Update initial particle data
-		UpdateEmitterData(ComputeDescriptorSet.GetDescriptorAt<cDescriptor_Buffer>(2));
+		// Stage the initial particles for both buffers, whichever is read first starts from them
+		// Copied with the upload context's next batch, compute and graphics submits wait for its token
+		for (uint32_t i = 0; i < ParticleBufferCount; ++i)
+		{
+			iMainDevice->UploadContext->UploadBuffer(GetStorageBuffer(i).GetvkBuffer(), Particles, StorageBufferSize, 0, bConcurrent);
+		}
 
-		// Particle DescriptorSet
+		// Particle material, emitters with the same texture share it
 
 		if (!TextureToUse.get())
 		{
 			printf("Warning: no texture is used in this emitter! Use DefaultWhite texture instead.\n");
 			TextureToUse = cTexture::Get(EDefaultTextureID::White);
 		}
-		cTexture* ParticleTestTex = TextureToUse.get();
-		RenderDescriptorSet.CreateImageBufferDescriptor(&ParticleTestTex->GetImageBuffer(), VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, ParticleTestTex->GetImageInfo().imageLayout, ParticleTestTex->GetImageInfo().sampler);
+		FMaterialDesc MaterialDesc;
+		MaterialDesc.AlbedoTextureID = TextureToUse->GetID() >= 0 ? TextureToUse->GetID() : EDefaultTextureID::White;
+		MaterialID = cMaterial::Load(MaterialDesc)->GetID();
 	}
 
 	void cEmitter::cleanUp()
 	{
 		ComputeDescriptorSet.cleanUp();
-		RenderDescriptorSet.cleanUp();
 	}
 
 	void cEmitter::NextParticle(BufferFormats::FParticle& oParticle)
@@ -162,63 +134,33 @@ namespace VKE
 		oParticle.TileWidth = static_cast<float>(EmitterData.TileWidth);
 	}
 
-	void cEmitter::UpdateEmitterData(cDescriptor_Buffer* Descriptor)
+	void cEmitter::UpdateUniformBuffers(uint32_t FrameIndex)
 	{
-		if (!Descriptor || !bNeedUpdate)
-		{
-			return;
-		}
-
-		Descriptor->UpdateBufferData(&EmitterData);
-		bNeedUpdate = false;
+		// Binding 1 and 2, see init()
+		cDescriptor_Buffer* SupportDataBuffer = ComputeDescriptorSet.GetDescriptorAt<cDescriptor_Buffer>(1);
+		cDescriptor_Buffer* EmitterDataBuffer = ComputeDescriptorSet.GetDescriptorAt<cDescriptor_Buffer>(2);
+		SupportDataBuffer->UpdatePartialData(&ParticleSupportData, SupportDataBuffer->GetSlotSize() * FrameIndex, sizeof(BufferFormats::FParticleSupportData));
+		EmitterDataBuffer->UpdatePartialData(&EmitterData, EmitterDataBuffer->GetSlotSize() * FrameIndex, sizeof(BufferFormats::FConeEmitter));
 	}
 
-	VkBufferMemoryBarrier cEmitter::GraphicOwnBarrier(VkAccessFlags srcMask, VkAccessFlags dstMask) const
+	const cBuffer& cEmitter::GetStorageBuffer(uint32_t BufferIndex) const
 	{
-		FMainDevice* const MainDevice = ComputeDescriptorSet.pMainDevice;
-		const cBuffer& StorageBuffer = GetStorageBuffer();
-		VkBufferMemoryBarrier BufferBarrier = {};
-		BufferBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
-		BufferBarrier.srcAccessMask = srcMask;
-		BufferBarrier.dstAccessMask = dstMask;
-		// Transfer ownership from compute queue to graphic queue
-		BufferBarrier.srcQueueFamilyIndex = MainDevice->QueueFamilyIndices.computeFamily;
-		BufferBarrier.dstQueueFamilyIndex = MainDevice->QueueFamilyIndices.graphicFamily;
-		BufferBarrier.buffer = StorageBuffer.GetvkBuffer();
-		BufferBarrier.offset = 0;
-		BufferBarrier.size = StorageBuffer.BufferSize();
-
-		return BufferBarrier;
+		// Particle buffers are at binding 0 and 3, see init()
+		const uint32_t ParticleBufferBindings[ParticleBufferCount] = { 0, 3 };
+		return ComputeDescriptorSet.GetDescriptorAt_Immutable<cDescriptor_Buffer>(ParticleBufferBindings[BufferIndex])->GetBuffer();
 	}
 
-	VkBufferMemoryBarrier cEmitter::ComputeOwnBarrier(VkAccessFlags srcMask, VkAccessFlags dstMask) const
+	void cEmitter::Dispatch(const VkCommandBuffer& CommandBuffer, const VkPipelineLayout& ComputePipelineLayout, uint32_t FrameIndex, uint32_t SrcBufferIndex)
 	{
-		FMainDevice* const MainDevice = ComputeDescriptorSet.pMainDevice;
-		const cBuffer& StorageBuffer = GetStorageBuffer();
-		VkBufferMemoryBarrier BufferBarrier = {};
-		BufferBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
-		// The storage buffer is used as vertex input
-		BufferBarrier.srcAccessMask = srcMask;
-		BufferBarrier.dstAccessMask = dstMask;
-		// Transfer ownership from graphic queue to compute queue
-		BufferBarrier.srcQueueFamilyIndex = MainDevice->QueueFamilyIndices.graphicFamily;
-		BufferBarrier.dstQueueFamilyIndex = MainDevice->QueueFamilyIndices.computeFamily;
-		BufferBarrier.buffer = StorageBuffer.GetvkBuffer();
-		BufferBarrier.offset = 0;
-		BufferBarrier.size = StorageBuffer.BufferSize();
-
-		return BufferBarrier;
-	}
-
-
-	const cBuffer& cEmitter::GetStorageBuffer() const
-	{
-		return ComputeDescriptorSet.GetDescriptorAt_Immutable<cDescriptor_Buffer>(0)->GetBuffer();
-	}
-
-	void cEmitter::Dispatch(const VkCommandBuffer& CommandBuffer, const VkPipelineLayout& ComputePipelineLayout)
-	{
-		vkCmdBindDescriptorSets(CommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, ComputePipelineLayout, 0, 1, &ComputeDescriptorSet.GetDescriptorSet(), 0, 0);
+		// Dynamic offsets of binding 1 and 2, in binding order
+		const uint32_t DynamicOffsets[] =
+		{
+			static_cast<uint32_t>(ComputeDescriptorSet.GetDescriptorAt<cDescriptor_Buffer>(1)->GetSlotSize() * FrameIndex),
+			static_cast<uint32_t>(ComputeDescriptorSet.GetDescriptorAt<cDescriptor_Buffer>(2)->GetSlotSize() * FrameIndex),
+		};
+		vkCmdBindDescriptorSets(CommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, ComputePipelineLayout, 0, 1, &ComputeDescriptorSet.GetDescriptorSet(), 2, DynamicOffsets);
+		// Tell the shader which buffer to read from, the other one is written
+		vkCmdPushConstants(CommandBuffer, ComputePipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(uint32_t), &SrcBufferIndex);
 		vkCmdDispatch(CommandBuffer, Particle_Count / Dispatch_Size_X, 1, 1);
 	}
 
@@ -23,23 +23,24 @@ namespace VKE
 		BufferFormats::FParticle Particles[Particle_Count];
 		BufferFormats::FParticleSupportData ParticleSupportData;				// Including deltaTime, will add in the future
 		std::shared_ptr<cTexture> TextureToUse;									// Texture to use in this emitter
+		uint32_t MaterialID = 0;												// Material of TextureToUse, set in init
 		cTransform Transform;
 		BufferFormats::FConeEmitter EmitterData;
-		bool bNeedUpdate = true;
 
-		cDescriptorSet ComputeDescriptorSet;		// Used in compute shader Storage buffer, uniform buffer
-		cDescriptorSet RenderDescriptorSet;			// Used in vertex / fragment shader when rendering, currently is for sampler
+		cDescriptorSet ComputeDescriptorSet;		// Used in compute shader, two ping-pong storage buffers and uniform buffers
 
 		void NextParticle(BufferFormats::FParticle& oParticle);
-		void UpdateEmitterData(cDescriptor_Buffer* Descriptor);
-		/** Graphic queue acquires ownership of this storage buffer */
-		VkBufferMemoryBarrier GraphicOwnBarrier( VkAccessFlags srcMask, VkAccessFlags dstMask) const;
-		/** Compute queue acquires ownership of this storage buffer */
-		VkBufferMemoryBarrier ComputeOwnBarrier(VkAccessFlags srcMask, VkAccessFlags dstMask) const;
+		// ParticleSupportData / EmitterData have one dynamic uniform slot per frame in flight, a slot is only written
+		// once the frame slot's previous dispatch is complete, unchanged data is skipped
+		void UpdateUniformBuffers(uint32_t FrameIndex);
 
-		const cBuffer& GetStorageBuffer() const;
+		// Particles are double buffered, compute reads one buffer and writes the other while graphics draws the one being read
+		// Both buffers are shared concurrently by graphic and compute queue families, timeline semaphores order the accesses
+		static const uint32_t ParticleBufferCount = 2;
+		const cBuffer& GetStorageBuffer(uint32_t BufferIndex) const;
 
-		void Dispatch(const VkCommandBuffer& CommandBuffer, const VkPipelineLayout& ComputePipelineLayout);
+		// Simulate from buffer SrcBufferIndex into the other buffer, with the uniform data of frame slot FrameIndex
+		void Dispatch(const VkCommandBuffer& CommandBuffer, const VkPipelineLayout& ComputePipelineLayout, uint32_t FrameIndex, uint32_t SrcBufferIndex);
 	private:
 		
 	};
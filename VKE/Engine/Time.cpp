@@ -1,9 +1,121 @@
 #include "Time.h"
+
+#include <chrono>
+#include <cmath>
+#include <thread>
 namespace VKE
 {
 	namespace Time
 	{
 		double DT;
+		FFrameTimeCounter FrameTimeCounter;
+		FFixedStepClock SimulationClock;
+		FFramePacer FramePacer;
+
+		double Now()
+		{
+			using namespace std::chrono;
+			return duration_cast<duration<double>>(steady_clock::now().time_since_epoch()).count();
+		}
+
+		void FFrameTimeCounter::Update(double iFrameTime, double iDrawTime, double iFenceWaitTime)
+		{
+			// Smooth over roughly the last 20 frames
+			const double SmoothFactor = 0.05;
+			FrameTime = iFrameTime * 1000.0;
+			AverageFrameTime = (AverageFrameTime == 0.0) ? FrameTime : AverageFrameTime + (FrameTime - AverageFrameTime) * SmoothFactor;
+			FenceWaitTime = iFenceWaitTime * 1000.0;
+			DrawCPUTime = (iDrawTime - iFenceWaitTime) * 1000.0;
+		}
+
+		void FFixedStepClock::SetStepRate(double iStepsPerSecond)
+		{
+			if (iStepsPerSecond > 0.0)
+			{
+				StepTime = 1.0 / iStepsPerSecond;
+			}
+		}
+
+		uint32_t FFixedStepClock::Advance(double iFrameTime)
+		{
+			Accumulator += iFrameTime;
+
+			uint32_t Steps = 0;
+			while (Accumulator >= StepTime && Steps < MaxStepsPerFrame)
+			{
+				Accumulator -= StepTime;
+				++Steps;
+			}
+			// Too far behind, drop whole steps instead of simulating them next frame
+			if (Accumulator >= StepTime)
+			{
+				const double Dropped = Accumulator - fmod(Accumulator, StepTime);
+				DroppedTime += Dropped;
+				Accumulator -= Dropped;
+			}
+
+			Alpha = Accumulator / StepTime;
+			StepsThisFrame = Steps;
+			TotalSteps += Steps;
+			return Steps;
+		}
+
+		void FFramePacer::WaitForNextFrame()
+		{
+			const double Start = Now();
+			if (TargetFPS <= 0.0)
+			{
+				NextFrameTime = 0.0;
+				LimiterSleep = 0.0;
+				return;
+			}
+			const double Interval = 1.0 / TargetFPS;
+			// First limited frame or more than a frame behind, restart the schedule instead of bursting to catch up
+			if (NextFrameTime == 0.0 || Start > NextFrameTime + Interval)
+			{
+				NextFrameTime = Start;
+			}
+
+			// 1. Coarse sleep, the OS may oversleep by about a millisecond
+			// 2. Spin the remaining time so the frame starts right at the deadline
+			double Remaining = NextFrameTime - Start;
+			while (Remaining > 0.0)
+			{
+				if (Remaining > SpinThreshold)
+				{
+					std::this_thread::sleep_for(std::chrono::duration<double>(Remaining - SpinThreshold));
+				}
+				else
+				{
+					std::this_thread::yield();
+				}
+				Remaining = NextFrameTime - Now();
+			}
+			NextFrameTime += Interval;
+			LimiterSleep = (Now() - Start) * 1000.0;
+		}
+
+		void FFramePacer::MarkInput()
+		{
+			InputTime = Now();
+		}
+
+		void FFramePacer::MarkSubmit()
+		{
+			// Smooth over roughly the last 20 frames, same as the frame time counter
+			const double SmoothFactor = 0.05;
+			SubmitTime = Now();
+			const double Latency = (SubmitTime - InputTime) * 1000.0;
+			InputToSubmit = (InputToSubmit == 0.0) ? Latency : InputToSubmit + (Latency - InputToSubmit) * SmoothFactor;
+		}
+
+		void FFramePacer::MarkPresent()
+		{
+			const double SmoothFactor = 0.05;
+			PresentTime = Now();
+			const double Latency = (PresentTime - InputTime) * 1000.0;
+			InputToPresent = (InputToPresent == 0.0) ? Latency : InputToPresent + (Latency - InputToPresent) * SmoothFactor;
+		}
 	}
 	
-}
\ No newline at end of file
+}
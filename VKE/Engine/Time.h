@@ -1,10 +1,69 @@
 #pragma once
+#include <stdint.h>
 
 namespace VKE
 {
 	namespace Time
 	{
 		extern double DT;
+
+		// Seconds since an arbitrary point, does not need GLFW to be initialized (headless mode has no window)
+		double Now();
+
+		// Frame timing statistics in milliseconds, updated once per rendered frame
+		struct FFrameTimeCounter
+		{
+			double FrameTime = 0.0;					// Wall-clock time between two rendered frames
+			double AverageFrameTime = 0.0;			// Exponential moving average of FrameTime
+			double DrawCPUTime = 0.0;				// Time spent in VKRenderer::draw, excluding FenceWaitTime
+			double FenceWaitTime = 0.0;				// Time blocked on the fence of the frame slot being reused
+
+			void Update(double iFrameTime, double iDrawTime, double iFenceWaitTime);
+		};
+		extern FFrameTimeCounter FrameTimeCounter;
+
+		// Fixed-step simulation clock, each rendered frame runs 0..MaxStepsPerFrame steps of StepTime seconds
+		struct FFixedStepClock
+		{
+			double StepTime = 1.0 / 60.0;			// Seconds simulated by one step
+			uint32_t MaxStepsPerFrame = 5;			// Catch-up limit, time beyond it is dropped so slow frames can't spiral
+			double Accumulator = 0.0;				// Wall-clock time not simulated yet, less than StepTime after Advance
+			double Alpha = 0.0;						// Accumulator / StepTime, blend factor between the last two steps for rendering
+			uint32_t StepsThisFrame = 0;
+			uint64_t TotalSteps = 0;
+			double DroppedTime = 0.0;				// Total time discarded by the catch-up limit
+
+			void SetStepRate(double iStepsPerSecond);
+			// Accumulate a frame's wall-clock time and return how many steps should run this frame
+			uint32_t Advance(double iFrameTime);
+		};
+		extern FFixedStepClock SimulationClock;
+
+		// Frame pacing, optional frame rate limiter and CPU timestamps of a frame from input sampling to present
+		struct FFramePacer
+		{
+			double TargetFPS = 0.0;					// 0 means unlimited
+			double SpinThreshold = 0.002;			// Stop sleeping this many seconds before the deadline and spin, covers OS sleep granularity
+
+			// Timestamps of the latest frame in seconds (Time::Now)
+			double InputTime = 0.0;					// Right before glfwPollEvents
+			double SubmitTime = 0.0;				// After the graphics submit returned
+			double PresentTime = 0.0;				// After vkQueuePresentKHR returned
+
+			// Milliseconds, latency values are exponential moving averages
+			double InputToSubmit = 0.0;
+			double InputToPresent = 0.0;
+			double LimiterSleep = 0.0;				// Time the limiter blocked before the latest frame
+
+			// Block until the next frame is due, call right before sampling input so the sampled input is as fresh as possible
+			void WaitForNextFrame();
+			void MarkInput();
+			void MarkSubmit();
+			void MarkPresent();
+		private:
+			double NextFrameTime = 0.0;				// Earliest start of the next frame
+		};
+		extern FFramePacer FramePacer;
 	}
 	
-}
\ No newline at end of file
+}
@@ -87,6 +87,28 @@ void cTransform::SetTransform(const glm::vec3 & i_initialTranslation, const glm:
 	m_scale = i_initialScale;
 
 	Update();
+	// Teleport, nothing to blend from
+	SavePrevious();
+}
+
+void cTransform::SavePrevious()
+{
+	m_prevPosition = m_position;
+	m_prevRotation = m_rotation;
+	m_prevScale = m_scale;
+}
+
+glm::mat4 cTransform::Interpolate(float i_alpha) const
+{
+	const glm::vec3 _position = glm::mix(m_prevPosition, m_position, i_alpha);
+	const glm::quat _rotation = glm::slerp(m_prevRotation, m_rotation, i_alpha);
+	const glm::vec3 _scale = glm::mix(m_prevScale, m_scale, i_alpha);
+
+	glm::mat4 _t = glm::mat4(1.0);
+	_t[3] = glm::vec4(_position, 1);
+	glm::mat4 _s = glm::mat4(1.0);
+	_s[0][0] = _scale.x; _s[1][1] = _scale.y; _s[2][2] = _scale.z;
+	return _t * glm::toMat4(_rotation) * _s;
 }
 
 
@@ -33,6 +33,11 @@ public:
 
 	void MirrorAlongPlane(const cTransform& i_other);
 
+	// Fixed-step interpolation: keep the state before a simulation step changes it
+	void SavePrevious();
+	// Model matrix blended from the previous to the current state, i_alpha in [0, 1]
+	glm::mat4 Interpolate(float i_alpha) const;
+
 	/** Setters */
 	void SetTransform(const glm::vec3& i_initialTranslation, const glm::quat& i_intialRotation, const glm::vec3& i_initialScale);
 	void SetRotation(const glm::quat& i_rotation) { m_rotation = i_rotation; }
@@ -72,5 +77,10 @@ private:
 	glm::vec3 m_position = glm::vec3(0.0f, 0.0f, 0.0f);
 	glm::quat m_rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
 	glm::vec3 m_scale = glm::vec3(1.0f, 1.0f, 1.0f);
+
+	// State of the previous simulation step
+	glm::vec3 m_prevPosition = glm::vec3(0.0f, 0.0f, 0.0f);
+	glm::quat m_prevRotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+	glm::vec3 m_prevScale = glm::vec3(1.0f, 1.0f, 1.0f);
 };
 
@@ -4,10 +4,16 @@
 
 #include "../Engine/Engine.h"
 
-int main()
+int main(int argc, char* argv[])
 {
+	VKE::FLaunchOptions Options;
+	if (!VKE::ParseLaunchOptions(argc, argv, Options))
+	{
+		return EXIT_FAILURE;
+	}
+
 	int exitCode = 0;
-	exitCode = VKE::init();
+	exitCode = VKE::init(Options);
 	if (exitCode == EXIT_FAILURE) 
 	{
 		return exitCode;